@@ -15,12 +15,27 @@ extern "C" {
 // Forward declaration
 struct Sass_Compiler;
 
+// Forward declaration
+struct Sass_Stylesheet_Cache;
+
+// Forward declaration
+struct Sass_Directory_Cache;
+
+// Forward declaration
+struct Sass_Session;
+
+// Forward declaration
+struct Sass_Batch_Compiler;
+
 // Forward declaration
 struct Sass_Options; // base struct
 struct Sass_Context; // : Sass_Options
 struct Sass_File_Context; // : Sass_Context
 struct Sass_Data_Context; // : Sass_Context
 
+// Receives the css output in chunks while it is rendered
+typedef void (*Sass_Output_Sink) (const char* data, size_t length, void* cookie);
+
 // Compiler states
 enum Sass_Compiler_State {
   SASS_COMPILER_CREATED,
@@ -77,6 +92,12 @@ ADDAPI bool ADDCALL sass_option_get_source_map_contents (struct Sass_Options* op
 ADDAPI bool ADDCALL sass_option_get_source_map_file_urls (struct Sass_Options* options);
 ADDAPI bool ADDCALL sass_option_get_omit_source_map_url (struct Sass_Options* options);
 ADDAPI bool ADDCALL sass_option_get_is_indented_syntax_src (struct Sass_Options* options);
+ADDAPI int ADDCALL sass_option_get_import_threads (struct Sass_Options* options);
+ADDAPI bool ADDCALL sass_option_get_map_source_files (struct Sass_Options* options);
+ADDAPI struct Sass_Stylesheet_Cache* ADDCALL sass_option_get_stylesheet_cache (struct Sass_Options* options);
+ADDAPI struct Sass_Directory_Cache* ADDCALL sass_option_get_directory_cache (struct Sass_Options* options);
+ADDAPI Sass_Output_Sink ADDCALL sass_option_get_output_sink (struct Sass_Options* options);
+ADDAPI void* ADDCALL sass_option_get_output_sink_cookie (struct Sass_Options* options);
 ADDAPI const char* ADDCALL sass_option_get_indent (struct Sass_Options* options);
 ADDAPI const char* ADDCALL sass_option_get_linefeed (struct Sass_Options* options);
 ADDAPI const char* ADDCALL sass_option_get_input_path (struct Sass_Options* options);
@@ -96,6 +117,12 @@ ADDAPI void ADDCALL sass_option_set_source_map_contents (struct Sass_Options* op
 ADDAPI void ADDCALL sass_option_set_source_map_file_urls (struct Sass_Options* options, bool source_map_file_urls);
 ADDAPI void ADDCALL sass_option_set_omit_source_map_url (struct Sass_Options* options, bool omit_source_map_url);
 ADDAPI void ADDCALL sass_option_set_is_indented_syntax_src (struct Sass_Options* options, bool is_indented_syntax_src);
+ADDAPI void ADDCALL sass_option_set_import_threads (struct Sass_Options* options, int import_threads);
+ADDAPI void ADDCALL sass_option_set_map_source_files (struct Sass_Options* options, bool map_source_files);
+ADDAPI void ADDCALL sass_option_set_stylesheet_cache (struct Sass_Options* options, struct Sass_Stylesheet_Cache* stylesheet_cache);
+ADDAPI void ADDCALL sass_option_set_directory_cache (struct Sass_Options* options, struct Sass_Directory_Cache* directory_cache);
+ADDAPI void ADDCALL sass_option_set_output_sink (struct Sass_Options* options, Sass_Output_Sink output_sink);
+ADDAPI void ADDCALL sass_option_set_output_sink_cookie (struct Sass_Options* options, void* output_sink_cookie);
 ADDAPI void ADDCALL sass_option_set_indent (struct Sass_Options* options, const char* indent);
 ADDAPI void ADDCALL sass_option_set_linefeed (struct Sass_Options* options, const char* linefeed);
 ADDAPI void ADDCALL sass_option_set_input_path (struct Sass_Options* options, const char* input_path);
@@ -153,6 +180,61 @@ ADDAPI size_t ADDCALL sass_compiler_get_callee_stack_size(struct Sass_Compiler*
 ADDAPI Sass_Callee_Entry ADDCALL sass_compiler_get_last_callee(struct Sass_Compiler* compiler);
 ADDAPI Sass_Callee_Entry ADDCALL sass_compiler_get_callee_entry(struct Sass_Compiler* compiler, size_t idx);
 
+// Getters for memory statistics of the compiler's arena (bytes currently
+// in use, peak bytes in use and number of arenas). They are only collected
+// if LibSass was compiled with `SASS_CUSTOM_ALLOCATOR`, otherwise zero.
+ADDAPI size_t ADDCALL sass_compiler_get_alloc_bytes(struct Sass_Compiler* compiler);
+ADDAPI size_t ADDCALL sass_compiler_get_alloc_peak(struct Sass_Compiler* compiler);
+ADDAPI size_t ADDCALL sass_compiler_get_alloc_arenas(struct Sass_Compiler* compiler);
+
+// Cache for parsed stylesheets, to be shared between contexts via the
+// `stylesheet_cache` option (keeps at most `max_sheets` parsed trees,
+// a stylesheet has one tree for every compiler that uses it at once).
+// Must outlive all compilers using it, it is not owned by the options.
+ADDAPI struct Sass_Stylesheet_Cache* ADDCALL sass_make_stylesheet_cache (size_t max_sheets);
+ADDAPI void ADDCALL sass_delete_stylesheet_cache (struct Sass_Stylesheet_Cache* cache);
+// Getters for cache statistics (lookups that were found or not found)
+ADDAPI size_t ADDCALL sass_stylesheet_cache_get_hits (struct Sass_Stylesheet_Cache* cache);
+ADDAPI size_t ADDCALL sass_stylesheet_cache_get_misses (struct Sass_Stylesheet_Cache* cache);
+ADDAPI size_t ADDCALL sass_stylesheet_cache_get_size (struct Sass_Stylesheet_Cache* cache);
+
+// Cache for directory listings used to resolve imports. Every compilation
+// has its own one, unless one is shared via the `directory_cache` option.
+// Must outlive all compilers using it, it is not owned by the options.
+ADDAPI struct Sass_Directory_Cache* ADDCALL sass_make_directory_cache (void);
+ADDAPI void ADDCALL sass_delete_directory_cache (struct Sass_Directory_Cache* cache);
+// Forget all listings, needed once files were added or removed
+ADDAPI void ADDCALL sass_directory_cache_clear (struct Sass_Directory_Cache* cache);
+// Getters for cache statistics (existence checks and filesystem calls made)
+ADDAPI size_t ADDCALL sass_directory_cache_get_lookups (struct Sass_Directory_Cache* cache);
+ADDAPI size_t ADDCALL sass_directory_cache_get_fs_calls (struct Sass_Directory_Cache* cache);
+
+// Session to compile the same entry points again after files changed. It
+// reuses the output of entry points whose imported files are all unchanged
+// and the parsed stylesheets (at most `max_sheets`) of all unchanged files.
+ADDAPI struct Sass_Session* ADDCALL sass_make_session (size_t max_sheets);
+ADDAPI void ADDCALL sass_delete_session (struct Sass_Session* session);
+// Like `sass_compile_file_context`, the context must not be compiled yet
+ADDAPI int ADDCALL sass_session_compile_file_context (struct Sass_Session* session, struct Sass_File_Context* ctx);
+// Report a file that was modified, added or removed since the last compile
+ADDAPI void ADDCALL sass_session_file_changed (struct Sass_Session* session, const char* path);
+// Getters for session statistics (entry points compiled or reused)
+ADDAPI size_t ADDCALL sass_session_get_compiled (struct Sass_Session* session);
+ADDAPI size_t ADDCALL sass_session_get_reused (struct Sass_Session* session);
+
+// Compiles `count` entry points with the same options (can be NULL), which
+// are owned and deleted by the batch compiler. Every entry point gets its
+// own file context, sharing the parsed stylesheets and directory listings.
+// Returns NULL (after deleting the options) if it runs out of memory.
+ADDAPI struct Sass_Batch_Compiler* ADDCALL sass_make_batch_compiler (const char* const* entries, size_t count, struct Sass_Options* options);
+ADDAPI void ADDCALL sass_delete_batch_compiler (struct Sass_Batch_Compiler* batch);
+// Compile all entry points once on `threads` threads (0 = one per core)
+// Returns the number of entry points that failed to compile
+ADDAPI size_t ADDCALL sass_batch_compiler_execute (struct Sass_Batch_Compiler* batch, int threads);
+// Getters for the file context of every entry point (owned by the batch)
+ADDAPI size_t ADDCALL sass_batch_compiler_get_count (struct Sass_Batch_Compiler* batch);
+ADDAPI struct Sass_File_Context* ADDCALL sass_batch_compiler_get_context (struct Sass_Batch_Compiler* batch, size_t idx);
+
 // Push function for paths (no manipulation support for now)
 ADDAPI void ADDCALL sass_option_push_plugin_path (struct Sass_Options* options, const char* path);
 ADDAPI void ADDCALL sass_option_push_include_path (struct Sass_Options* options, const char* path);
@@ -6,8 +6,6 @@
 
 namespace Sass {
 
-  static Null sass_null(SourceSpan("null"));
-
   const char* sass_op_to_name(enum Sass_OP op) {
     switch (op) {
       case AND: return "and";
@@ -55,7 +53,8 @@ namespace Sass {
 
   void AST_Node::update_pstate(const SourceSpan& pstate)
   {
-    pstate_.offset += pstate.position - pstate_.position + pstate.offset;
+    // extend up to the end of the given state
+    pstate_.length = pstate.position + pstate.length - pstate_.position;
   }
 
   sass::string AST_Node::to_string(Sass_Inspect_Options opt) const
@@ -91,13 +90,13 @@ namespace Sass {
 
   Statement::Statement(SourceSpan pstate, Type st, size_t t)
   : AST_Node(pstate), statement_type_(st), tabs_(t), group_end_(false)
-  { }
+  { tag_ = Statement_Tag; }
   Statement::Statement(const Statement* ptr)
   : AST_Node(ptr),
     statement_type_(ptr->statement_type_),
     tabs_(ptr->tabs_),
     group_end_(ptr->group_end_)
-  { }
+  { tag_ = Statement_Tag; }
 
   bool Statement::bubbles()
   {
@@ -121,12 +120,12 @@ namespace Sass {
   : Statement(pstate),
     Vectorized<Statement_Obj>(s),
     is_root_(r)
-  { }
+  { tag_ = Block_Tag; }
   Block::Block(const Block* ptr)
   : Statement(ptr),
     Vectorized<Statement_Obj>(*ptr),
     is_root_(ptr->is_root_)
-  { }
+  { tag_ = Block_Tag; }
 
   bool Block::isInvisible() const
   {
@@ -149,10 +148,10 @@ namespace Sass {
 
   ParentStatement::ParentStatement(SourceSpan pstate, Block_Obj b)
   : Statement(pstate), block_(b)
-  { }
+  { tag_ = ParentStatement_Tag; }
   ParentStatement::ParentStatement(const ParentStatement* ptr)
   : Statement(ptr), block_(ptr->block_)
-  { }
+  { tag_ = ParentStatement_Tag; }
 
   bool ParentStatement::has_content()
   {
@@ -164,13 +163,13 @@ namespace Sass {
 
   StyleRule::StyleRule(SourceSpan pstate, SelectorListObj s, Block_Obj b)
   : ParentStatement(pstate, b), selector_(s), schema_(), is_root_(false)
-  { statement_type(RULESET); }
+  { tag_ = StyleRule_Tag; statement_type(RULESET); }
   StyleRule::StyleRule(const StyleRule* ptr)
   : ParentStatement(ptr),
     selector_(ptr->selector_),
     schema_(ptr->schema_),
     is_root_(ptr->is_root_)
-  { statement_type(RULESET); }
+  { tag_ = StyleRule_Tag; statement_type(RULESET); }
 
   bool StyleRule::is_invisible() const {
     if (const SelectorList * sl = Cast<SelectorList>(selector())) {
@@ -185,12 +184,12 @@ namespace Sass {
 
   Bubble::Bubble(SourceSpan pstate, Statement_Obj n, Statement_Obj g, size_t t)
   : Statement(pstate, Statement::BUBBLE, t), node_(n), group_end_(g == nullptr)
-  { }
+  { tag_ = Bubble_Tag; }
   Bubble::Bubble(const Bubble* ptr)
   : Statement(ptr),
     node_(ptr->node_),
     group_end_(ptr->group_end_)
-  { }
+  { tag_ = Bubble_Tag; }
 
   bool Bubble::bubbles()
   {
@@ -202,25 +201,25 @@ namespace Sass {
 
   Trace::Trace(SourceSpan pstate, sass::string n, Block_Obj b, char type)
   : ParentStatement(pstate, b), type_(type), name_(n)
-  { }
+  { tag_ = Trace_Tag; }
   Trace::Trace(const Trace* ptr)
   : ParentStatement(ptr),
     type_(ptr->type_),
     name_(ptr->name_)
-  { }
+  { tag_ = Trace_Tag; }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   AtRule::AtRule(SourceSpan pstate, sass::string kwd, SelectorListObj sel, Block_Obj b, ExpressionObj val)
   : ParentStatement(pstate, b), keyword_(kwd), selector_(sel), value_(val) // set value manually if needed
-  { statement_type(DIRECTIVE); }
+  { tag_ = AtRule_Tag; statement_type(DIRECTIVE); }
   AtRule::AtRule(const AtRule* ptr)
   : ParentStatement(ptr),
     keyword_(ptr->keyword_),
     selector_(ptr->selector_),
     value_(ptr->value_) // set value manually if needed
-  { statement_type(DIRECTIVE); }
+  { tag_ = AtRule_Tag; statement_type(DIRECTIVE); }
 
   bool AtRule::bubbles() { return is_keyframes() || is_media(); }
 
@@ -242,17 +241,17 @@ namespace Sass {
 
   Keyframe_Rule::Keyframe_Rule(SourceSpan pstate, Block_Obj b)
   : ParentStatement(pstate, b), name_()
-  { statement_type(KEYFRAMERULE); }
+  { tag_ = Keyframe_Rule_Tag; statement_type(KEYFRAMERULE); }
   Keyframe_Rule::Keyframe_Rule(const Keyframe_Rule* ptr)
   : ParentStatement(ptr), name_(ptr->name_)
-  { statement_type(KEYFRAMERULE); }
+  { tag_ = Keyframe_Rule_Tag; statement_type(KEYFRAMERULE); }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   Declaration::Declaration(SourceSpan pstate, String_Obj prop, ExpressionObj val, bool i, bool c, Block_Obj b)
   : ParentStatement(pstate, b), property_(prop), value_(val), is_important_(i), is_custom_property_(c), is_indented_(false)
-  { statement_type(DECLARATION); }
+  { tag_ = Declaration_Tag; statement_type(DECLARATION); }
   Declaration::Declaration(const Declaration* ptr)
   : ParentStatement(ptr),
     property_(ptr->property_),
@@ -260,7 +259,7 @@ namespace Sass {
     is_important_(ptr->is_important_),
     is_custom_property_(ptr->is_custom_property_),
     is_indented_(ptr->is_indented_)
-  { statement_type(DECLARATION); }
+  { tag_ = Declaration_Tag; statement_type(DECLARATION); }
 
   bool Declaration::is_invisible() const
   {
@@ -272,15 +271,15 @@ namespace Sass {
   /////////////////////////////////////////////////////////////////////////
 
   Assignment::Assignment(SourceSpan pstate, sass::string var, ExpressionObj val, bool is_default, bool is_global)
-  : Statement(pstate), variable_(var), value_(val), is_default_(is_default), is_global_(is_global)
-  { statement_type(ASSIGNMENT); }
+  : Statement(pstate), key_(var), value_(val), is_default_(is_default), is_global_(is_global)
+  { tag_ = Assignment_Tag; statement_type(ASSIGNMENT); }
   Assignment::Assignment(const Assignment* ptr)
   : Statement(ptr),
-    variable_(ptr->variable_),
+    key_(ptr->key_),
     value_(ptr->value_),
     is_default_(ptr->is_default_),
     is_global_(ptr->is_global_)
-  { statement_type(ASSIGNMENT); }
+  { tag_ = Assignment_Tag; statement_type(ASSIGNMENT); }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
@@ -290,13 +289,13 @@ namespace Sass {
     urls_(sass::vector<ExpressionObj>()),
     incs_(sass::vector<Include>()),
     import_queries_()
-  { statement_type(IMPORT); }
+  { tag_ = Import_Tag; statement_type(IMPORT); }
   Import::Import(const Import* ptr)
   : Statement(ptr),
     urls_(ptr->urls_),
     incs_(ptr->incs_),
     import_queries_(ptr->import_queries_)
-  { statement_type(IMPORT); }
+  { tag_ = Import_Tag; statement_type(IMPORT); }
 
   sass::vector<Include>& Import::incs() { return incs_; }
   sass::vector<ExpressionObj>& Import::urls() { return urls_; }
@@ -306,10 +305,10 @@ namespace Sass {
 
   Import_Stub::Import_Stub(SourceSpan pstate, Include res)
   : Statement(pstate), resource_(res)
-  { statement_type(IMPORT_STUB); }
+  { tag_ = Import_Stub_Tag; statement_type(IMPORT_STUB); }
   Import_Stub::Import_Stub(const Import_Stub* ptr)
   : Statement(ptr), resource_(ptr->resource_)
-  { statement_type(IMPORT_STUB); }
+  { tag_ = Import_Stub_Tag; statement_type(IMPORT_STUB); }
   Include Import_Stub::resource() { return resource_; };
   sass::string Import_Stub::imp_path() { return resource_.imp_path; };
   sass::string Import_Stub::abs_path() { return resource_.abs_path; };
@@ -319,42 +318,42 @@ namespace Sass {
 
   WarningRule::WarningRule(SourceSpan pstate, ExpressionObj msg)
   : Statement(pstate), message_(msg)
-  { statement_type(WARNING); }
+  { tag_ = WarningRule_Tag; statement_type(WARNING); }
   WarningRule::WarningRule(const WarningRule* ptr)
   : Statement(ptr), message_(ptr->message_)
-  { statement_type(WARNING); }
+  { tag_ = WarningRule_Tag; statement_type(WARNING); }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   ErrorRule::ErrorRule(SourceSpan pstate, ExpressionObj msg)
   : Statement(pstate), message_(msg)
-  { statement_type(ERROR); }
+  { tag_ = ErrorRule_Tag; statement_type(ERROR); }
   ErrorRule::ErrorRule(const ErrorRule* ptr)
   : Statement(ptr), message_(ptr->message_)
-  { statement_type(ERROR); }
+  { tag_ = ErrorRule_Tag; statement_type(ERROR); }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   DebugRule::DebugRule(SourceSpan pstate, ExpressionObj val)
   : Statement(pstate), value_(val)
-  { statement_type(DEBUGSTMT); }
+  { tag_ = DebugRule_Tag; statement_type(DEBUGSTMT); }
   DebugRule::DebugRule(const DebugRule* ptr)
   : Statement(ptr), value_(ptr->value_)
-  { statement_type(DEBUGSTMT); }
+  { tag_ = DebugRule_Tag; statement_type(DEBUGSTMT); }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   Comment::Comment(SourceSpan pstate, String_Obj txt, bool is_important)
   : Statement(pstate), text_(txt), is_important_(is_important)
-  { statement_type(COMMENT); }
+  { tag_ = Comment_Tag; statement_type(COMMENT); }
   Comment::Comment(const Comment* ptr)
   : Statement(ptr),
     text_(ptr->text_),
     is_important_(ptr->is_important_)
-  { statement_type(COMMENT); }
+  { tag_ = Comment_Tag; statement_type(COMMENT); }
 
   bool Comment::is_invisible() const
   {
@@ -366,12 +365,12 @@ namespace Sass {
 
   If::If(SourceSpan pstate, ExpressionObj pred, Block_Obj con, Block_Obj alt)
   : ParentStatement(pstate, con), predicate_(pred), alternative_(alt)
-  { statement_type(IF); }
+  { tag_ = If_Tag; statement_type(IF); }
   If::If(const If* ptr)
   : ParentStatement(ptr),
     predicate_(ptr->predicate_),
     alternative_(ptr->alternative_)
-  { statement_type(IF); }
+  { tag_ = If_Tag; statement_type(IF); }
 
   bool If::has_content()
   {
@@ -385,54 +384,55 @@ namespace Sass {
       sass::string var, ExpressionObj lo, ExpressionObj hi, Block_Obj b, bool inc)
   : ParentStatement(pstate, b),
     variable_(var), lower_bound_(lo), upper_bound_(hi), is_inclusive_(inc)
-  { statement_type(FOR); }
+  { tag_ = ForRule_Tag; statement_type(FOR); }
   ForRule::ForRule(const ForRule* ptr)
   : ParentStatement(ptr),
     variable_(ptr->variable_),
     lower_bound_(ptr->lower_bound_),
     upper_bound_(ptr->upper_bound_),
     is_inclusive_(ptr->is_inclusive_)
-  { statement_type(FOR); }
+  { tag_ = ForRule_Tag; statement_type(FOR); }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   EachRule::EachRule(SourceSpan pstate, sass::vector<sass::string> vars, ExpressionObj lst, Block_Obj b)
   : ParentStatement(pstate, b), variables_(vars), list_(lst)
-  { statement_type(EACH); }
+  { tag_ = EachRule_Tag; statement_type(EACH); }
   EachRule::EachRule(const EachRule* ptr)
   : ParentStatement(ptr), variables_(ptr->variables_), list_(ptr->list_)
-  { statement_type(EACH); }
+  { tag_ = EachRule_Tag; statement_type(EACH); }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   WhileRule::WhileRule(SourceSpan pstate, ExpressionObj pred, Block_Obj b)
   : ParentStatement(pstate, b), predicate_(pred)
-  { statement_type(WHILE); }
+  { tag_ = WhileRule_Tag; statement_type(WHILE); }
   WhileRule::WhileRule(const WhileRule* ptr)
   : ParentStatement(ptr), predicate_(ptr->predicate_)
-  { statement_type(WHILE); }
+  { tag_ = WhileRule_Tag; statement_type(WHILE); }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   Return::Return(SourceSpan pstate, ExpressionObj val)
   : Statement(pstate), value_(val)
-  { statement_type(RETURN); }
+  { tag_ = Return_Tag; statement_type(RETURN); }
   Return::Return(const Return* ptr)
   : Statement(ptr), value_(ptr->value_)
-  { statement_type(RETURN); }
+  { tag_ = Return_Tag; statement_type(RETURN); }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
     ExtendRule::ExtendRule(SourceSpan pstate, SelectorListObj s)
   : Statement(pstate), isOptional_(false), selector_(s), schema_()
-  { statement_type(EXTEND); }
+  { tag_ = ExtendRule_Tag; statement_type(EXTEND); }
   ExtendRule::ExtendRule(SourceSpan pstate, Selector_Schema_Obj s)
     : Statement(pstate), isOptional_(false), selector_(), schema_(s)
   {
+    tag_ = ExtendRule_Tag;
     statement_type(EXTEND);
   }
   ExtendRule::ExtendRule(const ExtendRule* ptr)
@@ -440,14 +440,14 @@ namespace Sass {
     isOptional_(ptr->isOptional_),
     selector_(ptr->selector_),
     schema_(ptr->schema_)
-  { statement_type(EXTEND); }
+  { tag_ = ExtendRule_Tag; statement_type(EXTEND); }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   Definition::Definition(const Definition* ptr)
   : ParentStatement(ptr),
-    name_(ptr->name_),
+    key_(ptr->key_),
     parameters_(ptr->parameters_),
     environment_(ptr->environment_),
     type_(ptr->type_),
@@ -456,7 +456,7 @@ namespace Sass {
     cookie_(ptr->cookie_),
     is_overload_stub_(ptr->is_overload_stub_),
     signature_(ptr->signature_)
-  { }
+  { tag_ = Definition_Tag; }
 
   Definition::Definition(SourceSpan pstate,
               sass::string n,
@@ -464,7 +464,7 @@ namespace Sass {
               Block_Obj b,
               Type t)
   : ParentStatement(pstate, b),
-    name_(n),
+    key_(n, t == MIXIN ? EnvKey::MIXIN : EnvKey::FUNCTION),
     parameters_(params),
     environment_(0),
     type_(t),
@@ -473,7 +473,7 @@ namespace Sass {
     cookie_(0),
     is_overload_stub_(false),
     signature_(0)
-  { }
+  { tag_ = Definition_Tag; }
 
   Definition::Definition(SourceSpan pstate,
               Signature sig,
@@ -482,7 +482,7 @@ namespace Sass {
               Native_Function func_ptr,
               bool overload_stub)
   : ParentStatement(pstate, {}),
-    name_(n),
+    key_(n, EnvKey::FUNCTION),
     parameters_(params),
     environment_(0),
     type_(FUNCTION),
@@ -491,7 +491,7 @@ namespace Sass {
     cookie_(0),
     is_overload_stub_(overload_stub),
     signature_(sig)
-  { }
+  { tag_ = Definition_Tag; }
 
   Definition::Definition(SourceSpan pstate,
               Signature sig,
@@ -499,7 +499,7 @@ namespace Sass {
               Parameters_Obj params,
               Sass_Function_Entry c_func)
   : ParentStatement(pstate, {}),
-    name_(n),
+    key_(n, EnvKey::FUNCTION),
     parameters_(params),
     environment_(0),
     type_(FUNCTION),
@@ -508,20 +508,20 @@ namespace Sass {
     cookie_(sass_function_get_cookie(c_func)),
     is_overload_stub_(false),
     signature_(sig)
-  { }
+  { tag_ = Definition_Tag; }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   Mixin_Call::Mixin_Call(SourceSpan pstate, sass::string n, Arguments_Obj args, Parameters_Obj b_params, Block_Obj b)
-  : ParentStatement(pstate, b), name_(n), arguments_(args), block_parameters_(b_params)
-  { }
+  : ParentStatement(pstate, b), key_(n, EnvKey::MIXIN), arguments_(args), block_parameters_(b_params)
+  { tag_ = Mixin_Call_Tag; }
   Mixin_Call::Mixin_Call(const Mixin_Call* ptr)
   : ParentStatement(ptr),
-    name_(ptr->name_),
+    key_(ptr->key_),
     arguments_(ptr->arguments_),
     block_parameters_(ptr->block_parameters_)
-  { }
+  { tag_ = Mixin_Call_Tag; }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
@@ -529,11 +529,11 @@ namespace Sass {
   Content::Content(SourceSpan pstate, Arguments_Obj args)
   : Statement(pstate),
     arguments_(args)
-  { statement_type(CONTENT); }
+  { tag_ = Content_Tag; statement_type(CONTENT); }
   Content::Content(const Content* ptr)
   : Statement(ptr),
     arguments_(ptr->arguments_)
-  { statement_type(CONTENT); }
+  { tag_ = Content_Tag; statement_type(CONTENT); }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
@@ -544,7 +544,7 @@ namespace Sass {
     is_expanded_(e),
     is_interpolant_(i),
     concrete_type_(ct)
-  { }
+  { tag_ = Expression_Tag; }
 
   Expression::Expression(const Expression* ptr)
   : AST_Node(ptr),
@@ -552,20 +552,20 @@ namespace Sass {
     is_expanded_(ptr->is_expanded_),
     is_interpolant_(ptr->is_interpolant_),
     concrete_type_(ptr->concrete_type_)
-  { }
+  { tag_ = Expression_Tag; }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   Unary_Expression::Unary_Expression(SourceSpan pstate, Type t, ExpressionObj o)
   : Expression(pstate), optype_(t), operand_(o), hash_(0)
-  { }
+  { tag_ = Unary_Expression_Tag; }
   Unary_Expression::Unary_Expression(const Unary_Expression* ptr)
   : Expression(ptr),
     optype_(ptr->optype_),
     operand_(ptr->operand_),
     hash_(ptr->hash_)
-  { }
+  { tag_ = Unary_Expression_Tag; }
   const sass::string Unary_Expression::type_name() {
     switch (optype_) {
       case PLUS: return "plus";
@@ -605,6 +605,7 @@ namespace Sass {
   Argument::Argument(SourceSpan pstate, ExpressionObj val, sass::string n, bool rest, bool keyword)
   : Expression(pstate), value_(val), name_(n), is_rest_argument_(rest), is_keyword_argument_(keyword), hash_(0)
   {
+    tag_ = Argument_Tag;
     if (!name_.empty() && is_rest_argument_) {
       coreError("variable-length argument may not be passed by name", pstate_);
     }
@@ -617,6 +618,7 @@ namespace Sass {
     is_keyword_argument_(ptr->is_keyword_argument_),
     hash_(ptr->hash_)
   {
+    tag_ = Argument_Tag;
     if (!name_.empty() && is_rest_argument_) {
       coreError("variable-length argument may not be passed by name", pstate_);
     }
@@ -661,14 +663,14 @@ namespace Sass {
     has_named_arguments_(false),
     has_rest_argument_(false),
     has_keyword_argument_(false)
-  { }
+  { tag_ = Arguments_Tag; }
   Arguments::Arguments(const Arguments* ptr)
   : Expression(ptr),
     Vectorized<Argument_Obj>(*ptr),
     has_named_arguments_(ptr->has_named_arguments_),
     has_rest_argument_(ptr->has_rest_argument_),
     has_keyword_argument_(ptr->has_keyword_argument_)
-  { }
+  { tag_ = Arguments_Tag; }
 
   void Arguments::set_delayed(bool delayed)
   {
@@ -741,14 +743,14 @@ namespace Sass {
   Media_Query::Media_Query(SourceSpan pstate, String_Obj t, size_t s, bool n, bool r)
   : Expression(pstate), Vectorized<Media_Query_ExpressionObj>(s),
     media_type_(t), is_negated_(n), is_restricted_(r)
-  { }
+  { tag_ = Media_Query_Tag; }
   Media_Query::Media_Query(const Media_Query* ptr)
   : Expression(ptr),
     Vectorized<Media_Query_ExpressionObj>(*ptr),
     media_type_(ptr->media_type_),
     is_negated_(ptr->is_negated_),
     is_restricted_(ptr->is_restricted_)
-  { }
+  { tag_ = Media_Query_Tag; }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
@@ -756,25 +758,25 @@ namespace Sass {
   Media_Query_Expression::Media_Query_Expression(SourceSpan pstate,
                           ExpressionObj f, ExpressionObj v, bool i)
   : Expression(pstate), feature_(f), value_(v), is_interpolated_(i)
-  { }
+  { tag_ = Media_Query_Expression_Tag; }
   Media_Query_Expression::Media_Query_Expression(const Media_Query_Expression* ptr)
   : Expression(ptr),
     feature_(ptr->feature_),
     value_(ptr->value_),
     is_interpolated_(ptr->is_interpolated_)
-  { }
+  { tag_ = Media_Query_Expression_Tag; }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   At_Root_Query::At_Root_Query(SourceSpan pstate, ExpressionObj f, ExpressionObj v, bool i)
   : Expression(pstate), feature_(f), value_(v)
-  { }
+  { tag_ = At_Root_Query_Tag; }
   At_Root_Query::At_Root_Query(const At_Root_Query* ptr)
   : Expression(ptr),
     feature_(ptr->feature_),
     value_(ptr->value_)
-  { }
+  { tag_ = At_Root_Query_Tag; }
 
   bool At_Root_Query::exclude(sass::string str)
   {
@@ -809,10 +811,10 @@ namespace Sass {
 
   AtRootRule::AtRootRule(SourceSpan pstate, Block_Obj b, At_Root_Query_Obj e)
   : ParentStatement(pstate, b), expression_(e)
-  { statement_type(ATROOT); }
+  { tag_ = AtRootRule_Tag; statement_type(ATROOT); }
   AtRootRule::AtRootRule(const AtRootRule* ptr)
   : ParentStatement(ptr), expression_(ptr->expression_)
-  { statement_type(ATROOT); }
+  { tag_ = AtRootRule_Tag; statement_type(ATROOT); }
 
   bool AtRootRule::bubbles() {
     return true;
@@ -856,14 +858,14 @@ namespace Sass {
   /////////////////////////////////////////////////////////////////////////
 
   Parameter::Parameter(SourceSpan pstate, sass::string n, ExpressionObj def, bool rest)
-  : AST_Node(pstate), name_(n), default_value_(def), is_rest_parameter_(rest)
-  { }
+  : AST_Node(pstate), key_(n), default_value_(def), is_rest_parameter_(rest)
+  { tag_ = Parameter_Tag; }
   Parameter::Parameter(const Parameter* ptr)
   : AST_Node(ptr),
-    name_(ptr->name_),
+    key_(ptr->key_),
     default_value_(ptr->default_value_),
     is_rest_parameter_(ptr->is_rest_parameter_)
-  { }
+  { tag_ = Parameter_Tag; }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
@@ -873,13 +875,13 @@ namespace Sass {
     Vectorized<Parameter_Obj>(),
     has_optional_parameters_(false),
     has_rest_parameter_(false)
-  { }
+  { tag_ = Parameters_Tag; }
   Parameters::Parameters(const Parameters* ptr)
   : AST_Node(ptr),
     Vectorized<Parameter_Obj>(*ptr),
     has_optional_parameters_(ptr->has_optional_parameters_),
     has_rest_parameter_(ptr->has_rest_parameter_)
-  { }
+  { tag_ = Parameters_Tag; }
 
   void Parameters::adjust_after_pushing(Parameter_Obj p)
   {
@@ -5,7 +5,9 @@
 // __EXTENSIONS__ fix on Solaris.
 #include "sass.hpp"
 
+#include <memory>
 #include <typeinfo>
+#include <stdexcept>
 #include <unordered_map>
 
 #include "sass/base.h"
@@ -17,6 +19,7 @@
 #include "position.hpp"
 #include "operation.hpp"
 #include "environment.hpp"
+#include "persistent_map.hpp"
 #include "fn_utils.hpp"
 
 namespace Sass {
@@ -56,14 +59,19 @@ namespace Sass {
   //////////////////////////////////////////////////////////
   class AST_Node : public SharedObj {
     ADD_PROPERTY(SourceSpan, pstate)
+  protected:
+    // class of the node (see `Cast`)
+    AST_Tag tag_;
   public:
     AST_Node(SourceSpan pstate)
-    : pstate_(pstate)
+    : pstate_(pstate), tag_(AST_Node_Tag)
     { }
     AST_Node(const AST_Node* ptr)
-    : pstate_(ptr->pstate_)
+    : pstate_(ptr->pstate_), tag_(ptr->tag_)
     { }
 
+    AST_Tag tag() const { return tag_; }
+
     // allow implicit conversion to string
     // needed for by SharedPtr implementation
     operator sass::string() {
@@ -109,13 +117,15 @@ namespace Sass {
 
   template<class T>
   T* Cast(AST_Node* ptr) {
-    return ptr && typeid(T) == typeid(*ptr) ?
+    return ptr && unsigned(ptr->tag() - AST_Tags<T>::first) <=
+           unsigned(AST_Tags<T>::last - AST_Tags<T>::first) ?
            static_cast<T*>(ptr) : NULL;
   };
 
   template<class T>
   const T* Cast(const AST_Node* ptr) {
-    return ptr && typeid(T) == typeid(*ptr) ?
+    return ptr && unsigned(ptr->tag() - AST_Tags<T>::first) <=
+           unsigned(AST_Tags<T>::last - AST_Tags<T>::first) ?
            static_cast<const T*>(ptr) : NULL;
   };
 
@@ -209,25 +219,78 @@ namespace Sass {
   template <typename T>
   class Vectorized {
     sass::vector<T> elements_;
+    // Elements shared with other objects (see `share`). We only see
+    // the first `length_` items, unless we were the last to share it
+    // (`length_` is npos). Only then can we append to it in place.
+    mutable std::shared_ptr<sass::vector<T>> shared_;
+    mutable size_t length_;
+    // Get the elements we see, without changing anything
+    const sass::vector<T>& storage() const {
+      return shared_ ? *shared_ : elements_;
+    }
+    // Get the elements as a vector for reading. If we only see a
+    // prefix of the shared elements, this is the one place where a
+    // const object changes: the prefix is cut off or copied first.
+    // The elements seen by us and by the other objects stay the same.
+    // Plain reads (`get`, `begin`, `length` etc.) never get here.
+    const sass::vector<T>& items() const {
+      if (!shared_) return elements_;
+      if (length_ != sass::string::npos && length_ != shared_->size()) {
+        if (shared_.use_count() == 1) shared_->resize(length_);
+        else shared_ = std::allocate_shared<sass::vector<T>>(
+          Allocator<sass::vector<T>>(), shared_->begin(), shared_->begin() + length_);
+        length_ = sass::string::npos;
+      }
+      return *shared_;
+    }
+    // Get the elements for writing (stops sharing)
+    sass::vector<T>& items() {
+      if (!shared_) return elements_;
+      if (shared_.use_count() == 1) {
+        shared_->resize(length());
+        elements_ = std::move(*shared_);
+      }
+      else {
+        elements_.assign(shared_->begin(),
+          shared_->begin() + length());
+      }
+      shared_.reset();
+      length_ = sass::string::npos;
+      return elements_;
+    }
   protected:
     mutable size_t hash_;
     void reset_hash() { hash_ = 0; }
     virtual void adjust_after_pushing(T element) { }
   public:
-    Vectorized(size_t s = 0) : hash_(0)
+    Vectorized(size_t s = 0) : length_(sass::string::npos), hash_(0)
     { elements_.reserve(s); }
     Vectorized(sass::vector<T> vec) :
       elements_(std::move(vec)),
+      length_(sass::string::npos),
       hash_(0)
     {}
+    Vectorized(const Vectorized<T>& other) :
+      elements_(other.begin(), other.end()),
+      length_(sass::string::npos),
+      hash_(other.hash_)
+    {}
+    Vectorized<T>& operator=(const Vectorized<T>& other) {
+      if (this != &other) elements(sass::vector<T>(other.begin(), other.end()));
+      return *this;
+    }
     virtual ~Vectorized() = 0;
-    size_t length() const   { return elements_.size(); }
-    bool empty() const      { return elements_.empty(); }
-    void clear()            { return elements_.clear(); }
-    T& last()               { return elements_.back(); }
-    T& first()              { return elements_.front(); }
-    const T& last() const   { return elements_.back(); }
-    const T& first() const  { return elements_.front(); }
+    size_t length() const   {
+      if (!shared_) return elements_.size();
+      if (length_ == sass::string::npos) return shared_->size();
+      return length_;
+    }
+    bool empty() const      { return length() == 0; }
+    void clear()            { return items().clear(); }
+    T& last()               { return items().back(); }
+    T& first()              { return items().front(); }
+    const T& last() const   { return storage()[length() - 1]; }
+    const T& first() const  { return storage().front(); }
 
     bool operator== (const Vectorized<T>& rhs) const {
       // Abort early if sizes do not match
@@ -240,32 +303,48 @@ namespace Sass {
       return !(*this == rhs);
     }
 
-    T& operator[](size_t i) { return elements_[i]; }
-    virtual const T& at(size_t i) const { return elements_.at(i); }
-    virtual T& at(size_t i) { return elements_.at(i); }
-    const T& get(size_t i) const { return elements_[i]; }
-    const T& operator[](size_t i) const { return elements_[i]; }
+    T& operator[](size_t i) { return items()[i]; }
+    virtual const T& at(size_t i) const {
+      if (i >= length()) throw std::out_of_range("Vectorized::at");
+      return storage()[i];
+    }
+    virtual T& at(size_t i) { return items().at(i); }
+    const T& get(size_t i) const { return storage()[i]; }
+    const T& operator[](size_t i) const { return storage()[i]; }
 
     // Implicitly get the sass::vector from our object
     // Makes the Vector directly assignable to sass::vector
     // You are responsible to make a copy if needed
     // Note: since this returns the real object, we can't
     // Note: guarantee that the hash will not get out of sync
-    operator sass::vector<T>&() { return elements_; }
-    operator const sass::vector<T>&() const { return elements_; }
+    operator sass::vector<T>&() { return items(); }
+    operator const sass::vector<T>&() const { return items(); }
 
     // Explicitly request all elements as a real sass::vector
     // You are responsible to make a copy if needed
     // Note: since this returns the real object, we can't
     // Note: guarantee that the hash will not get out of sync
-    sass::vector<T>& elements() { return elements_; }
-    const sass::vector<T>& elements() const { return elements_; }
+    sass::vector<T>& elements() { return items(); }
+    const sass::vector<T>& elements() const { return items(); }
 
     // Insert all items from compatible vector
     void concat(const sass::vector<T>& v)
     {
-      if (!v.empty()) reset_hash();
-      elements().insert(end(), v.begin(), v.end());
+      if (v.empty()) return;
+      reset_hash();
+      // we own the end of the shared elements
+      if (shared_ && length_ == sass::string::npos) {
+        if (&v == shared_.get()) {
+          sass::vector<T> copy(v);
+          shared_->insert(shared_->end(), copy.begin(), copy.end());
+        }
+        else {
+          shared_->insert(shared_->end(), v.begin(), v.end());
+        }
+      }
+      else {
+        items().insert(items().end(), v.begin(), v.end());
+      }
     }
 
     // Syntatic sugar for pointers
@@ -276,11 +355,46 @@ namespace Sass {
       }
     }
 
+    // Take the elements of `other` without copying them. If `other`
+    // could append to them in place, only we can do so afterwards.
+    // Any other change on either object copies the elements first.
+    // Meant for values that are extended in loops, where each step
+    // would otherwise copy all elements of the previous value.
+    // Note: `other` is changed to share them, but its elements are
+    // the same as before for any reader, so it may be a value that is
+    // still referenced elsewhere (e.g. by a variable).
+    // Note: objects of different memory pools (e.g. a parsed value
+    // from a cached stylesheet) do not share, the elements are copied.
+    void share(Vectorized<T>& other)
+    {
+      #ifdef SASS_CUSTOM_ALLOCATOR
+      if (ownerOf(dynamic_cast<const void*>(this)) !=
+          ownerOf(dynamic_cast<const void*>(&other))) {
+        const Vectorized<T>& from = other;
+        elements(sass::vector<T>(from.begin(), from.end()));
+        return;
+      }
+      #endif
+      reset_hash();
+      if (!other.shared_) {
+        // moving keeps the items at the same address
+        other.shared_ = std::allocate_shared<sass::vector<T>>(
+          Allocator<sass::vector<T>>(), std::move(other.elements_));
+        other.elements_.clear();
+      }
+      elements_.clear();
+      shared_ = other.shared_;
+      length_ = other.length_;
+      if (other.length_ == sass::string::npos) {
+        other.length_ = other.shared_->size();
+      }
+    }
+
     // Insert one item on the front
     void unshift(T element)
     {
       reset_hash();
-      elements_.insert(begin(), element);
+      items().insert(begin(), element);
     }
 
     // Remove and return item on the front
@@ -288,7 +402,7 @@ namespace Sass {
     T shift() {
       reset_hash();
       T first = get(0);
-      elements_.erase(begin());
+      items().erase(begin());
       return first;
     }
 
@@ -297,7 +411,13 @@ namespace Sass {
     void append(T element)
     {
       reset_hash();
-      elements_.insert(end(), element);
+      // we own the end of the shared elements
+      if (shared_ && length_ == sass::string::npos) {
+        shared_->push_back(element);
+      }
+      else {
+        items().push_back(element);
+      }
       // ToDo: Mostly used by parameters and arguments
       // ToDo: Find a more elegant way to support this
       adjust_after_pushing(element);
@@ -307,7 +427,7 @@ namespace Sass {
     // Uses underlying object `operator==`
     // E.g. compares the actual objects
     bool contains(const T& el) const {
-      for (const T& rhs : elements_) {
+      for (const T& rhs : *this) {
         // Test the underlying objects for equality
         // A std::find checks for pointer equality
         if (ObjEqualityFn(el, rhs)) {
@@ -320,13 +440,15 @@ namespace Sass {
     // This might be better implemented as `operator=`?
     void elements(sass::vector<T> e) {
       reset_hash();
+      shared_.reset();
+      length_ = sass::string::npos;
       elements_ = std::move(e);
     }
 
     virtual size_t hash() const
     {
       if (hash_ == 0) {
-        for (const T& el : elements_) {
+        for (const T& el : *this) {
           hash_combine(hash_, el->hash());
         }
       }
@@ -336,33 +458,53 @@ namespace Sass {
     template <typename P, typename V>
     typename sass::vector<T>::iterator insert(P position, const V& val) {
       reset_hash();
-      return elements_.insert(position, val);
+      return items().insert(position, val);
     }
 
-    typename sass::vector<T>::iterator end() { return elements_.end(); }
-    typename sass::vector<T>::iterator begin() { return elements_.begin(); }
-    typename sass::vector<T>::const_iterator end() const { return elements_.end(); }
-    typename sass::vector<T>::const_iterator begin() const { return elements_.begin(); }
-    typename sass::vector<T>::iterator erase(typename sass::vector<T>::iterator el) { reset_hash(); return elements_.erase(el); }
-    typename sass::vector<T>::const_iterator erase(typename sass::vector<T>::const_iterator el) { reset_hash(); return elements_.erase(el); }
+    typename sass::vector<T>::iterator end() { return items().end(); }
+    typename sass::vector<T>::iterator begin() { return items().begin(); }
+    typename sass::vector<T>::const_iterator end() const { return storage().begin() + length(); }
+    typename sass::vector<T>::const_iterator begin() const { return storage().begin(); }
+    typename sass::vector<T>::iterator erase(typename sass::vector<T>::iterator el) { reset_hash(); return items().erase(el); }
+    typename sass::vector<T>::const_iterator erase(typename sass::vector<T>::const_iterator el) { reset_hash(); return items().erase(el); }
 
   };
   template <typename T>
   inline Vectorized<T>::~Vectorized() { }
 
   /////////////////////////////////////////////////////////////////////////////
-  // Mixin class for AST nodes that should behave like a hash table. Uses an
-  // extra <sass::vector> internally to maintain insertion order for interation.
+  // Mixin class for AST nodes that should behave like a hash table. Uses a
+  // persistent map internally, so copies and merges share the entries. The
+  // insertion ordered key and value vectors are only created on demand.
   /////////////////////////////////////////////////////////////////////////////
   template <typename K, typename T, typename U>
   class Hashed {
   private:
-    std::unordered_map<
+    persistent_map<
       K, T, ObjHash, ObjHashEquality
     > elements_;
 
-    sass::vector<K> _keys;
-    sass::vector<T> _values;
+    mutable sass::vector<K> _keys;
+    mutable sass::vector<T> _values;
+    mutable bool ordered_;
+    void reset_ordered() {
+      _keys.clear();
+      _values.clear();
+      ordered_ = false;
+    }
+    void update_ordered() const {
+      if (ordered_) return;
+      // parsed maps may outlive the current memory
+      // pool when shared via the stylesheet cache
+      MemoryPoolScope scope(ownerOf(dynamic_cast<const void*>(this)));
+      _keys.reserve(length());
+      _values.reserve(length());
+      elements_.each([this](const K& key, const T& val) {
+        _keys.push_back(key);
+        _values.push_back(val);
+      });
+      ordered_ = true;
+    }
   protected:
     mutable size_t hash_;
     K duplicate_key_;
@@ -374,43 +516,40 @@ namespace Sass {
     : elements_(),
       _keys(),
       _values(),
+      ordered_(true),
       hash_(0), duplicate_key_({})
-    {
-      _keys.reserve(s);
-      _values.reserve(s);
-      elements_.reserve(s);
-    }
+    { }
+    // copies share the entries
+    Hashed(const Hashed& other)
+    : elements_(other.elements_),
+      _keys(),
+      _values(),
+      ordered_(false),
+      hash_(other.hash_), duplicate_key_(other.duplicate_key_)
+    { }
     virtual ~Hashed();
-    size_t length() const                  { return _keys.size(); }
-    bool empty() const                     { return _keys.empty(); }
+    size_t length() const                  { return elements_.size(); }
+    bool empty() const                     { return elements_.empty(); }
     bool has(K k) const          {
-      return elements_.find(k) != elements_.end();
+      return elements_.hasKey(k);
     }
     T at(K k) const {
-      if (elements_.count(k))
+      if (const T* val = elements_.get(k))
       {
-        return elements_.at(k);
+        return *val;
       }
       else { return {}; }
     }
     bool has_duplicate_key() const         { return duplicate_key_ != nullptr; }
     K get_duplicate_key() const  { return duplicate_key_; }
-    const std::unordered_map<
-      K, T, ObjHash, ObjHashEquality
-    >& elements() { return elements_; }
     Hashed& operator<<(std::pair<K, T> p)
     {
       reset_hash();
+      reset_ordered();
 
-      if (!has(p.first)) {
-        _keys.push_back(p.first);
-        _values.push_back(p.second);
+      if (!elements_.insert(p.first, p.second)) {
+        if (!duplicate_key_) duplicate_key_ = p.first;
       }
-      else if (!duplicate_key_) {
-        duplicate_key_ = p.first;
-      }
-
-      elements_[p.first] = p.second;
 
       adjust_after_pushing(p);
       return *this;
@@ -419,29 +558,27 @@ namespace Sass {
     {
       if (length() == 0) {
         this->elements_ = h->elements_;
-        this->_values = h->_values;
-        this->_keys = h->_keys;
+        reset_ordered();
         return *this;
       }
 
-      for (auto key : h->keys()) {
-        *this << std::make_pair(key, h->at(key));
-      }
+      h->elements_.each([this](const K& key, const T& val) {
+        *this << std::make_pair(key, val);
+      });
 
       reset_duplicate_key();
       return *this;
     }
-    const std::unordered_map<
-      K, T, ObjHash, ObjHashEquality
-    >& pairs() const { return elements_; }
-
-    const sass::vector<K>& keys() const { return _keys; }
-    const sass::vector<T>& values() const { return _values; }
+    bool erase(K k)
+    {
+      if (!elements_.erase(k)) return false;
+      reset_hash();
+      reset_ordered();
+      return true;
+    }
 
-//    std::unordered_map<ExpressionObj, ExpressionObj>::iterator end() { return elements_.end(); }
-//    std::unordered_map<ExpressionObj, ExpressionObj>::iterator begin() { return elements_.begin(); }
-//    std::unordered_map<ExpressionObj, ExpressionObj>::const_iterator end() const { return elements_.end(); }
-//    std::unordered_map<ExpressionObj, ExpressionObj>::const_iterator begin() const { return elements_.begin(); }
+    const sass::vector<K>& keys() const { update_ordered(); return _keys; }
+    const sass::vector<T>& values() const { update_ordered(); return _values; }
 
   };
   template <typename K, typename T, typename U>
@@ -613,12 +750,13 @@ namespace Sass {
   // Assignments -- variable and value.
   /////////////////////////////////////
   class Assignment final : public Statement {
-    ADD_CONSTREF(sass::string, variable)
+    ADD_CONSTREF(EnvKey, key)
     ADD_PROPERTY(ExpressionObj, value)
     ADD_PROPERTY(bool, is_default)
     ADD_PROPERTY(bool, is_global)
   public:
     Assignment(SourceSpan pstate, sass::string var, ExpressionObj val, bool is_default = false, bool is_global = false);
+    const sass::string& variable() const { return key_.name(); }
     ATTACH_AST_OPERATIONS(Assignment)
     ATTACH_CRTP_PERFORM_METHODS()
   };
@@ -766,7 +904,7 @@ namespace Sass {
   class Definition final : public ParentStatement {
   public:
     enum Type { MIXIN, FUNCTION };
-    ADD_CONSTREF(sass::string, name)
+    ADD_CONSTREF(EnvKey, key)
     ADD_PROPERTY(Parameters_Obj, parameters)
     ADD_PROPERTY(Env*, environment)
     ADD_PROPERTY(Type, type)
@@ -792,19 +930,75 @@ namespace Sass {
                sass::string n,
                Parameters_Obj params,
                Sass_Function_Entry c_func);
+    const sass::string& name() const { return key_.name(); }
     ATTACH_AST_OPERATIONS(Definition)
     ATTACH_CRTP_PERFORM_METHODS()
   };
 
+  //////////////////////////////////////////////////////////////////////
+  // Remembers the definition a call site resolved to in a given scope.
+  // It is only valid until a definition with the same name is declared
+  // again. Does not hold a reference, the counter is only read once the
+  // scope matched, which means the frame holding the definition and the
+  // context owning the counter are both still around.
+  //////////////////////////////////////////////////////////////////////
+  class CallSiteCache {
+    Definition* definition_;
+    size_t scope_;
+    const size_t* counter_;
+    size_t generation_;
+    // overload stubs further resolve by arity
+    Definition* overload_;
+    size_t arity_;
+  public:
+    CallSiteCache()
+    : definition_(nullptr), scope_(0),
+      counter_(nullptr), generation_(0),
+      overload_(nullptr), arity_(0)
+    { }
+    Definition* get(const Env* env) const
+    {
+      if (env->scope() != scope_) return nullptr;
+      if (*counter_ != generation_) return nullptr;
+      return definition_;
+    }
+    void set(Env* env, const EnvKey& key, Definition* definition)
+    {
+      counter_ = env->generation(key);
+      // frame without context
+      if (counter_ == nullptr) {
+        scope_ = 0;
+        return;
+      }
+      definition_ = definition;
+      scope_ = env->scope();
+      generation_ = *counter_;
+      overload_ = nullptr;
+    }
+    // only valid right after `get` returned the stub
+    Definition* overload(size_t arity) const
+    {
+      return arity == arity_ ? overload_ : nullptr;
+    }
+    void overload(size_t arity, Definition* definition)
+    {
+      overload_ = definition;
+      arity_ = arity;
+    }
+  };
+
   //////////////////////////////////////
   // Mixin calls (i.e., `@include ...`).
   //////////////////////////////////////
   class Mixin_Call final : public ParentStatement {
-    ADD_CONSTREF(sass::string, name)
+    ADD_CONSTREF(EnvKey, key)
     ADD_PROPERTY(Arguments_Obj, arguments)
     ADD_PROPERTY(Parameters_Obj, block_parameters)
+    CallSiteCache cache_;
   public:
     Mixin_Call(SourceSpan pstate, sass::string n, Arguments_Obj args, Parameters_Obj b_params = {}, Block_Obj b = {});
+    const sass::string& name() const { return key_.name(); }
+    CallSiteCache& cache() { return cache_; }
     ATTACH_AST_OPERATIONS(Mixin_Call)
     ATTACH_CRTP_PERFORM_METHODS()
   };
@@ -1023,11 +1217,12 @@ namespace Sass {
   // Individual parameter objects for mixins and functions.
   /////////////////////////////////////////////////////////
   class Parameter final : public AST_Node {
-    ADD_CONSTREF(sass::string, name)
+    ADD_CONSTREF(EnvKey, key)
     ADD_PROPERTY(ExpressionObj, default_value)
     ADD_PROPERTY(bool, is_rest_parameter)
   public:
     Parameter(SourceSpan pstate, sass::string n, ExpressionObj def = {}, bool rest = false);
+    const sass::string& name() const { return key_.name(); }
     ATTACH_AST_OPERATIONS(Parameter)
     ATTACH_CRTP_PERFORM_METHODS()
   };
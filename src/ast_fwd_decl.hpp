@@ -230,45 +230,216 @@ namespace Sass {
   typedef sass::vector<SelectorListObj> SelectorStack;
   typedef sass::vector<Sass_Import_Entry> ImporterStack;
 
-  // only to switch implementations for testing
-  #define environment_map std::map
+  // ###########################################################################
+  // type tags for all AST classes (set by every constructor)
+  // ###########################################################################
+
+  // Numbered in pre-order of the class hierarchy, so every class and all
+  // classes derived from it have consecutive tags up to its `_Last` tag.
+  enum AST_Tag : unsigned char {
+    AST_Node_Tag,
+      Expression_Tag,
+        PreValue_Tag,
+          Value_Tag,
+            List_Tag,
+            Map_Tag,
+            Function_Tag,
+            Number_Tag,
+            Color_Tag,
+              Color_RGBA_Tag,
+              Color_HSLA_Tag,
+            Color_Last = Color_HSLA_Tag,
+            Custom_Error_Tag,
+            Custom_Warning_Tag,
+            Boolean_Tag,
+            String_Tag,
+              String_Schema_Tag,
+              String_Constant_Tag,
+                String_Quoted_Tag,
+              String_Constant_Last = String_Quoted_Tag,
+            String_Last = String_Quoted_Tag,
+            Null_Tag,
+            Parent_Reference_Tag,
+          Value_Last = Parent_Reference_Tag,
+          Binary_Expression_Tag,
+          Function_Call_Tag,
+          Variable_Tag,
+        PreValue_Last = Variable_Tag,
+        Unary_Expression_Tag,
+        Argument_Tag,
+        Arguments_Tag,
+        Media_Query_Tag,
+        Media_Query_Expression_Tag,
+        At_Root_Query_Tag,
+        SupportsCondition_Tag,
+          SupportsOperation_Tag,
+          SupportsNegation_Tag,
+          SupportsDeclaration_Tag,
+          Supports_Interpolation_Tag,
+        SupportsCondition_Last = Supports_Interpolation_Tag,
+        Selector_Tag,
+          SimpleSelector_Tag,
+            PlaceholderSelector_Tag,
+            TypeSelector_Tag,
+            ClassSelector_Tag,
+            IDSelector_Tag,
+            AttributeSelector_Tag,
+            PseudoSelector_Tag,
+          SimpleSelector_Last = PseudoSelector_Tag,
+          SelectorComponent_Tag,
+            SelectorCombinator_Tag,
+            CompoundSelector_Tag,
+          SelectorComponent_Last = CompoundSelector_Tag,
+          ComplexSelector_Tag,
+          SelectorList_Tag,
+        Selector_Last = SelectorList_Tag,
+      Expression_Last = SelectorList_Tag,
+      Statement_Tag,
+        Block_Tag,
+        ParentStatement_Tag,
+          StyleRule_Tag,
+          Trace_Tag,
+          AtRule_Tag,
+          Keyframe_Rule_Tag,
+          Declaration_Tag,
+          If_Tag,
+          ForRule_Tag,
+          EachRule_Tag,
+          WhileRule_Tag,
+          Definition_Tag,
+          Mixin_Call_Tag,
+          MediaRule_Tag,
+          CssMediaRule_Tag,
+          AtRootRule_Tag,
+          SupportsRule_Tag,
+        ParentStatement_Last = SupportsRule_Tag,
+        Bubble_Tag,
+        Assignment_Tag,
+        Import_Tag,
+        Import_Stub_Tag,
+        WarningRule_Tag,
+        ErrorRule_Tag,
+        DebugRule_Tag,
+        Comment_Tag,
+        Return_Tag,
+        Content_Tag,
+        ExtendRule_Tag,
+      Statement_Last = ExtendRule_Tag,
+      CssMediaQuery_Tag,
+      Parameter_Tag,
+      Parameters_Tag,
+      Selector_Schema_Tag,
+    AST_Node_Last = Selector_Schema_Tag
+  };
+
+  // tags of a class and all classes derived from it
+  template<class T> struct AST_Tags;
+  template<class T> struct AST_Tags<const T> : AST_Tags<T> { };
+
+  #define DECLARE_AST_TAG(T) \
+  template<> struct AST_Tags<T> { \
+    enum : unsigned char { first = T##_Tag, last = T##_Tag }; \
+  }; \
+
+  #define DECLARE_AST_TAGS(T) \
+  template<> struct AST_Tags<T> { \
+    enum : unsigned char { first = T##_Tag, last = T##_Last }; \
+  }; \
+
+  DECLARE_AST_TAGS(AST_Node)
+  DECLARE_AST_TAGS(Expression)
+  DECLARE_AST_TAGS(PreValue)
+  DECLARE_AST_TAGS(Value)
+  DECLARE_AST_TAG(List)
+  DECLARE_AST_TAG(Map)
+  DECLARE_AST_TAG(Function)
+  DECLARE_AST_TAG(Number)
+  DECLARE_AST_TAGS(Color)
+  DECLARE_AST_TAG(Color_RGBA)
+  DECLARE_AST_TAG(Color_HSLA)
+  DECLARE_AST_TAG(Custom_Error)
+  DECLARE_AST_TAG(Custom_Warning)
+  DECLARE_AST_TAG(Boolean)
+  DECLARE_AST_TAGS(String)
+  DECLARE_AST_TAG(String_Schema)
+  DECLARE_AST_TAGS(String_Constant)
+  DECLARE_AST_TAG(String_Quoted)
+  DECLARE_AST_TAG(Null)
+  DECLARE_AST_TAG(Parent_Reference)
+  DECLARE_AST_TAG(Binary_Expression)
+  DECLARE_AST_TAG(Function_Call)
+  DECLARE_AST_TAG(Variable)
+  DECLARE_AST_TAG(Unary_Expression)
+  DECLARE_AST_TAG(Argument)
+  DECLARE_AST_TAG(Arguments)
+  DECLARE_AST_TAG(Media_Query)
+  DECLARE_AST_TAG(Media_Query_Expression)
+  DECLARE_AST_TAG(At_Root_Query)
+  DECLARE_AST_TAGS(SupportsCondition)
+  DECLARE_AST_TAG(SupportsOperation)
+  DECLARE_AST_TAG(SupportsNegation)
+  DECLARE_AST_TAG(SupportsDeclaration)
+  DECLARE_AST_TAG(Supports_Interpolation)
+  DECLARE_AST_TAGS(Selector)
+  DECLARE_AST_TAGS(SimpleSelector)
+  DECLARE_AST_TAG(PlaceholderSelector)
+  DECLARE_AST_TAG(TypeSelector)
+  DECLARE_AST_TAG(ClassSelector)
+  DECLARE_AST_TAG(IDSelector)
+  DECLARE_AST_TAG(AttributeSelector)
+  DECLARE_AST_TAG(PseudoSelector)
+  DECLARE_AST_TAGS(SelectorComponent)
+  DECLARE_AST_TAG(SelectorCombinator)
+  DECLARE_AST_TAG(CompoundSelector)
+  DECLARE_AST_TAG(ComplexSelector)
+  DECLARE_AST_TAG(SelectorList)
+  DECLARE_AST_TAGS(Statement)
+  DECLARE_AST_TAG(Block)
+  DECLARE_AST_TAGS(ParentStatement)
+  DECLARE_AST_TAG(StyleRule)
+  DECLARE_AST_TAG(Trace)
+  DECLARE_AST_TAG(AtRule)
+  DECLARE_AST_TAG(Keyframe_Rule)
+  DECLARE_AST_TAG(Declaration)
+  DECLARE_AST_TAG(If)
+  DECLARE_AST_TAG(ForRule)
+  DECLARE_AST_TAG(EachRule)
+  DECLARE_AST_TAG(WhileRule)
+  DECLARE_AST_TAG(Definition)
+  DECLARE_AST_TAG(Mixin_Call)
+  DECLARE_AST_TAG(MediaRule)
+  DECLARE_AST_TAG(CssMediaRule)
+  DECLARE_AST_TAG(AtRootRule)
+  DECLARE_AST_TAG(SupportsRule)
+  DECLARE_AST_TAG(Bubble)
+  DECLARE_AST_TAG(Assignment)
+  DECLARE_AST_TAG(Import)
+  DECLARE_AST_TAG(Import_Stub)
+  DECLARE_AST_TAG(WarningRule)
+  DECLARE_AST_TAG(ErrorRule)
+  DECLARE_AST_TAG(DebugRule)
+  DECLARE_AST_TAG(Comment)
+  DECLARE_AST_TAG(Return)
+  DECLARE_AST_TAG(Content)
+  DECLARE_AST_TAG(ExtendRule)
+  DECLARE_AST_TAG(CssMediaQuery)
+  DECLARE_AST_TAG(Parameter)
+  DECLARE_AST_TAG(Parameters)
+  DECLARE_AST_TAG(Selector_Schema)
 
   // ###########################################################################
   // explicit type conversion functions
   // ###########################################################################
 
+  // Casts to the class and all classes derived from it
+  // (only a range check on the type tag of the node)
+
   template<class T>
   T* Cast(AST_Node* ptr);
 
   template<class T>
   const T* Cast(const AST_Node* ptr);
 
-  // sometimes you know the class you want to cast to is final
-  // in this case a simple typeid check is faster and safe to use
-
-  #define DECLARE_BASE_CAST(T) \
-  template<> T* Cast(AST_Node* ptr); \
-  template<> const T* Cast(const AST_Node* ptr); \
-
-  // ###########################################################################
-  // implement specialization for final classes
-  // ###########################################################################
-
-  DECLARE_BASE_CAST(AST_Node)
-  DECLARE_BASE_CAST(Expression)
-  DECLARE_BASE_CAST(Statement)
-  DECLARE_BASE_CAST(ParentStatement)
-  DECLARE_BASE_CAST(PreValue)
-  DECLARE_BASE_CAST(Value)
-  DECLARE_BASE_CAST(List)
-  DECLARE_BASE_CAST(Color)
-  DECLARE_BASE_CAST(String)
-  DECLARE_BASE_CAST(String_Constant)
-  DECLARE_BASE_CAST(SupportsCondition)
-  DECLARE_BASE_CAST(Selector)
-  DECLARE_BASE_CAST(SimpleSelector)
-  DECLARE_BASE_CAST(SelectorComponent)
-
 }
 
 #endif
@@ -14,12 +14,12 @@ namespace Sass {
   Selector::Selector(SourceSpan pstate)
   : Expression(pstate),
     hash_(0)
-  { concrete_type(SELECTOR); }
+  { tag_ = Selector_Tag; concrete_type(SELECTOR); }
 
   Selector::Selector(const Selector* ptr)
   : Expression(ptr),
     hash_(ptr->hash_)
-  { concrete_type(SELECTOR); }
+  { tag_ = Selector_Tag; concrete_type(SELECTOR); }
 
 
   bool Selector::has_real_parent_ref() const
@@ -35,13 +35,13 @@ namespace Sass {
     contents_(c),
     connect_parent_(true),
     hash_(0)
-  { }
+  { tag_ = Selector_Schema_Tag; }
   Selector_Schema::Selector_Schema(const Selector_Schema* ptr)
   : AST_Node(ptr),
     contents_(ptr->contents_),
     connect_parent_(ptr->connect_parent_),
     hash_(ptr->hash_)
-  { }
+  { tag_ = Selector_Schema_Tag; }
 
   unsigned long Selector_Schema::specificity() const
   {
@@ -72,6 +72,7 @@ namespace Sass {
   SimpleSelector::SimpleSelector(SourceSpan pstate, sass::string n)
   : Selector(pstate), ns_(""), name_(n), has_ns_(false)
   {
+    tag_ = SimpleSelector_Tag;
     size_t pos = n.find('|');
     // found some namespace
     if (pos != sass::string::npos) {
@@ -85,7 +86,7 @@ namespace Sass {
     ns_(ptr->ns_),
     name_(ptr->name_),
     has_ns_(ptr->has_ns_)
-  { }
+  { tag_ = SimpleSelector_Tag; }
 
   sass::string SimpleSelector::ns_name() const
   {
@@ -176,10 +177,10 @@ namespace Sass {
 
   PlaceholderSelector::PlaceholderSelector(SourceSpan pstate, sass::string n)
   : SimpleSelector(pstate, n)
-  { simple_type(PLACEHOLDER_SEL); }
+  { tag_ = PlaceholderSelector_Tag; simple_type(PLACEHOLDER_SEL); }
   PlaceholderSelector::PlaceholderSelector(const PlaceholderSelector* ptr)
   : SimpleSelector(ptr)
-  { simple_type(PLACEHOLDER_SEL); }
+  { tag_ = PlaceholderSelector_Tag; simple_type(PLACEHOLDER_SEL); }
   unsigned long PlaceholderSelector::specificity() const
   {
     return Constants::Specificity_Base;
@@ -193,10 +194,10 @@ namespace Sass {
 
   TypeSelector::TypeSelector(SourceSpan pstate, sass::string n)
   : SimpleSelector(pstate, n)
-  { simple_type(TYPE_SEL); }
+  { tag_ = TypeSelector_Tag; simple_type(TYPE_SEL); }
   TypeSelector::TypeSelector(const TypeSelector* ptr)
   : SimpleSelector(ptr)
-  { simple_type(TYPE_SEL); }
+  { tag_ = TypeSelector_Tag; simple_type(TYPE_SEL); }
 
   unsigned long TypeSelector::specificity() const
   {
@@ -209,10 +210,10 @@ namespace Sass {
 
   ClassSelector::ClassSelector(SourceSpan pstate, sass::string n)
   : SimpleSelector(pstate, n)
-  { simple_type(CLASS_SEL); }
+  { tag_ = ClassSelector_Tag; simple_type(CLASS_SEL); }
   ClassSelector::ClassSelector(const ClassSelector* ptr)
   : SimpleSelector(ptr)
-  { simple_type(CLASS_SEL); }
+  { tag_ = ClassSelector_Tag; simple_type(CLASS_SEL); }
 
   unsigned long ClassSelector::specificity() const
   {
@@ -224,10 +225,10 @@ namespace Sass {
 
   IDSelector::IDSelector(SourceSpan pstate, sass::string n)
   : SimpleSelector(pstate, n)
-  { simple_type(ID_SEL); }
+  { tag_ = IDSelector_Tag; simple_type(ID_SEL); }
   IDSelector::IDSelector(const IDSelector* ptr)
   : SimpleSelector(ptr)
-  { simple_type(ID_SEL); }
+  { tag_ = IDSelector_Tag; simple_type(ID_SEL); }
 
   unsigned long IDSelector::specificity() const
   {
@@ -239,13 +240,13 @@ namespace Sass {
 
   AttributeSelector::AttributeSelector(SourceSpan pstate, sass::string n, sass::string m, String_Obj v, char o)
   : SimpleSelector(pstate, n), matcher_(m), value_(v), modifier_(o)
-  { simple_type(ATTRIBUTE_SEL); }
+  { tag_ = AttributeSelector_Tag; simple_type(ATTRIBUTE_SEL); }
   AttributeSelector::AttributeSelector(const AttributeSelector* ptr)
   : SimpleSelector(ptr),
     matcher_(ptr->matcher_),
     value_(ptr->value_),
     modifier_(ptr->modifier_)
-  { simple_type(ATTRIBUTE_SEL); }
+  { tag_ = AttributeSelector_Tag; simple_type(ATTRIBUTE_SEL); }
 
   size_t AttributeSelector::hash() const
   {
@@ -272,7 +273,7 @@ namespace Sass {
     selector_({}),
     isSyntacticClass_(!element),
     isClass_(!element && !isFakePseudoElement(normalized_))
-  { simple_type(PSEUDO_SEL); }
+  { tag_ = PseudoSelector_Tag; simple_type(PSEUDO_SEL); }
   PseudoSelector::PseudoSelector(const PseudoSelector* ptr)
   : SimpleSelector(ptr),
     normalized_(ptr->normalized()),
@@ -280,7 +281,7 @@ namespace Sass {
     selector_(ptr->selector()),
     isSyntacticClass_(ptr->isSyntacticClass()),
     isClass_(ptr->isClass())
-  { simple_type(PSEUDO_SEL); }
+  { tag_ = PseudoSelector_Tag; simple_type(PSEUDO_SEL); }
 
   // A pseudo-element is made of two colons (::) followed by the name.
   // The `::` notation is introduced by the current document in order to
@@ -344,12 +345,12 @@ namespace Sass {
   : Selector(pstate),
     Vectorized<ComplexSelectorObj>(s),
     is_optional_(false)
-  { }
+  { tag_ = SelectorList_Tag; }
   SelectorList::SelectorList(const SelectorList* ptr)
     : Selector(ptr),
     Vectorized<ComplexSelectorObj>(*ptr),
     is_optional_(ptr->is_optional_)
-  { }
+  { tag_ = SelectorList_Tag; }
 
   size_t SelectorList::hash() const
   {
@@ -397,6 +398,7 @@ namespace Sass {
     chroots_(false),
     hasPreLineFeed_(false)
   {
+    tag_ = ComplexSelector_Tag;
   }
   ComplexSelector::ComplexSelector(const ComplexSelector* ptr)
   : Selector(ptr),
@@ -404,6 +406,7 @@ namespace Sass {
     chroots_(ptr->chroots()),
     hasPreLineFeed_(ptr->hasPreLineFeed())
   {
+    tag_ = ComplexSelector_Tag;
   }
 
   void ComplexSelector::cloneChildren()
@@ -483,12 +486,13 @@ namespace Sass {
   : Selector(pstate),
     hasPostLineBreak_(postLineBreak)
   {
+    tag_ = SelectorComponent_Tag;
   }
 
   SelectorComponent::SelectorComponent(const SelectorComponent* ptr)
   : Selector(ptr),
     hasPostLineBreak_(ptr->hasPostLineBreak())
-  { }
+  { tag_ = SelectorComponent_Tag; }
 
   void SelectorComponent::cloneChildren()
   {
@@ -514,11 +518,12 @@ namespace Sass {
     : SelectorComponent(pstate, postLineBreak),
     combinator_(combinator)
   {
+    tag_ = SelectorCombinator_Tag;
   }
   SelectorCombinator::SelectorCombinator(const SelectorCombinator* ptr)
     : SelectorComponent(ptr->pstate(), false),
       combinator_(ptr->combinator())
-  { }
+  { tag_ = SelectorCombinator_Tag; }
 
   void SelectorCombinator::cloneChildren()
   {
@@ -537,12 +542,13 @@ namespace Sass {
       Vectorized<SimpleSelectorObj>(),
       hasRealParent_(false)
   {
+    tag_ = CompoundSelector_Tag;
   }
   CompoundSelector::CompoundSelector(const CompoundSelector* ptr)
     : SelectorComponent(ptr),
       Vectorized<SimpleSelectorObj>(*ptr),
       hasRealParent_(ptr->hasRealParent())
-  { }
+  { tag_ = CompoundSelector_Tag; }
 
   size_t CompoundSelector::hash() const
   {
@@ -612,6 +618,7 @@ namespace Sass {
     ParentStatement(pstate, block),
     schema_({})
   {
+    tag_ = MediaRule_Tag;
     statement_type(MEDIA);
   }
 
@@ -619,6 +626,7 @@ namespace Sass {
     ParentStatement(ptr),
     schema_(ptr->schema_)
   {
+    tag_ = MediaRule_Tag;
     statement_type(MEDIA);
   }
 
@@ -629,6 +637,7 @@ namespace Sass {
     ParentStatement(pstate, block),
     Vectorized()
   {
+    tag_ = CssMediaRule_Tag;
     statement_type(MEDIA);
   }
 
@@ -636,6 +645,7 @@ namespace Sass {
     ParentStatement(ptr),
     Vectorized(*ptr)
   {
+    tag_ = CssMediaRule_Tag;
     statement_type(MEDIA);
   }
 
@@ -645,6 +655,7 @@ namespace Sass {
     type_(""),
     features_()
   {
+    tag_ = CssMediaQuery_Tag;
   }
 
   /////////////////////////////////////////////////////////////////////////
@@ -794,6 +805,7 @@ namespace Sass {
     type_(ptr->type_),
     features_(ptr->features_)
   {
+    tag_ = CssMediaQuery_Tag;
   }
 
   /////////////////////////////////////////////////////////////////////////
@@ -11,10 +11,10 @@ namespace Sass {
 
   SupportsRule::SupportsRule(SourceSpan pstate, SupportsConditionObj condition, Block_Obj block)
   : ParentStatement(pstate, block), condition_(condition)
-  { statement_type(SUPPORTS); }
+  { tag_ = SupportsRule_Tag; statement_type(SUPPORTS); }
   SupportsRule::SupportsRule(const SupportsRule* ptr)
   : ParentStatement(ptr), condition_(ptr->condition_)
-  { statement_type(SUPPORTS); }
+  { tag_ = SupportsRule_Tag; statement_type(SUPPORTS); }
   bool SupportsRule::bubbles() { return true; }
 
   /////////////////////////////////////////////////////////////////////////
@@ -22,24 +22,24 @@ namespace Sass {
 
   SupportsCondition::SupportsCondition(SourceSpan pstate)
   : Expression(pstate)
-  { }
+  { tag_ = SupportsCondition_Tag; }
 
   SupportsCondition::SupportsCondition(const SupportsCondition* ptr)
   : Expression(ptr)
-  { }
+  { tag_ = SupportsCondition_Tag; }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   SupportsOperation::SupportsOperation(SourceSpan pstate, SupportsConditionObj l, SupportsConditionObj r, Operand o)
   : SupportsCondition(pstate), left_(l), right_(r), operand_(o)
-  { }
+  { tag_ = SupportsOperation_Tag; }
   SupportsOperation::SupportsOperation(const SupportsOperation* ptr)
   : SupportsCondition(ptr),
     left_(ptr->left_),
     right_(ptr->right_),
     operand_(ptr->operand_)
-  { }
+  { tag_ = SupportsOperation_Tag; }
 
   bool SupportsOperation::needs_parens(SupportsConditionObj cond) const
   {
@@ -54,10 +54,10 @@ namespace Sass {
 
   SupportsNegation::SupportsNegation(SourceSpan pstate, SupportsConditionObj c)
   : SupportsCondition(pstate), condition_(c)
-  { }
+  { tag_ = SupportsNegation_Tag; }
   SupportsNegation::SupportsNegation(const SupportsNegation* ptr)
   : SupportsCondition(ptr), condition_(ptr->condition_)
-  { }
+  { tag_ = SupportsNegation_Tag; }
 
   bool SupportsNegation::needs_parens(SupportsConditionObj cond) const
   {
@@ -70,12 +70,12 @@ namespace Sass {
 
   SupportsDeclaration::SupportsDeclaration(SourceSpan pstate, ExpressionObj f, ExpressionObj v)
   : SupportsCondition(pstate), feature_(f), value_(v)
-  { }
+  { tag_ = SupportsDeclaration_Tag; }
   SupportsDeclaration::SupportsDeclaration(const SupportsDeclaration* ptr)
   : SupportsCondition(ptr),
     feature_(ptr->feature_),
     value_(ptr->value_)
-  { }
+  { tag_ = SupportsDeclaration_Tag; }
 
   bool SupportsDeclaration::needs_parens(SupportsConditionObj cond) const
   {
@@ -87,11 +87,11 @@ namespace Sass {
 
   Supports_Interpolation::Supports_Interpolation(SourceSpan pstate, ExpressionObj v)
   : SupportsCondition(pstate), value_(v)
-  { }
+  { tag_ = Supports_Interpolation_Tag; }
   Supports_Interpolation::Supports_Interpolation(const Supports_Interpolation* ptr)
   : SupportsCondition(ptr),
     value_(ptr->value_)
-  { }
+  { tag_ = Supports_Interpolation_Tag; }
 
   bool Supports_Interpolation::needs_parens(SupportsConditionObj cond) const
   {
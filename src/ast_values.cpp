@@ -2,6 +2,7 @@
 // __EXTENSIONS__ fix on Solaris.
 #include "sass.hpp"
 #include "ast.hpp"
+#include "util.hpp"
 
 namespace Sass {
 
@@ -15,20 +16,20 @@ namespace Sass {
 
   PreValue::PreValue(SourceSpan pstate, bool d, bool e, bool i, Type ct)
   : Expression(pstate, d, e, i, ct)
-  { }
+  { tag_ = PreValue_Tag; }
   PreValue::PreValue(const PreValue* ptr)
   : Expression(ptr)
-  { }
+  { tag_ = PreValue_Tag; }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   Value::Value(SourceSpan pstate, bool d, bool e, bool i, Type ct)
   : PreValue(pstate, d, e, i, ct)
-  { }
+  { tag_ = Value_Tag; }
   Value::Value(const Value* ptr)
   : PreValue(ptr)
-  { }
+  { tag_ = Value_Tag; }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
@@ -40,7 +41,7 @@ namespace Sass {
     is_arglist_(argl),
     is_bracketed_(bracket),
     from_selector_(false)
-  { concrete_type(LIST); }
+  { tag_ = List_Tag; concrete_type(LIST); }
 
   List::List(const List* ptr)
   : Value(ptr),
@@ -49,7 +50,7 @@ namespace Sass {
     is_arglist_(ptr->is_arglist_),
     is_bracketed_(ptr->is_bracketed_),
     from_selector_(ptr->from_selector_)
-  { concrete_type(LIST); }
+  { tag_ = List_Tag; concrete_type(LIST); }
 
   size_t List::hash() const
   {
@@ -119,7 +120,7 @@ namespace Sass {
 
 
   ExpressionObj List::value_at_index(size_t i) {
-    ExpressionObj obj = this->at(i);
+    ExpressionObj obj = this->get(i);
     if (is_arglist_) {
       if (Argument* arg = Cast<Argument>(obj)) {
         return arg->value();
@@ -137,12 +138,12 @@ namespace Sass {
   Map::Map(SourceSpan pstate, size_t size)
   : Value(pstate),
     Hashed(size)
-  { concrete_type(MAP); }
+  { tag_ = Map_Tag; concrete_type(MAP); }
 
   Map::Map(const Map* ptr)
   : Value(ptr),
     Hashed(*ptr)
-  { concrete_type(MAP); }
+  { tag_ = Map_Tag; concrete_type(MAP); }
 
   bool Map::operator< (const Expression& rhs) const
   {
@@ -216,7 +217,7 @@ namespace Sass {
   Binary_Expression::Binary_Expression(SourceSpan pstate,
                     Operand op, ExpressionObj lhs, ExpressionObj rhs)
   : PreValue(pstate), op_(op), left_(lhs), right_(rhs), hash_(0)
-  { }
+  { tag_ = Binary_Expression_Tag; }
 
   Binary_Expression::Binary_Expression(const Binary_Expression* ptr)
   : PreValue(ptr),
@@ -224,7 +225,7 @@ namespace Sass {
     left_(ptr->left_),
     right_(ptr->right_),
     hash_(ptr->hash_)
-  { }
+  { tag_ = Binary_Expression_Tag; }
 
   bool Binary_Expression::is_left_interpolant(void) const
   {
@@ -294,11 +295,11 @@ namespace Sass {
 
   Function::Function(SourceSpan pstate, Definition_Obj def, bool css)
   : Value(pstate), definition_(def), is_css_(css)
-  { concrete_type(FUNCTION_VAL); }
+  { tag_ = Function_Tag; concrete_type(FUNCTION_VAL); }
 
   Function::Function(const Function* ptr)
   : Value(ptr), definition_(ptr->definition_), is_css_(ptr->is_css_)
-  { concrete_type(FUNCTION_VAL); }
+  { tag_ = Function_Tag; concrete_type(FUNCTION_VAL); }
 
   bool Function::operator< (const Expression& rhs) const
   {
@@ -338,23 +339,23 @@ namespace Sass {
 
   Function_Call::Function_Call(SourceSpan pstate, String_Obj n, Arguments_Obj args, void* cookie)
   : PreValue(pstate), sname_(n), arguments_(args), func_(), via_call_(false), cookie_(cookie), hash_(0)
-  { concrete_type(FUNCTION); }
+  { tag_ = Function_Call_Tag; concrete_type(FUNCTION); key_ = EnvKey(Util::normalize_underscores(name()), EnvKey::FUNCTION); }
   Function_Call::Function_Call(SourceSpan pstate, String_Obj n, Arguments_Obj args, Function_Obj func)
   : PreValue(pstate), sname_(n), arguments_(args), func_(func), via_call_(false), cookie_(0), hash_(0)
-  { concrete_type(FUNCTION); }
+  { tag_ = Function_Call_Tag; concrete_type(FUNCTION); key_ = EnvKey(Util::normalize_underscores(name()), EnvKey::FUNCTION); }
   Function_Call::Function_Call(SourceSpan pstate, String_Obj n, Arguments_Obj args)
   : PreValue(pstate), sname_(n), arguments_(args), via_call_(false), cookie_(0), hash_(0)
-  { concrete_type(FUNCTION); }
+  { tag_ = Function_Call_Tag; concrete_type(FUNCTION); key_ = EnvKey(Util::normalize_underscores(name()), EnvKey::FUNCTION); }
 
   Function_Call::Function_Call(SourceSpan pstate, sass::string n, Arguments_Obj args, void* cookie)
   : PreValue(pstate), sname_(SASS_MEMORY_NEW(String_Constant, pstate, n)), arguments_(args), func_(), via_call_(false), cookie_(cookie), hash_(0)
-  { concrete_type(FUNCTION); }
+  { tag_ = Function_Call_Tag; concrete_type(FUNCTION); key_ = EnvKey(Util::normalize_underscores(name()), EnvKey::FUNCTION); }
   Function_Call::Function_Call(SourceSpan pstate, sass::string n, Arguments_Obj args, Function_Obj func)
   : PreValue(pstate), sname_(SASS_MEMORY_NEW(String_Constant, pstate, n)), arguments_(args), func_(func), via_call_(false), cookie_(0), hash_(0)
-  { concrete_type(FUNCTION); }
+  { tag_ = Function_Call_Tag; concrete_type(FUNCTION); key_ = EnvKey(Util::normalize_underscores(name()), EnvKey::FUNCTION); }
   Function_Call::Function_Call(SourceSpan pstate, sass::string n, Arguments_Obj args)
   : PreValue(pstate), sname_(SASS_MEMORY_NEW(String_Constant, pstate, n)), arguments_(args), via_call_(false), cookie_(0), hash_(0)
-  { concrete_type(FUNCTION); }
+  { tag_ = Function_Call_Tag; concrete_type(FUNCTION); key_ = EnvKey(Util::normalize_underscores(name()), EnvKey::FUNCTION); }
 
   Function_Call::Function_Call(const Function_Call* ptr)
   : PreValue(ptr),
@@ -363,8 +364,9 @@ namespace Sass {
     func_(ptr->func_),
     via_call_(ptr->via_call_),
     cookie_(ptr->cookie_),
+    key_(ptr->key_),
     hash_(ptr->hash_)
-  { concrete_type(FUNCTION); }
+  { tag_ = Function_Call_Tag; concrete_type(FUNCTION); }
 
   bool Function_Call::operator==(const Expression& rhs) const
   {
@@ -402,12 +404,12 @@ namespace Sass {
   /////////////////////////////////////////////////////////////////////////
 
   Variable::Variable(SourceSpan pstate, sass::string n)
-  : PreValue(pstate), name_(n)
-  { concrete_type(VARIABLE); }
+  : PreValue(pstate), key_(n)
+  { tag_ = Variable_Tag; concrete_type(VARIABLE); }
 
   Variable::Variable(const Variable* ptr)
-  : PreValue(ptr), name_(ptr->name_)
-  { concrete_type(VARIABLE); }
+  : PreValue(ptr), key_(ptr->key_)
+  { tag_ = Variable_Tag; concrete_type(VARIABLE); }
 
   bool Variable::operator==(const Expression& rhs) const
   {
@@ -432,6 +434,7 @@ namespace Sass {
     zero_(zero),
     hash_(0)
   {
+    tag_ = Number_Tag;
     size_t l = 0;
     size_t r;
     if (!u.empty()) {
@@ -462,7 +465,7 @@ namespace Sass {
     Units(ptr),
     value_(ptr->value_), zero_(ptr->zero_),
     hash_(ptr->hash_)
-  { concrete_type(NUMBER); }
+  { tag_ = Number_Tag; concrete_type(NUMBER); }
 
   // cancel out unnecessary units
   void Number::reduce()
@@ -553,7 +556,7 @@ namespace Sass {
   : Value(pstate),
     disp_(disp), a_(a),
     hash_(0)
-  { concrete_type(COLOR); }
+  { tag_ = Color_Tag; concrete_type(COLOR); }
 
   Color::Color(const Color* ptr)
   : Value(ptr->pstate()),
@@ -561,7 +564,7 @@ namespace Sass {
     disp_(""),
     a_(ptr->a_),
     hash_(ptr->hash_)
-  { concrete_type(COLOR); }
+  { tag_ = Color_Tag; concrete_type(COLOR); }
 
   bool Color::operator< (const Expression& rhs) const
   {
@@ -598,14 +601,14 @@ namespace Sass {
   Color_RGBA::Color_RGBA(SourceSpan pstate, double r, double g, double b, double a, const sass::string disp)
   : Color(pstate, a, disp),
     r_(r), g_(g), b_(b)
-  { concrete_type(COLOR); }
+  { tag_ = Color_RGBA_Tag; concrete_type(COLOR); }
 
   Color_RGBA::Color_RGBA(const Color_RGBA* ptr)
   : Color(ptr),
     r_(ptr->r_),
     g_(ptr->g_),
     b_(ptr->b_)
-  { concrete_type(COLOR); }
+  { tag_ = Color_RGBA_Tag; concrete_type(COLOR); }
 
   bool Color_RGBA::operator< (const Expression& rhs) const
   {
@@ -699,7 +702,7 @@ namespace Sass {
     s_(clip(s, 0.0, 100.0)),
     l_(clip(l, 0.0, 100.0))
     // hash_(0)
-  { concrete_type(COLOR); }
+  { tag_ = Color_HSLA_Tag; concrete_type(COLOR); }
 
   Color_HSLA::Color_HSLA(const Color_HSLA* ptr)
   : Color(ptr),
@@ -707,7 +710,7 @@ namespace Sass {
     s_(ptr->s_),
     l_(ptr->l_)
     // hash_(ptr->hash_)
-  { concrete_type(COLOR); }
+  { tag_ = Color_HSLA_Tag; concrete_type(COLOR); }
 
   bool Color_HSLA::operator< (const Expression& rhs) const
   {
@@ -791,11 +794,11 @@ namespace Sass {
 
   Custom_Error::Custom_Error(SourceSpan pstate, sass::string msg)
   : Value(pstate), message_(msg)
-  { concrete_type(C_ERROR); }
+  { tag_ = Custom_Error_Tag; concrete_type(C_ERROR); }
 
   Custom_Error::Custom_Error(const Custom_Error* ptr)
   : Value(ptr), message_(ptr->message_)
-  { concrete_type(C_ERROR); }
+  { tag_ = Custom_Error_Tag; concrete_type(C_ERROR); }
 
   bool Custom_Error::operator< (const Expression& rhs) const
   {
@@ -819,11 +822,11 @@ namespace Sass {
 
   Custom_Warning::Custom_Warning(SourceSpan pstate, sass::string msg)
   : Value(pstate), message_(msg)
-  { concrete_type(C_WARNING); }
+  { tag_ = Custom_Warning_Tag; concrete_type(C_WARNING); }
 
   Custom_Warning::Custom_Warning(const Custom_Warning* ptr)
   : Value(ptr), message_(ptr->message_)
-  { concrete_type(C_WARNING); }
+  { tag_ = Custom_Warning_Tag; concrete_type(C_WARNING); }
 
   bool Custom_Warning::operator< (const Expression& rhs) const
   {
@@ -848,13 +851,13 @@ namespace Sass {
   Boolean::Boolean(SourceSpan pstate, bool val)
   : Value(pstate), value_(val),
     hash_(0)
-  { concrete_type(BOOLEAN); }
+  { tag_ = Boolean_Tag; concrete_type(BOOLEAN); }
 
   Boolean::Boolean(const Boolean* ptr)
   : Value(ptr),
     value_(ptr->value_),
     hash_(ptr->hash_)
-  { concrete_type(BOOLEAN); }
+  { tag_ = Boolean_Tag; concrete_type(BOOLEAN); }
 
  bool Boolean::operator< (const Expression& rhs) const
   {
@@ -885,24 +888,24 @@ namespace Sass {
 
   String::String(SourceSpan pstate, bool delayed)
   : Value(pstate, delayed)
-  { concrete_type(STRING); }
+  { tag_ = String_Tag; concrete_type(STRING); }
   String::String(const String* ptr)
   : Value(ptr)
-  { concrete_type(STRING); }
+  { tag_ = String_Tag; concrete_type(STRING); }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
 
   String_Schema::String_Schema(SourceSpan pstate, size_t size, bool css)
   : String(pstate), Vectorized<PreValueObj>(size), css_(css), hash_(0)
-  { concrete_type(STRING); }
+  { tag_ = String_Schema_Tag; concrete_type(STRING); }
 
   String_Schema::String_Schema(const String_Schema* ptr)
   : String(ptr),
     Vectorized<PreValueObj>(*ptr),
     css_(ptr->css_),
     hash_(ptr->hash_)
-  { concrete_type(STRING); }
+  { tag_ = String_Schema_Tag; concrete_type(STRING); }
 
   void String_Schema::rtrim()
   {
@@ -978,23 +981,23 @@ namespace Sass {
 
   String_Constant::String_Constant(SourceSpan pstate, sass::string val, bool css)
   : String(pstate), quote_mark_(0), value_(read_css_string(val, css)), hash_(0)
-  { }
+  { tag_ = String_Constant_Tag; }
   String_Constant::String_Constant(SourceSpan pstate, const char* beg, bool css)
   : String(pstate), quote_mark_(0), value_(read_css_string(sass::string(beg), css)), hash_(0)
-  { }
+  { tag_ = String_Constant_Tag; }
   String_Constant::String_Constant(SourceSpan pstate, const char* beg, const char* end, bool css)
   : String(pstate), quote_mark_(0), value_(read_css_string(sass::string(beg, end-beg), css)), hash_(0)
-  { }
+  { tag_ = String_Constant_Tag; }
   String_Constant::String_Constant(SourceSpan pstate, const Token& tok, bool css)
   : String(pstate), quote_mark_(0), value_(read_css_string(sass::string(tok.begin, tok.end), css)), hash_(0)
-  { }
+  { tag_ = String_Constant_Tag; }
 
   String_Constant::String_Constant(const String_Constant* ptr)
   : String(ptr),
     quote_mark_(ptr->quote_mark_),
     value_(ptr->value_),
     hash_(ptr->hash_)
-  { }
+  { tag_ = String_Constant_Tag; }
 
   bool String_Constant::is_invisible() const {
     return value_.empty() && quote_mark_ == 0;
@@ -1049,6 +1052,7 @@ namespace Sass {
     bool strict_unquoting, bool css)
   : String_Constant(pstate, val, css)
   {
+    tag_ = String_Quoted_Tag;
     if (skip_unquoting == false) {
       value_ = unquote(value_, &quote_mark_, keep_utf8_escapes, strict_unquoting);
     }
@@ -1057,7 +1061,7 @@ namespace Sass {
 
   String_Quoted::String_Quoted(const String_Quoted* ptr)
   : String_Constant(ptr)
-  { }
+  { tag_ = String_Quoted_Tag; }
 
   bool String_Quoted::operator< (const Expression& rhs) const
   {
@@ -1092,10 +1096,10 @@ namespace Sass {
 
   Null::Null(SourceSpan pstate)
   : Value(pstate)
-  { concrete_type(NULL_VAL); }
+  { tag_ = Null_Tag; concrete_type(NULL_VAL); }
 
   Null::Null(const Null* ptr) : Value(ptr)
-  { concrete_type(NULL_VAL); }
+  { tag_ = Null_Tag; concrete_type(NULL_VAL); }
 
   bool Null::operator< (const Expression& rhs) const
   {
@@ -1121,11 +1125,11 @@ namespace Sass {
 
   Parent_Reference::Parent_Reference(SourceSpan pstate)
   : Value(pstate)
-  { concrete_type(PARENT); }
+  { tag_ = Parent_Reference_Tag; concrete_type(PARENT); }
 
   Parent_Reference::Parent_Reference(const Parent_Reference* ptr)
   : Value(ptr)
-  { concrete_type(PARENT); }
+  { tag_ = Parent_Reference_Tag; concrete_type(PARENT); }
 
   /////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////
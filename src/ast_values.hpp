@@ -162,6 +162,9 @@ namespace Sass {
     HASH_PROPERTY(Function_Obj, func)
     ADD_PROPERTY(bool, via_call)
     ADD_PROPERTY(void*, cookie)
+    // normalized name to look up the definition
+    ADD_CONSTREF(EnvKey, key)
+    CallSiteCache cache_;
     mutable size_t hash_;
   public:
     Function_Call(SourceSpan pstate, sass::string n, Arguments_Obj args, void* cookie);
@@ -174,6 +177,7 @@ namespace Sass {
 
     sass::string name() const;
     bool is_css();
+    CallSiteCache& cache() { return cache_; }
 
     bool operator==(const Expression& rhs) const override;
 
@@ -187,9 +191,10 @@ namespace Sass {
   // Variable references.
   ///////////////////////
   class Variable final : public PreValue {
-    ADD_CONSTREF(sass::string, name)
+    ADD_CONSTREF(EnvKey, key)
   public:
     Variable(SourceSpan pstate, sass::string n);
+    const sass::string& name() const { return key_.name(); }
     virtual bool operator==(const Expression& rhs) const override;
     virtual size_t hash() const override;
     ATTACH_AST_OPERATIONS(Variable)
@@ -6,10 +6,8 @@
 
 namespace Sass {
 
-  sass::string Base64VLQ::encode(const int number) const
+  char* Base64VLQ::encode(char* out, const int number) const
   {
-    sass::string encoded = "";
-
     int vlq = to_vlq_signed(number);
 
     do {
@@ -18,10 +16,34 @@ namespace Sass {
       if (vlq > 0) {
         digit |= VLQ_CONTINUATION_BIT;
       }
-      encoded += base64_encode(digit);
+      *out++ = base64_encode(digit);
     } while (vlq > 0);
 
-    return encoded;
+    return out;
+  }
+
+  bool Base64VLQ::decode(const char*& cur, const char* end, int& number) const
+  {
+    int vlq = 0;
+    int shift = 0;
+    int digit = 0;
+    do {
+      if (cur == end) return false;
+      const char c = *cur++;
+      if (c >= 'A' && c <= 'Z') digit = c - 'A';
+      else if (c >= 'a' && c <= 'z') digit = c - 'a' + 26;
+      else if (c >= '0' && c <= '9') digit = c - '0' + 52;
+      else if (c == '+') digit = 62;
+      else if (c == '/') digit = 63;
+      else return false;
+      // more would overflow
+      if (shift > 25) return false;
+      vlq += (digit & VLQ_BASE_MASK) << shift;
+      shift += VLQ_BASE_SHIFT;
+    } while (digit & VLQ_CONTINUATION_BIT);
+
+    number = (vlq & 1) ? -(vlq >> 1) : (vlq >> 1);
+    return true;
   }
 
   char Base64VLQ::base64_encode(const int number) const
@@ -9,7 +9,13 @@ namespace Sass {
 
   public:
 
-    sass::string encode(const int number) const;
+    // writes [number] to [out] (7 chars at most)
+    // and returns the end of what was written
+    char* encode(char* out, const int number) const;
+
+    // reads one number from [cur] into [number] and advances
+    // [cur] past it, returns false if there is no valid one
+    bool decode(const char*& cur, const char* end, int& number) const;
 
   private:
 
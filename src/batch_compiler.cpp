@@ -0,0 +1,144 @@
+// sass.hpp must go before all system headers to get the
+// __EXTENSIONS__ fix on Solaris.
+#include "sass.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <system_error>
+
+#include "batch_compiler.hpp"
+
+namespace Sass {
+
+  // copies [from] to [to], but shares the custom
+  // functions, importers and headers of [from]
+  static void share_options(struct Sass_Options* to, struct Sass_Options* from)
+  {
+    char* input_path = to->input_path;
+    *to = *from;
+    to->input_path = input_path;
+    to->output_path = sass_copy_c_string(from->output_path);
+    to->plugin_path = sass_copy_c_string(from->plugin_path);
+    to->include_path = sass_copy_c_string(from->include_path);
+    to->source_map_file = sass_copy_c_string(from->source_map_file);
+    to->source_map_root = sass_copy_c_string(from->source_map_root);
+    to->plugin_paths = 0;
+    for (string_list* cur = from->plugin_paths; cur; cur = cur->next) {
+      sass_option_push_plugin_path(to, cur->string);
+    }
+    to->include_paths = 0;
+    for (string_list* cur = from->include_paths; cur; cur = cur->next) {
+      sass_option_push_include_path(to, cur->string);
+    }
+  }
+
+  BatchCompiler::BatchCompiler(const char* const* entries, size_t count, struct Sass_Options* options)
+  : options(options ? options : sass_make_options()),
+    // every stylesheet is kept until the batch is done
+    sheets(std::numeric_limits<size_t>::max() / 2),
+    executed(false),
+    failed(0)
+  {
+    if (!this->options->stylesheet_cache) this->options->stylesheet_cache = &sheets;
+    if (!this->options->directory_cache) this->options->directory_cache = &listings;
+    try {
+      contexts.reserve(count);
+      for (size_t i = 0; i < count; ++i) {
+        // errors are reported on the context
+        struct Sass_File_Context* ctx = sass_make_file_context(entries[i]);
+        if (ctx == 0) throw std::bad_alloc();
+        contexts.push_back(ctx);
+        share_options(ctx, this->options);
+      }
+    }
+    catch (...) {
+      // the destructor is not called
+      clear();
+      throw;
+    }
+  }
+
+  BatchCompiler::~BatchCompiler()
+  {
+    clear();
+  }
+
+  void BatchCompiler::clear()
+  {
+    for (struct Sass_File_Context* ctx : contexts) {
+      // owned by the shared options
+      ctx->c_functions = 0;
+      ctx->c_importers = 0;
+      ctx->c_headers = 0;
+      sass_delete_file_context(ctx);
+    }
+    contexts.clear();
+    sass_delete_options(options);
+    options = 0;
+  }
+
+  size_t BatchCompiler::execute(int threads)
+  {
+    if (executed) return failed;
+    executed = true;
+    if (threads <= 0) threads = std::thread::hardware_concurrency();
+    size_t workers = std::min<size_t>(std::max(threads, 1), contexts.size());
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> errors(0);
+    // built-ins are parsed once per thread
+    auto work = [this, &next, &errors]() {
+      for (size_t i = next++; i < contexts.size(); i = next++) {
+        if (sass_compile_file_context(contexts[i]) != 0) ++errors;
+      }
+    };
+    std::vector<std::thread> pool;
+    try {
+      // the calling thread is the last worker
+      while (pool.size() + 1 < workers) pool.emplace_back(work);
+    }
+    catch (std::system_error&) {
+      // make do with the ones we got
+    }
+    work();
+    for (std::thread& thread : pool) thread.join();
+    failed = errors;
+    return failed;
+  }
+
+  size_t BatchCompiler::getCount()
+  {
+    return contexts.size();
+  }
+
+  struct Sass_File_Context* BatchCompiler::getContext(size_t idx)
+  {
+    return idx < contexts.size() ? contexts[idx] : 0;
+  }
+
+}
+
+extern "C" {
+  using namespace Sass;
+
+  struct Sass_Batch_Compiler* ADDCALL sass_make_batch_compiler(const char* const* entries, size_t count, struct Sass_Options* options)
+  {
+    // caches must outlive the memory pool of any compiler
+    MemoryPoolScope scope(nullptr);
+    try { return new Sass_Batch_Compiler(entries, count, options); }
+    // the options are gone too
+    catch (...) { return 0; }
+  }
+
+  void ADDCALL sass_delete_batch_compiler(struct Sass_Batch_Compiler* batch)
+  {
+    MemoryPoolScope scope(nullptr);
+    delete batch;
+  }
+
+  size_t ADDCALL sass_batch_compiler_execute(struct Sass_Batch_Compiler* batch, int threads) { return batch->execute(threads); }
+  size_t ADDCALL sass_batch_compiler_get_count(struct Sass_Batch_Compiler* batch) { return batch->getCount(); }
+  struct Sass_File_Context* ADDCALL sass_batch_compiler_get_context(struct Sass_Batch_Compiler* batch, size_t idx) { return batch->getContext(idx); }
+
+}
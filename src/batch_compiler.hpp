@@ -0,0 +1,58 @@
+#ifndef SASS_BATCH_COMPILER_H
+#define SASS_BATCH_COMPILER_H
+
+// sass.hpp must go before all system headers to get the
+// __EXTENSIONS__ fix on Solaris.
+#include "sass.hpp"
+
+#include "sass_context.hpp"
+#include "stylesheet_cache.hpp"
+#include "directory_cache.hpp"
+
+namespace Sass {
+
+  // Compiles many entry points with the same options on a pool of
+  // threads. Every entry point gets its own file context, which holds
+  // its output, source map and errors. They share the custom functions
+  // and importers of the options, parsed stylesheets and the directory
+  // listings. Built-in functions are parsed once per worker thread.
+  class BatchCompiler {
+
+  private:
+
+    // shared by all contexts
+    struct Sass_Options* options;
+    sass::vector<struct Sass_File_Context*> contexts;
+    Sass_Stylesheet_Cache sheets;
+    Sass_Directory_Cache listings;
+    bool executed;
+    size_t failed;
+
+    // Deletes all contexts and the options
+    void clear();
+
+  public:
+
+    // Takes over [options] like `sass_file_context_set_options`
+    // (they are deleted as well if the constructor throws)
+    BatchCompiler(const char* const* entries, size_t count, struct Sass_Options* options);
+    ~BatchCompiler();
+
+    // Compiles all entry points on [threads] threads (0 = one per core)
+    // and returns the number of entry points that failed to compile
+    size_t execute(int threads);
+
+    size_t getCount();
+    struct Sass_File_Context* getContext(size_t idx);
+
+  };
+
+}
+
+// The opaque handle for the C-API
+struct Sass_Batch_Compiler : public Sass::BatchCompiler {
+  Sass_Batch_Compiler(const char* const* entries, size_t count, struct Sass_Options* options)
+  : BatchCompiler(entries, count, options) {}
+};
+
+#endif
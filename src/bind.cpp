@@ -34,7 +34,7 @@ namespace Sass {
       Parameter_Obj  p = ps->at(i);
       param_map[p->name()] = p;
       // if (p->default_value()) {
-      //   env->local_frame()[p->name()] = p->default_value()->perform(eval->with(env));
+      //   env->local_frame()[p->key()] = p->default_value()->perform(eval->with(env));
       // }
     }
 
@@ -86,7 +86,7 @@ namespace Sass {
                 }
               }
               // assign new arglist to environment
-              env->local_frame()[p->name()] = arglist;
+              env->local_frame()[p->key()] = arglist;
             }
           // invalid state
           else {
@@ -96,7 +96,7 @@ namespace Sass {
 
           // expand keyword arguments into their parameters
           List* arglist = SASS_MEMORY_NEW(List, p->pstate(), 0, SASS_COMMA, true);
-          env->local_frame()[p->name()] = arglist;
+          env->local_frame()[p->key()] = arglist;
           Map_Obj argmap = Cast<Map>(a->value());
           for (auto key : argmap->keys()) {
             if (String_Constant_Obj str = Cast<String_Constant>(key)) {
@@ -164,7 +164,7 @@ namespace Sass {
             }
           }
           // assign new arglist to environment
-          env->local_frame()[p->name()] = arglist;
+          env->local_frame()[p->key()] = arglist;
         }
         // consumed parameter
         ++ip;
@@ -242,14 +242,14 @@ namespace Sass {
       }
 
       if (a->name().empty()) {
-        if (env->has_local(p->name())) {
+        if (env->has_local(p->key())) {
           sass::ostream msg;
           msg << "parameter " << p->name()
           << " provided more than once in call to " << callee;
           error(msg.str(), a->pstate(), traces);
         }
         // ordinal arg -- bind it to the next param
-        env->local_frame()[p->name()] = a->value();
+        env->local_frame()[p->key()] = a->value();
         ++ip;
       }
       else {
@@ -290,13 +290,13 @@ namespace Sass {
       // cerr << "env for default params:" << endl;
       // env->print();
       // cerr << "********" << endl;
-      if (!env->has_local(leftover->name())) {
+      if (!env->has_local(leftover->key())) {
         if (leftover->is_rest_parameter()) {
-          env->local_frame()[leftover->name()] = varargs;
+          env->local_frame()[leftover->key()] = varargs;
         }
         else if (leftover->default_value()) {
           Expression* dv = leftover->default_value()->perform(eval);
-          env->local_frame()[leftover->name()] = dv;
+          env->local_frame()[leftover->key()] = dv;
         }
         else {
           // param is unbound and has no default value -- error
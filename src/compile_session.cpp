@@ -0,0 +1,183 @@
+// sass.hpp must go before all system headers to get the
+// __EXTENSIONS__ fix on Solaris.
+#include "sass.hpp"
+
+#include <cstring>
+
+#include "compile_session.hpp"
+#include "sass_context.hpp"
+#include "file.hpp"
+
+namespace Sass {
+
+  CompileSession::CompileSession(size_t max_sheets)
+  : sheets(max_sheets),
+    generation(0),
+    compiled(0),
+    reused(0)
+  { }
+
+  // appends [str] and a separator no option can contain
+  static void add_key(sass::string& key, const char* str)
+  {
+    if (str) key += str;
+    key += '\0';
+  }
+
+  sass::string CompileSession::result_key(struct Sass_File_Context* ctx)
+  {
+    // anything may happen in there
+    if (ctx->c_functions || ctx->c_importers || ctx->c_headers) return "";
+    // the output was handed off
+    if (ctx->output_sink) return "";
+    sass::string key;
+    // relative paths resolve from here
+    add_key(key, File::get_cwd().c_str());
+    add_key(key, ctx->input_path);
+    add_key(key, ctx->output_path);
+    add_key(key, std::to_string(ctx->output_style).c_str());
+    add_key(key, std::to_string(ctx->precision).c_str());
+    add_key(key, ctx->indent);
+    add_key(key, ctx->linefeed);
+    add_key(key, ctx->source_comments ? "1" : "0");
+    add_key(key, ctx->source_map_embed ? "1" : "0");
+    add_key(key, ctx->source_map_contents ? "1" : "0");
+    add_key(key, ctx->source_map_file_urls ? "1" : "0");
+    add_key(key, ctx->omit_source_map_url ? "1" : "0");
+    add_key(key, ctx->is_indented_syntax_src ? "1" : "0");
+    add_key(key, ctx->source_map_file);
+    add_key(key, ctx->source_map_root);
+    add_key(key, ctx->include_path);
+    for (string_list* cur = ctx->include_paths; cur; cur = cur->next) {
+      add_key(key, cur->string);
+    }
+    add_key(key, ctx->plugin_path);
+    for (string_list* cur = ctx->plugin_paths; cur; cur = cur->next) {
+      add_key(key, cur->string);
+    }
+    return key;
+  }
+
+  int CompileSession::compile(struct Sass_File_Context* ctx)
+  {
+    if (ctx == 0) return 1;
+    if (ctx->error_status) return ctx->error_status;
+    // results outlive the memory pool of the compiler
+    MemoryPoolScope scope(nullptr);
+    sass::string key(result_key(ctx));
+    size_t started;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = key.empty() ? results.end() : results.find(key);
+      if (it != results.end()) {
+        const Result& result = it->second;
+        ctx->output_string = sass_copy_c_string(result.output.c_str());
+        if (result.has_srcmap) ctx->source_map_string = sass_copy_c_string(result.srcmap.c_str());
+        size_t count = result.included.size();
+        ctx->included_files = (char**) calloc(count + 1, sizeof(char*));
+        if (ctx->included_files == 0) throw std::bad_alloc();
+        for (size_t i = 0; i < count; ++i) {
+          ctx->included_files[i] = sass_copy_c_string(result.included[i].c_str());
+        }
+        reused += 1;
+        return 0;
+      }
+      started = generation;
+      compiled += 1;
+    }
+
+    // share parsed sheets and listings
+    struct Sass_Stylesheet_Cache* stylesheet_cache = ctx->stylesheet_cache;
+    struct Sass_Directory_Cache* directory_cache = ctx->directory_cache;
+    if (!stylesheet_cache) ctx->stylesheet_cache = &sheets;
+    if (!directory_cache) ctx->directory_cache = &listings;
+    int status = sass_compile_file_context(ctx);
+    ctx->stylesheet_cache = stylesheet_cache;
+    ctx->directory_cache = directory_cache;
+    if (status != 0 || key.empty()) return status;
+
+    Result result;
+    result.output = ctx->output_string ? ctx->output_string : "";
+    result.has_srcmap = ctx->source_map_string != 0;
+    if (result.has_srcmap) result.srcmap = ctx->source_map_string;
+    for (char** file = ctx->included_files; file && *file; ++file) {
+      result.included.push_back(*file);
+    }
+
+    sass::string cwd(File::get_cwd());
+    std::lock_guard<std::mutex> lock(mutex);
+    // a file may have changed while we compiled
+    if (generation != started) return status;
+    for (const sass::string& file : result.included) {
+      dependents[File::rel2abs(file, ".", cwd)].insert(key);
+    }
+    results[key] = std::move(result);
+    return status;
+  }
+
+  void CompileSession::changed(const sass::string& path)
+  {
+    MemoryPoolScope scope(nullptr);
+    // added or removed files may resolve imports differently
+    bool resolved = listings.changed(path);
+    sass::string abs_path(File::rel2abs(path, ".", File::get_cwd()));
+    std::lock_guard<std::mutex> lock(mutex);
+    generation += 1;
+    if (!resolved) {
+      results.clear();
+      dependents.clear();
+      return;
+    }
+    auto it = dependents.find(abs_path);
+    if (it == dependents.end()) return;
+    for (const sass::string& key : it->second) {
+      results.erase(key);
+    }
+    dependents.erase(it);
+  }
+
+  size_t CompileSession::getCompiled()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return compiled;
+  }
+
+  size_t CompileSession::getReused()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reused;
+  }
+
+}
+
+extern "C" {
+  using namespace Sass;
+
+  struct Sass_Session* ADDCALL sass_make_session(size_t max_sheets)
+  {
+    // must outlive the memory pool of any compiler
+    MemoryPoolScope scope(nullptr);
+    return new Sass_Session(max_sheets);
+  }
+
+  void ADDCALL sass_delete_session(struct Sass_Session* session)
+  {
+    MemoryPoolScope scope(nullptr);
+    delete session;
+  }
+
+  int ADDCALL sass_session_compile_file_context(struct Sass_Session* session, struct Sass_File_Context* ctx)
+  {
+    return session->compile(ctx);
+  }
+
+  void ADDCALL sass_session_file_changed(struct Sass_Session* session, const char* path)
+  {
+    if (path) session->changed(path);
+  }
+
+  size_t ADDCALL sass_session_get_compiled(struct Sass_Session* session) { return session->getCompiled(); }
+  size_t ADDCALL sass_session_get_reused(struct Sass_Session* session) { return session->getReused(); }
+
+}
@@ -0,0 +1,78 @@
+#ifndef SASS_COMPILE_SESSION_H
+#define SASS_COMPILE_SESSION_H
+
+// sass.hpp must go before all system headers to get the
+// __EXTENSIONS__ fix on Solaris.
+#include "sass.hpp"
+
+#include <map>
+#include <set>
+#include <mutex>
+
+#include "stylesheet_cache.hpp"
+#include "directory_cache.hpp"
+
+namespace Sass {
+
+  // Compiles the same entry points over and over again (i.e. watch mode).
+  // The session remembers the output of every entry point together with
+  // all files it imported and hands it out again until one of those files
+  // is reported as changed. Entry points that must be compiled again reuse
+  // the parsed sheets of all unchanged files via a stylesheet cache and
+  // the directory listings to resolve their imports. Adding or removing a
+  // file may change how any import resolves, so that invalidates all of
+  // them. Entry points with custom functions, importers or headers are
+  // always compiled, as are the ones that failed before.
+  class CompileSession {
+
+  private:
+
+    struct Result {
+      sass::string output;
+      sass::string srcmap;
+      bool has_srcmap;
+      // as reported on the context
+      sass::vector<sass::string> included;
+    };
+
+    std::mutex mutex;
+    Sass_Stylesheet_Cache sheets;
+    Sass_Directory_Cache listings;
+    // results by `result_key`
+    std::map<sass::string, Result> results;
+    // absolute path of every file to the result
+    // keys of the entry points that import it
+    std::map<sass::string, std::set<sass::string>> dependents;
+    // bumped on every change notification
+    size_t generation;
+    size_t compiled;
+    size_t reused;
+
+    // Options that influence the output (empty if it can't be reused)
+    static sass::string result_key(struct Sass_File_Context* ctx);
+
+  public:
+
+    // Keeps at most [max_sheets] parsed stylesheets
+    CompileSession(size_t max_sheets);
+
+    // Like `sass_compile_file_context`, but reuses results
+    int compile(struct Sass_File_Context* ctx);
+
+    // [path] was modified, added or removed
+    void changed(const sass::string& path);
+
+    size_t getCompiled();
+    size_t getReused();
+
+  };
+
+}
+
+// The opaque handle for the C-API
+struct Sass_Session : public Sass::CompileSession {
+  Sass_Session(size_t max_sheets)
+  : CompileSession(max_sheets) {}
+};
+
+#endif
@@ -3,6 +3,9 @@
 #include "sass.hpp"
 #include "ast.hpp"
 
+#include <memory>
+#include <cstring>
+
 #include "remove_placeholders.hpp"
 #include "sass_functions.hpp"
 #include "check_nesting.hpp"
@@ -18,6 +21,10 @@
 #include "parser.hpp"
 #include "cssize.hpp"
 #include "source.hpp"
+#include "import_prefetch.hpp"
+#include "stylesheet_cache.hpp"
+#include "directory_cache.hpp"
+#include "util_string.hpp"
 
 namespace Sass {
   using namespace Constants;
@@ -59,6 +66,9 @@ namespace Sass {
     traces(),
     extender(Extender::NORMAL, traces),
     c_compiler(NULL),
+    prefetch(nullptr),
+    stylesheet_cache(c_ctx.stylesheet_cache),
+    directory_cache(c_ctx.directory_cache),
 
     c_headers               (sass::vector<Sass_Importer_Entry>()),
     c_importers             (sass::vector<Sass_Importer_Entry>()),
@@ -96,6 +106,11 @@ namespace Sass {
 
     emitter.set_filename(abs2rel(output_path, source_map_file, CWD));
 
+    // only read directories once per compilation
+    if (directory_cache == nullptr) {
+      directory_cache = new DirectoryCache();
+    }
+
   }
 
   void Context::add_c_function(Sass_Function_Entry function)
@@ -117,9 +132,9 @@ namespace Sass {
 
   Context::~Context()
   {
-    // resources were allocated by malloc
+    // resources were allocated by malloc (or mapped)
     for (size_t i = 0; i < resources.size(); ++i) {
-      free(resources[i].contents);
+      free_file(resources[i].contents, resources[i].mapped);
       free(resources[i].srcmap);
     }
     // free all strings we kept alive during compiler execution
@@ -134,6 +149,11 @@ namespace Sass {
     // clear inner structures (vectors) and input source
     resources.clear(); import_stack.clear();
     sheets.clear();
+    // shared listings are owned by the caller
+    if (directory_cache != c_options.directory_cache) {
+      MemoryPoolScope scope(nullptr);
+      delete directory_cache;
+    }
   }
 
   Data_Context::~Data_Context()
@@ -222,12 +242,12 @@ namespace Sass {
     // make sure we resolve against an absolute path
     sass::string base_path(rel2abs(import.base_path));
     // first try to resolve the load path relative to the base path
-    sass::vector<Include> vec(resolve_includes(base_path, import.imp_path));
+    sass::vector<Include> vec(resolve_includes(base_path, import.imp_path, directory_cache));
     // then search in every include path (but only if nothing found yet)
     for (size_t i = 0, S = include_paths.size(); vec.size() == 0 && i < S; ++i)
     {
       // call resolve_includes and individual base path and append all results
-      sass::vector<Include> resolved(resolve_includes(include_paths[i], import.imp_path));
+      sass::vector<Include> resolved(resolve_includes(include_paths[i], import.imp_path, directory_cache));
       if (resolved.size()) vec.insert(vec.end(), resolved.begin(), resolved.end());
     }
     // return vector
@@ -253,6 +273,21 @@ namespace Sass {
     // tell emitter about new resource
     emitter.add_source_index(idx);
 
+    // mappings into it are remapped through its source map
+    if (res.srcmap && (source_map_file != "" || c_options.source_map_embed)) {
+      InputSourceMap map;
+      if (map.parse(res.srcmap)) {
+        sass::string base(File::dir_name(inc.abs_path));
+        for (sass::string& source : map.sources) {
+          // urls are linked as they are
+          if (source.find("://") != sass::string::npos) continue;
+          // relative to the source map output file
+          source = abs2rel(rel2abs(source, base, CWD), source_map_file, CWD);
+        }
+        emitter.add_input_map(idx, std::move(map));
+      }
+    }
+
     // put resources under our control
     // the memory will be freed later
     resources.push_back(res);
@@ -274,8 +309,36 @@ namespace Sass {
 
     // get pointer to the loaded content
     const char* contents = resources[idx].contents;
-    SourceFileObj source = SASS_MEMORY_NEW(SourceFile,
-      inc.abs_path.c_str(), contents, idx);
+    SourceFileObj source; Block_Obj root;
+    sass::vector<DeferredImport> deferred;
+    // imports of cached sheets are owned by the cache
+    sass::vector<DeferredImport>* imports = &deferred;
+    // pool of a tree that may outlive us
+    MemoryPoolPtr pool;
+    bool cached = false;
+    // take the ast from an earlier compilation
+    if (stylesheet_cache && stylesheet_cache->lease(c_compiler,
+        inc.abs_path, contents, source, root, imports, pool)) {
+      source->setSrcId(idx);
+      cached = true;
+    }
+    // take the ast if it has been parsed ahead of time
+    else if (prefetch && prefetch->take(inc.abs_path, contents, source, root, deferred, pool)) {
+      source->setSrcId(idx);
+    }
+    // cached sheets get their own pool
+    else if (stylesheet_cache) {
+      pool = makeSharedPool();
+    }
+    // our nodes will reference the tree
+    retainPool(c_compiler->pool, pool);
+    MemoryPool* tree_pool = pool ? pool.get() : c_compiler->pool;
+    // the resource outlives it (unless cached)
+    if (source.isNull()) {
+      MemoryPoolScope scope(tree_pool);
+      source = SASS_MEMORY_NEW(SourceFile,
+        inc.abs_path.c_str(), contents, idx, true, res.length);
+    }
 
     // create the initial parser state from resource
     SourceSpan pstate(source);
@@ -298,13 +361,36 @@ namespace Sass {
       }
     }
 
-    // create a parser instance from the given c_str buffer
-    Parser p(source, *this, traces);
     // do not yet dispose these buffers
     sass_import_take_source(import);
     sass_import_take_srcmap(import);
-    // then parse the root block
-    Block_Obj root = p.parse();
+    // otherwise parse it now, but still let the
+    // workers know about its imports right away
+    if (prefetch && root.isNull()) {
+      MemoryPoolScope scope(tree_pool);
+      root = prefetch->parse(source, deferred);
+    }
+    // cached sheets must not resolve their imports yet
+    else if (stylesheet_cache && root.isNull()) {
+      MemoryPoolScope scope(tree_pool);
+      root = parse_deferred(source, deferred);
+    }
+    // resolve imports in document order
+    if (!root.isNull()) {
+      // share it with later compilations
+      if (stylesheet_cache && !cached) {
+        stylesheet_cache->insert(c_compiler,
+          inc.abs_path, source, root, imports, pool);
+      }
+      resolve_deferred(*imports, source->getPath(), tree_pool);
+    }
+    // or parse and resolve them as we go
+    else {
+      // create a parser instance from the given c_str buffer
+      Parser p(source, *this, traces);
+      // then parse the root block
+      root = p.parse();
+    }
     // delete memory of current stack frame
     sass_delete_import(import_stack.back());
     // remove current stack frame
@@ -325,6 +411,65 @@ namespace Sass {
     traces.pop_back();
   }
 
+  // Resolve the imports of a file parsed with deferred imports. This
+  // does exactly what the parser would have done on every @import.
+  // The changes to the tree are allocated from its [pool], since
+  // the tree may outlive us when it is shared via the cache.
+  void Context::resolve_deferred(sass::vector<DeferredImport>& imports, const char* ctx_path, MemoryPool* pool)
+  {
+    for (DeferredImport& deferred : imports) {
+      Import* imp = deferred.imp;
+      resolve_import(imp, deferred.locations, ctx_path, deferred.pstate);
+      // copy what we resolved into the pool of the tree
+      MemoryPoolScope scope(pool);
+      sass::vector<Expression_Obj> urls(imp->urls());
+      sass::vector<Include> incs(imp->incs());
+      imp->urls().swap(urls);
+      imp->incs().swap(incs);
+    }
+    MemoryPoolScope scope(pool);
+    // insert from the back so the indexes of earlier ones stay valid
+    for (auto it = imports.rbegin(); it != imports.rend(); ++it) {
+      Import* imp = it->imp;
+      Block* block = it->block;
+      size_t index = it->index;
+      // if it is a url, we only add the statement
+      if (!imp->urls().empty()) block->insert(block->begin() + index++, imp);
+      // process all resources now (add Import_Stub nodes)
+      for (size_t i = 0, S = imp->incs().size(); i < S; ++i) {
+        block->insert(block->begin() + index++,
+          SASS_MEMORY_NEW(Import_Stub, it->pstate, imp->incs()[i]));
+      }
+      it->inserted = index - it->index;
+    }
+  }
+
+  Block_Obj Context::parse_deferred(SourceFile* source, sass::vector<DeferredImport>& imports)
+  {
+    try {
+      Parser p(source, *this, {});
+      p.deferred = &imports;
+      return p.parse();
+    }
+    // it will be parsed again to report the error
+    catch (...) {
+      imports.clear();
+      return {};
+    }
+  }
+
+  // Registers the entry file, which loads all imports
+  void Context::register_entry(const Include& inc, const Resource& res)
+  {
+    // custom importers may resolve any import differently
+    if (!c_importers.empty() || !c_headers.empty()) {
+      stylesheet_cache = nullptr;
+    }
+    // parse imports on worker threads (if enabled)
+    ImportPrefetch imports(*this, c_options.import_threads);
+    register_resource(inc, res);
+  }
+
   // Add a new import to the context (called from `import_url`)
   Include Context::load_import(const Importer& imp, SourceSpan pstate)
   {
@@ -352,9 +497,13 @@ namespace Sass {
       if (use_cache && sheets.count(resolved[0].abs_path)) return resolved[0];
       // try to read the content of the resolved file entry
       // the memory buffer returned must be freed by us!
-      if (char* contents = read_file(resolved[0].abs_path)) {
+      size_t mapped = 0, length = 0;
+      size_t* map = c_options.map_source_files ? &mapped : nullptr;
+      if (char* contents = prefetch ?
+        prefetch->read_file(resolved[0].abs_path, map, &length) :
+        read_file(resolved[0].abs_path, map, &length)) {
         // register the newly resolved file resource
-        register_resource(resolved[0], { contents, 0 }, pstate);
+        register_resource(resolved[0], { contents, 0, mapped, length }, pstate);
         // return resolved entry
         return resolved[0];
       }
@@ -365,6 +514,20 @@ namespace Sass {
 
   }
 
+  void Context::resolve_import(Import* imp, const sass::vector<std::pair<sass::string, Function_Call_Obj>>& locations, const char* ctx_path, SourceSpan& pstate)
+  {
+    for (auto location : locations) {
+      if (location.second) {
+        imp->urls().push_back(location.second);
+      }
+      // check if custom importers want to take over the handling
+      else if (!call_importers(unquote(location.first), ctx_path, pstate, imp)) {
+        // nobody wants it, so we do our import
+        import_url(imp, location.first, ctx_path);
+      }
+    }
+  }
+
   void Context::import_url (Import* imp, sass::string load_path, const sass::string& ctx_path) {
 
     SourceSpan pstate(imp->pstate());
@@ -442,7 +605,7 @@ namespace Sass {
           if (const char* err_message = sass_import_get_error_message(include_ent)) {
             if (source || srcmap) register_resource({ importer, uniq_path }, { source, srcmap }, pstate);
             if (line == sass::string::npos && column == sass::string::npos) error(err_message, pstate, traces);
-            else { error(err_message, { pstate.source, { line, column } }, traces); }
+            else { error(err_message, { SASS_MEMORY_NEW(PosFile, pstate.source, Offset(line, column)) }, traces); }
           }
           // content for import was set
           else if (source) {
@@ -489,33 +652,67 @@ namespace Sass {
   void register_built_in_functions(Context&, Env* env);
   void register_c_functions(Context&, Env* env, Sass_Function_List);
   void register_c_function(Context&, Env* env, Sass_Function_Entry);
+  Env* get_built_in_functions(Context&);
 
   char* Context::render(Block_Obj root)
   {
     // check for valid block
     if (!root) return 0;
+    // hand the output to the sink while rendering
+    Sass_Output_Sink sink = c_options.output_sink;
+    if (sink) {
+      // only keep mappings if a source map is rendered
+      bool mappings = source_map_file != "" ||
+        (c_options.source_map_embed && !c_options.omit_source_map_url);
+      // only sources can bring chars above 127 (escapes too)
+      bool ascii = c_functions.empty() && !c_options.source_comments;
+      for (size_t i = 0; ascii && i < resources.size(); ++i) {
+        const char* contents = resources[i].contents;
+        if (contents == nullptr) continue;
+        size_t size = resources[i].length;
+        if (size == sass::string::npos) size = std::strlen(contents);
+        ascii = Util::ascii_only(contents, contents + size)
+          && std::memchr(contents, '\\', size) == nullptr;
+      }
+      emitter.stream(root, sink, c_options.output_sink_cookie, mappings, ascii);
+    }
     // start the render process
-    root->perform(&emitter);
+    else root->perform(&emitter);
     // finish emitter stream
     emitter.finalize();
     // get the resulting buffer from stream
-    OutputBuffer emitted = emitter.get_buffer();
+    const OutputBuffer& emitted = emitter.get_buffer();
+    // hand over the rest before the source map is rendered
+    emitter.flush_output(true);
     // should we append a source map url?
+    sass::string footer;
     if (!c_options.omit_source_map_url) {
       // generate an embedded source map
       if (c_options.source_map_embed) {
-        emitted.buffer += linefeed;
-        emitted.buffer += format_embedded_source_map();
+        footer += linefeed;
+        append_embedded_source_map(footer);
       }
       // or just link the generated one
       else if (source_map_file != "") {
-        emitted.buffer += linefeed;
-        emitted.buffer += format_source_mapping_url(source_map_file);
+        footer += linefeed;
+        footer += format_source_mapping_url(source_map_file);
       }
     }
-    // create a copy of the resulting buffer string
+    // the sink got everything else already
+    if (sink) {
+      if (!footer.empty()) sink(footer.data(), footer.size(), c_options.output_sink_cookie);
+      return sass_copy_c_string("");
+    }
+    // join all parts in one go into the resulting string
     // this must be freed or taken over by implementor
-    return sass_copy_c_string(emitted.buffer.c_str());
+    const sass::string& header(emitted.header);
+    const sass::string& buffer(emitted.buffer);
+    char* result = (char*) sass_alloc_memory(header.size() + buffer.size() + footer.size() + 1);
+    std::memcpy(result, header.data(), header.size());
+    std::memcpy(result + header.size(), buffer.data(), buffer.size());
+    std::memcpy(result + header.size() + buffer.size(), footer.data(), footer.size());
+    result[header.size() + buffer.size() + footer.size()] = '\0';
+    return result;
   }
 
   void Context::apply_custom_headers(Block_Obj root, const char* ctx_path, SourceSpan pstate)
@@ -546,7 +743,9 @@ namespace Sass {
     sass::string abs_path(rel2abs(input_path, CWD));
 
     // try to load the entry file
-    char* contents = read_file(abs_path);
+    size_t mapped = 0, length = 0;
+    size_t* map = c_options.map_source_files ? &mapped : nullptr;
+    char* contents = read_file(abs_path, map, &length);
 
     // alternatively also look inside each include path folder
     // I think this differs from ruby sass (IMO too late to remove)
@@ -554,7 +753,7 @@ namespace Sass {
       // build absolute path for this include path entry
       abs_path = rel2abs(input_path, include_paths[i]);
       // try to load the resulting path
-      contents = read_file(abs_path);
+      contents = read_file(abs_path, map, &length);
     }
 
     // abort early if no content could be loaded (various reasons)
@@ -576,7 +775,7 @@ namespace Sass {
     import_stack.push_back(import);
 
     // create the source entry for file entry
-    register_resource({{ input_path, "." }, abs_path }, { contents, 0 });
+    register_entry({{ input_path, "." }, abs_path }, { contents, 0, mapped, length });
 
     // create root ast tree node
     return compile();
@@ -618,7 +817,7 @@ namespace Sass {
     import_stack.push_back(import);
 
     // register a synthetic resource (path does not really exist, skip in includes)
-    register_resource({{ input_path, "." }, input_path }, { source_c_str, srcmap_c_str });
+    register_entry({{ input_path, "." }, input_path }, { source_c_str, srcmap_c_str });
 
     // create root ast tree node
     return compile();
@@ -633,9 +832,10 @@ namespace Sass {
     Block_Obj root = sheets.at(entry_path).root;
     // abort on invalid root
     if (root.isNull()) return {};
-    Env global; // create root environment
-    // register built-in functions on env
-    register_built_in_functions(*this, &global);
+    // create root environment linked
+    // to the shared built-in functions
+    Env global(get_built_in_functions(*this));
+    global.generations(&definition_generations);
     // register custom functions (defined via C-API)
     for (size_t i = 0, S = c_functions.size(); i < S; ++i)
     { register_c_function(*this, &global, c_functions[i]); }
@@ -673,16 +873,11 @@ namespace Sass {
   }
   // EO compile
 
-  sass::string Context::format_embedded_source_map()
+  void Context::append_embedded_source_map(sass::string& out)
   {
-    sass::string map = emitter.render_srcmap(*this);
-    sass::istream is( map.c_str() );
-    sass::ostream buffer;
-    base64::encoder E;
-    E.encode(is, buffer);
-    sass::string url = "data:application/json;base64," + buffer.str();
-    url.erase(url.size() - 1);
-    return "/*# sourceMappingURL=" + url + " */";
+    out += "/*# sourceMappingURL=data:application/json;base64,";
+    emitter.render_srcmap(*this, out, true);
+    out += " */";
   }
 
   sass::string Context::format_source_mapping_url(const sass::string& file)
@@ -694,7 +889,8 @@ namespace Sass {
   char* Context::render_srcmap()
   {
     if (source_map_file == "") return 0;
-    sass::string map = emitter.render_srcmap(*this);
+    sass::string map;
+    emitter.render_srcmap(*this, map);
     return sass_copy_c_string(map.c_str());
   }
 
@@ -717,16 +913,16 @@ namespace Sass {
   {
     Definition* def = make_native_function(sig, f, ctx);
     def->environment(env);
-    (*env)[def->name() + "[f]"] = def;
+    env->set_local(def->key(), def);
   }
 
   void register_function(Context& ctx, Signature sig, Native_Function f, size_t arity, Env* env)
   {
     Definition* def = make_native_function(sig, f, ctx);
     sass::ostream ss;
-    ss << def->name() << "[f]" << arity;
+    ss << def->name() << "[" << arity << "]";
     def->environment(env);
-    (*env)[ss.str()] = def;
+    env->set_local(EnvKey(ss.str(), EnvKey::FUNCTION), def);
   }
 
   void register_overload_stub(Context& ctx, sass::string name, Env* env)
@@ -738,7 +934,7 @@ namespace Sass {
                                        Parameters_Obj{},
                                        nullptr,
                                        true);
-    (*env)[name + "[f]"] = stub;
+    env->set_local(stub->key(), stub);
   }
 
 
@@ -846,6 +1042,27 @@ namespace Sass {
     register_function(ctx, selector_parse_sig, selector_parse, env);
   }
 
+  // Built-in functions only depend on their static signatures, so they
+  // are parsed once per thread into a frame that is shared read-only by
+  // every compilation on that thread. It is not shared between threads,
+  // since evaluating the definitions updates their reference counters.
+  // The frame has its own pool, which every compiler using it retains.
+  Env* get_built_in_functions(Context& ctx)
+  {
+    // destroyed after the frame
+    static thread_local MemoryPoolPtr pool;
+    static thread_local std::unique_ptr<Env> built_ins;
+    if (!built_ins) {
+      pool = makeSharedPool();
+      MemoryPoolScope scope(pool.get());
+      built_ins.reset(new Env());
+      built_ins->is_shared(true);
+      register_built_in_functions(ctx, built_ins.get());
+    }
+    if (ctx.c_compiler) retainPool(ctx.c_compiler->pool, pool);
+    return built_ins.get();
+  }
+
   void register_c_functions(Context& ctx, Env* env, Sass_Function_List descrs)
   {
     while (descrs && *descrs) {
@@ -857,7 +1074,7 @@ namespace Sass {
   {
     Definition* def = make_c_function(descr, ctx);
     def->environment(env);
-    (*env)[def->name() + "[f]"] = def;
+    env->set_local(def->key(), def);
   }
 
 }
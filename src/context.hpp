@@ -6,10 +6,6 @@
 #include "sass.hpp"
 #include "ast.hpp"
 
-
-#define BUFFERSIZE 255
-#include "b64/encode.h"
-
 #include "sass_context.hpp"
 #include "stylesheet.hpp"
 #include "plugins.hpp"
@@ -17,15 +13,22 @@
 
 namespace Sass {
 
+  class ImportPrefetch;
+  class StylesheetCache;
+  class DirectoryCache;
+  struct DeferredImport;
+
   class Context {
   public:
     void import_url (Import* imp, sass::string load_path, const sass::string& ctx_path);
+    void resolve_import(Import* imp, const sass::vector<std::pair<sass::string, Function_Call_Obj>>& locations, const char* ctx_path, SourceSpan& pstate);
     bool call_headers(const sass::string& load_path, const char* ctx_path, SourceSpan& pstate, Import* imp)
     { return call_loader(load_path, ctx_path, pstate, imp, c_headers, false); };
     bool call_importers(const sass::string& load_path, const char* ctx_path, SourceSpan& pstate, Import* imp)
     { return call_loader(load_path, ctx_path, pstate, imp, c_importers, true); };
 
   private:
+    void resolve_deferred(sass::vector<DeferredImport>& imports, const char* ctx_path, MemoryPool* pool);
     bool call_loader(const sass::string& load_path, const char* ctx_path, SourceSpan& pstate, Import* imp, sass::vector<Sass_Importer_Entry> importers, bool only_one = true);
 
   public:
@@ -49,8 +52,21 @@ namespace Sass {
     sass::vector<Backtrace> traces;
     Extender extender;
 
+    // redeclarations of functions and mixins
+    // (to invalidate the call site caches)
+    DefinitionGenerations definition_generations;
+
     struct Sass_Compiler* c_compiler;
 
+    // parses imports ahead of time (if enabled)
+    ImportPrefetch* prefetch;
+
+    // parsed sheets shared between compilations (optional)
+    StylesheetCache* stylesheet_cache;
+
+    // listings to resolve imports (shared or our own)
+    DirectoryCache* directory_cache;
+
     // absolute paths to includes
     sass::vector<sass::string> included_files;
     // relative includes for sourcemap
@@ -86,6 +102,9 @@ namespace Sass {
 
     void register_resource(const Include&, const Resource&);
     void register_resource(const Include&, const Resource&, SourceSpan&);
+    void register_entry(const Include&, const Resource&);
+    // parses without resolving imports, returns null on errors
+    Block_Obj parse_deferred(SourceFile* source, sass::vector<DeferredImport>& imports);
     sass::vector<Include> find_includes(const Importer& import);
     Include load_import(const Importer&, SourceSpan pstate);
 
@@ -97,7 +116,7 @@ namespace Sass {
     void collect_plugin_paths(string_list* paths_array);
     void collect_include_paths(const char* paths_str);
     void collect_include_paths(string_list* paths_array);
-    sass::string format_embedded_source_map();
+    void append_embedded_source_map(sass::string& out);
     sass::string format_source_mapping_url(const sass::string& out_path);
 
 
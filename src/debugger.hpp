@@ -310,8 +310,8 @@ inline sass::string longToHex(long long t) {
 inline sass::string pstate_source_position(AST_Node* node)
 {
   sass::sstream str;
-  Offset start(node->pstate().position);
-  Offset end(start + node->pstate().offset);
+  Offset start(node->pstate().getPosition());
+  Offset end(node->pstate().getEndPosition());
   size_t file = node->pstate().getSrcId();
   str << (file == sass::string::npos ? 99999999 : file)
     << "@[" << start.line << ":" << start.column << "]"
@@ -0,0 +1,223 @@
+// sass.hpp must go before all system headers to get the
+// __EXTENSIONS__ fix on Solaris.
+#include "sass.hpp"
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <cerrno>
+# include <dirent.h>
+#endif
+
+#include "directory_cache.hpp"
+#include "utf8_string.hpp"
+#include "util_string.hpp"
+#include "file.hpp"
+
+namespace Sass {
+
+  static sass::string fold_case(sass::string name)
+  {
+    Util::ascii_str_tolower(&name);
+    return name;
+  }
+
+  void DirectoryCache::Listing::add(const sass::string& name, Kind kind)
+  {
+    entries[name] = kind;
+    folded.insert(fold_case(name));
+    if (!Util::ascii_only(name.data(), name.data() + name.size())) non_ascii = true;
+  }
+
+  bool DirectoryCache::Listing::lacks(const sass::string& name) const
+  {
+    if (!listed) return false;
+    // filesystems may also fold other chars
+    if (non_ascii) return false;
+    if (!Util::ascii_only(name.data(), name.data() + name.size())) return false;
+    // it may be case insensitive
+    return folded.count(fold_case(name)) == 0;
+  }
+
+  DirectoryCache::DirectoryCache()
+  : lookups(0),
+    fs_calls(0)
+  { }
+
+  bool DirectoryCache::read_dir(const sass::string& dir, Listing& listing)
+  {
+    #ifdef _WIN32
+      WIN32_FIND_DATAW data;
+      std::wstring pattern(UTF_8::convert_to_utf16((dir.empty() ? "./" : dir) + "*"));
+      HANDLE handle = FindFirstFileW(pattern.c_str(), &data);
+      // let `file_exists` deal with long or odd paths
+      if (handle == INVALID_HANDLE_VALUE) return false;
+      do {
+        Kind kind = PRESENT;
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) kind = UNKNOWN;
+        else if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) kind = FOLDER;
+        listing.add(UTF_8::convert_from_utf16(data.cFileName), kind);
+      } while (FindNextFileW(handle, &data));
+      FindClose(handle);
+      return true;
+    #else
+      DIR* handle = opendir(dir.empty() ? "." : dir.c_str());
+      // a missing directory has no files
+      if (handle == NULL) return errno == ENOENT || errno == ENOTDIR;
+      while (struct dirent* entry = readdir(handle)) {
+        Kind kind = UNKNOWN;
+        #ifdef DT_UNKNOWN
+          // symlinks must be followed
+          if (entry->d_type == DT_DIR) kind = FOLDER;
+          else if (entry->d_type != DT_LNK && entry->d_type != DT_UNKNOWN) kind = PRESENT;
+        #endif
+        listing.add(entry->d_name, kind);
+      }
+      closedir(handle);
+      return true;
+    #endif
+  }
+
+  // splits after the last separator (before [end])
+  static size_t split_pos(const sass::string& path, size_t end = sass::string::npos)
+  {
+    #ifdef _WIN32
+      size_t pos = path.find_last_of("/\\", end);
+    #else
+      size_t pos = path.find_last_of('/', end);
+    #endif
+    return pos == sass::string::npos ? 0 : pos + 1;
+  }
+
+  bool DirectoryCache::missing_dir(const sass::string& dir)
+  {
+    if (dir.size() < 2) return false;
+    size_t pos = split_pos(dir, dir.size() - 2);
+    sass::string name(dir.substr(pos, dir.size() - pos - 1));
+    if (name.empty() || name == "." || name == "..") return false;
+    #ifdef _WIN32
+      // drive letters are not listed
+      if (name.find(':') != sass::string::npos) return false;
+    #endif
+    auto it = listings.find(dir.substr(0, pos));
+    if (it == listings.end() || !it->second.listed) return false;
+    auto entry = it->second.entries.find(name);
+    if (entry == it->second.entries.end()) return it->second.lacks(name);
+    return entry->second == ABSENT || entry->second == PRESENT;
+  }
+
+  bool DirectoryCache::file_exists(const sass::string& path)
+  {
+    // shared caches outlive the memory pool of the compiler
+    MemoryPoolScope scope(nullptr);
+    sass::string dir(path, 0, split_pos(path));
+    sass::string name(path.substr(dir.size()));
+
+    std::unique_lock<std::mutex> lock(mutex);
+    lookups += 1;
+    auto it = listings.find(dir);
+    // e.g. index files of imports that are no folder
+    if (it == listings.end() && missing_dir(dir)) {
+      it = listings.emplace(dir, Listing()).first;
+      it->second.listed = true;
+    }
+    if (it == listings.end()) {
+      fs_calls += 1;
+      // don't block other threads meanwhile
+      lock.unlock();
+      Listing listing;
+      listing.listed = read_dir(dir, listing);
+      lock.lock();
+      // keeps the one read first
+      it = listings.emplace(dir, std::move(listing)).first;
+    }
+
+    Listing& listing = it->second;
+    auto entry = listing.entries.find(name);
+    if (entry == listing.entries.end()) {
+      if (listing.lacks(name)) return false;
+    }
+    else if (entry->second != UNKNOWN) {
+      return entry->second == PRESENT;
+    }
+
+    // ask the filesystem once (the answer is kept for the exact name)
+    fs_calls += 1;
+    lock.unlock();
+    bool exists = File::file_exists(path);
+    lock.lock();
+    // listings may have been cleared meanwhile
+    it = listings.find(dir);
+    if (it != listings.end()) {
+      it->second.entries[name] = exists ? PRESENT : ABSENT;
+    }
+    return exists;
+  }
+
+  void DirectoryCache::clear()
+  {
+    MemoryPoolScope scope(nullptr);
+    std::lock_guard<std::mutex> lock(mutex);
+    listings.clear();
+  }
+
+  bool DirectoryCache::changed(const sass::string& path)
+  {
+    MemoryPoolScope scope(nullptr);
+    sass::string cwd(File::get_cwd());
+    sass::string abs_path(File::rel2abs(path, ".", cwd));
+    sass::string name(abs_path.substr(split_pos(abs_path)));
+    bool listed = false, valid = true;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (const auto& listing : listings) {
+        // folders may be relative to the cwd
+        if (File::rel2abs(listing.first + name, ".", cwd) != abs_path) continue;
+        auto entry = listing.second.entries.find(name);
+        listed = true;
+        if (entry == listing.second.entries.end() || entry->second != PRESENT) {
+          valid = false;
+          break;
+        }
+      }
+    }
+    if (valid && (!listed || File::file_exists(abs_path))) return true;
+    clear();
+    return false;
+  }
+
+  size_t DirectoryCache::getLookups()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lookups;
+  }
+
+  size_t DirectoryCache::getFsCalls()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fs_calls;
+  }
+
+}
+
+extern "C" {
+  using namespace Sass;
+
+  struct Sass_Directory_Cache* ADDCALL sass_make_directory_cache(void)
+  {
+    // must outlive the memory pool of any compiler
+    MemoryPoolScope scope(nullptr);
+    return new Sass_Directory_Cache();
+  }
+
+  void ADDCALL sass_delete_directory_cache(struct Sass_Directory_Cache* cache)
+  {
+    MemoryPoolScope scope(nullptr);
+    delete cache;
+  }
+
+  void ADDCALL sass_directory_cache_clear(struct Sass_Directory_Cache* cache) { cache->clear(); }
+  size_t ADDCALL sass_directory_cache_get_lookups(struct Sass_Directory_Cache* cache) { return cache->getLookups(); }
+  size_t ADDCALL sass_directory_cache_get_fs_calls(struct Sass_Directory_Cache* cache) { return cache->getFsCalls(); }
+
+}
@@ -0,0 +1,91 @@
+#ifndef SASS_DIRECTORY_CACHE_H
+#define SASS_DIRECTORY_CACHE_H
+
+// sass.hpp must go before all system headers to get the
+// __EXTENSIONS__ fix on Solaris.
+#include "sass.hpp"
+
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Sass {
+
+  // Answers `File::file_exists` for import resolution from directory
+  // listings. Every directory is read once, so all the candidates of
+  // an import that do not exist cost no filesystem call at all. Only
+  // entries whose type the listing does not tell (i.e. symlinks) and
+  // names that are only listed in another case (which depends on the
+  // filesystem, not the platform) are checked by `stat` once.
+  // Directories that can't be listed are checked file by file, but
+  // the results are remembered as well. Folders the listing of their
+  // parent doesn't have are not read.
+  // Files added or removed after a directory was read are not seen, so
+  // a cache shared between compilations must be cleared after that.
+  // All methods are thread safe (import prefetch workers use it).
+  class DirectoryCache {
+
+  private:
+
+    // present means it exists and is no directory
+    enum Kind { ABSENT, PRESENT, FOLDER, UNKNOWN };
+
+    struct Listing {
+      // false if `stat` must be asked
+      bool listed;
+      // set if any name has chars above 127
+      bool non_ascii;
+      // names exactly as listed (or checked)
+      std::unordered_map<sass::string, Kind> entries;
+      // listed names with ascii letters in lower case
+      std::unordered_set<sass::string> folded;
+      Listing() : listed(false), non_ascii(false) { }
+      // adds a name as it is listed
+      void add(const sass::string& name, Kind kind);
+      // true if the listing proves there is no such name
+      // names only differing in case (or in other ways on
+      // filesystems that fold unicode) must be checked
+      bool lacks(const sass::string& name) const;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<sass::string, Listing> listings;
+    size_t lookups;
+    size_t fs_calls;
+
+    // Reads the entries of [dir] (with trailing slash or empty)
+    // Returns false if the directory exists but can't be listed
+    static bool read_dir(const sass::string& dir, Listing& listing);
+
+    // True if the listing of the parent of [dir] has no such folder
+    // (must hold the lock)
+    bool missing_dir(const sass::string& dir);
+
+  public:
+
+    DirectoryCache();
+
+    // Same result as `File::file_exists(path)`
+    bool file_exists(const sass::string& path);
+
+    // Forgets all listings (e.g. after files were added)
+    void clear();
+
+    // Called when [path] was modified, added or removed. Listings
+    // stay valid if none has its folder or if it is listed and still
+    // exists, all are forgotten otherwise (and false is returned).
+    bool changed(const sass::string& path);
+
+    // Number of existence checks answered
+    size_t getLookups();
+    // Number of directory reads and `stat` calls made
+    size_t getFsCalls();
+
+  };
+
+}
+
+// The opaque handle for the C-API
+struct Sass_Directory_Cache : public Sass::DirectoryCache {};
+
+#endif
@@ -1,14 +1,25 @@
 // sass.hpp must go before all system headers to get the
 // __EXTENSIONS__ fix on Solaris.
 #include "sass.hpp"
+
+#include <algorithm>
+#include <cstring>
+
 #include "emitter.hpp"
 #include "util_string.hpp"
 #include "util.hpp"
 
 namespace Sass {
 
+  // the buffer is handed to a sink in chunks of this size
+  static const size_t SINK_CHUNK_SIZE = 64 * 1024;
+
   Emitter::Emitter(struct Sass_Output_Options& opt)
   : wbuf(),
+    sink(0),
+    sink_cookie(0),
+    sink_mappings(false),
+    sink_held(false),
     opt(opt),
     indentation(0),
     scheduled_space(0),
@@ -41,8 +52,11 @@ namespace Sass {
   void Emitter::add_source_index(size_t idx)
   { wbuf.smap.source_index.push_back(idx); }
 
-  sass::string Emitter::render_srcmap(Context &ctx)
-  { return wbuf.smap.render_srcmap(ctx); }
+  void Emitter::add_input_map(size_t idx, InputSourceMap&& map)
+  { wbuf.smap.add_input_map(idx, std::move(map)); }
+
+  void Emitter::render_srcmap(Context &ctx, sass::string& out, bool base64)
+  { wbuf.smap.render_srcmap(ctx, wbuf.header, wbuf.buffer, out, base64); }
 
   void Emitter::set_filename(const sass::string& str)
   { wbuf.smap.file = str; }
@@ -50,11 +64,61 @@ namespace Sass {
   void Emitter::schedule_mapping(const AST_Node* node)
   { scheduled_mapping = node; }
   void Emitter::add_open_mapping(const AST_Node* node)
-  { wbuf.smap.add_open_mapping(node); }
+  { wbuf.smap.add_open_mapping(node, wbuf.flushed + wbuf.buffer.size()); }
   void Emitter::add_close_mapping(const AST_Node* node)
-  { wbuf.smap.add_close_mapping(node); }
-  SourceSpan Emitter::remap(const SourceSpan& pstate)
-  { return wbuf.smap.remap(pstate); }
+  { wbuf.smap.add_close_mapping(node, wbuf.flushed + wbuf.buffer.size()); }
+
+  // OUTPUT SINK
+
+  void Emitter::set_sink(Sass_Output_Sink fn, void* cookie, bool mappings, bool held)
+  {
+    sink = fn;
+    sink_cookie = cookie;
+    sink_mappings = mappings;
+    sink_held = held;
+    // room for a few chunks before the buffer is compacted
+    wbuf.buffer.reserve(4 * SINK_CHUNK_SIZE);
+    if (held) return;
+    // the header always goes first
+    flush_header();
+    flush_output();
+  }
+
+  void Emitter::flush_header(void)
+  {
+    sink_held = false;
+    if (sink_mappings) wbuf.smap.flush_header(wbuf.header);
+    if (!wbuf.header.empty()) sink(wbuf.header.data(), wbuf.header.size(), sink_cookie);
+  }
+
+  void Emitter::flush_output(bool final)
+  {
+    if (sink == 0) return;
+    // the header is rendered at the end at the latest
+    if (sink_held) {
+      if (!final && !prepare_header()) return;
+      flush_header();
+    }
+    // comments are hoisted while the buffer is empty
+    // and the linefeed at the end is checked for
+    size_t tail = final ? 0 : std::max<size_t>(std::strlen(opt.linefeed), 1);
+    size_t end = wbuf.buffer.size();
+    if (end - wbuf.start > tail) {
+      const char* data = wbuf.buffer.data() + wbuf.start;
+      size_t size = end - wbuf.start - tail;
+      if (sink_mappings) wbuf.smap.flush(data, size);
+      else wbuf.smap.discard();
+      sink(data, size, sink_cookie);
+      wbuf.start += size;
+    }
+    // only drop what is handed off once the next
+    // chunk would not fit into the buffer anymore
+    if (final || wbuf.buffer.capacity() - end < SINK_CHUNK_SIZE) {
+      wbuf.buffer.erase(0, wbuf.start);
+      wbuf.flushed += wbuf.start;
+      wbuf.start = 0;
+    }
+  }
 
   // MAIN BUFFER MANIPULATION
 
@@ -93,24 +157,6 @@ namespace Sass {
     }
   }
 
-  // prepend some text or token to the buffer
-  void Emitter::prepend_output(const OutputBuffer& output)
-  {
-    wbuf.smap.prepend(output);
-    wbuf.buffer = output.buffer + wbuf.buffer;
-  }
-
-  // prepend some text or token to the buffer
-  void Emitter::prepend_string(const sass::string& text)
-  {
-    // do not adjust mappings for utf8 bom
-    // seems they are not counted in any UA
-    if (text.compare("\xEF\xBB\xBF") != 0) {
-      wbuf.smap.prepend(Offset(text));
-    }
-    wbuf.buffer = text + wbuf.buffer;
-  }
-
   char Emitter::last_char()
   {
     return wbuf.buffer.back();
@@ -123,8 +169,9 @@ namespace Sass {
     flush_schedules();
     // add to buffer
     wbuf.buffer += chr;
-    // account for data in source-maps
-    wbuf.smap.append(Offset(chr));
+    // remember for the charset
+    if (!Util::ascii_isascii(chr)) wbuf.non_ascii = true;
+    if (sink && wbuf.buffer.size() - wbuf.start >= SINK_CHUNK_SIZE) flush_output();
   }
 
   // append some text or token to the buffer
@@ -139,14 +186,15 @@ namespace Sass {
       if (output_style() == COMPACT) {
         out = comment_to_compact_string(out);
       }
-      wbuf.smap.append(Offset(out));
+      if (!wbuf.non_ascii) wbuf.non_ascii = !Util::ascii_only(out.data(), out.data() + out.size());
       wbuf.buffer += std::move(out);
     } else {
       // add to buffer
       wbuf.buffer += text;
-      // account for data in source-maps
-      wbuf.smap.append(Offset(text));
+      // remember for the charset
+      if (!wbuf.non_ascii) wbuf.non_ascii = !Util::ascii_only(text.data(), text.data() + text.size());
     }
+    if (sink && wbuf.buffer.size() - wbuf.start >= SINK_CHUNK_SIZE) flush_output();
   }
 
   // append some white-space only text
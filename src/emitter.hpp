@@ -6,6 +6,7 @@
 #include "sass.hpp"
 
 #include "sass/base.h"
+#include "sass/context.h"
 #include "source_map.hpp"
 #include "ast_fwd_decl.hpp"
 
@@ -20,18 +21,30 @@ namespace Sass {
 
     protected:
       OutputBuffer wbuf;
+      // receives the buffer in chunks if set
+      Sass_Output_Sink sink;
+      void* sink_cookie;
+      // whether mappings of flushed chunks are kept
+      bool sink_mappings;
+      // the buffer is held back until the header is known
+      bool sink_held;
+      // renders the header before the end if it is known
+      // already, the default has no header to wait for
+      virtual bool prepare_header(void) { return true; }
+      // hands the header to the sink
+      void flush_header(void);
     public:
       const sass::string& buffer(void) { return wbuf.buffer; }
       const SourceMap smap(void) { return wbuf.smap; }
-      const OutputBuffer output(void) { return wbuf; }
+      const OutputBuffer& output(void) { return wbuf; }
       // proxy methods for source maps
       void add_source_index(size_t idx);
+      void add_input_map(size_t idx, InputSourceMap&& map);
       void set_filename(const sass::string& str);
       void add_open_mapping(const AST_Node* node);
       void add_close_mapping(const AST_Node* node);
       void schedule_mapping(const AST_Node* node);
-      sass::string render_srcmap(Context &ctx);
-      SourceSpan remap(const SourceSpan& pstate);
+      void render_srcmap(Context &ctx, sass::string& out, bool base64 = false);
 
     public:
       struct Sass_Output_Options& opt;
@@ -66,9 +79,6 @@ namespace Sass {
       void finalize(bool final = true);
       // flush scheduled space/linefeed
       void flush_schedules(void);
-      // prepend some text or token to the buffer
-      void prepend_string(const sass::string& text);
-      void prepend_output(const OutputBuffer& out);
       // append some text or token to the buffer
       void append_string(const sass::string& text);
       // append a single character to buffer
@@ -80,6 +90,12 @@ namespace Sass {
       void append_token(const sass::string& text, const AST_Node* node);
       // query last appended character
       char last_char();
+      // hands the header and then the buffer in chunks to [fn]
+      // if [held] nothing is handed off before the header is known
+      void set_sink(Sass_Output_Sink fn, void* cookie, bool mappings, bool held = false);
+      // hands the buffer to the sink, but for a short tail
+      // that is kept to look back at, unless [final] is set
+      void flush_output(bool final = false);
 
     public: // syntax sugar
       void append_indentation();
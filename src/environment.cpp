@@ -1,37 +1,109 @@
 #include "sass.hpp"
+#include <atomic>
 #include "ast.hpp"
 #include "environment.hpp"
 
 namespace Sass {
 
+  // ids of frames holding definitions, shared by all threads since
+  // cached stylesheets (and their call sites) move between them
+  static std::atomic<size_t> scopes(1);
+
+  static size_t next_scope()
+  {
+    return scopes.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  EnvKey::EnvKey()
+  : name_(), kind_(VARIABLE), hash_(0)
+  { }
+
+  EnvKey::EnvKey(const char* name, Kind kind)
+  : EnvKey(sass::string(name), kind)
+  { }
+
+  EnvKey::EnvKey(const sass::string& name, Kind kind)
+  : name_(name), kind_(kind),
+    hash_(std::hash<sass::string>()(name) + kind)
+  { }
+
   template <typename T>
   Environment<T>::Environment(bool is_shadow)
-  : local_frame_(environment_map<sass::string, T>()),
-    parent_(0), is_shadow_(false)
+  : local_frame_(environment_map<T>()),
+    has_definitions_(false),
+    scope_(next_scope()), generations_(0),
+    parent_(0), is_shadow_(false), is_shared_(false)
   { }
   template <typename T>
   Environment<T>::Environment(Environment<T>* env, bool is_shadow)
-  : local_frame_(environment_map<sass::string, T>()),
-    parent_(env), is_shadow_(is_shadow)
+  : local_frame_(environment_map<T>()),
+    has_definitions_(false),
+    scope_(env ? env->scope_ : next_scope()),
+    generations_(env ? env->generations_ : 0),
+    parent_(env), is_shadow_(is_shadow), is_shared_(false)
   { }
   template <typename T>
   Environment<T>::Environment(Environment<T>& env, bool is_shadow)
-  : local_frame_(environment_map<sass::string, T>()),
-    parent_(&env), is_shadow_(is_shadow)
+  : local_frame_(environment_map<T>()),
+    has_definitions_(false),
+    scope_(env.scope_), generations_(env.generations_),
+    parent_(&env), is_shadow_(is_shadow), is_shared_(false)
   { }
 
   // link parent to create a stack
   template <typename T>
-  void Environment<T>::link(Environment& env) { parent_ = &env; }
+  void Environment<T>::link(Environment& env) { link(&env); }
   template <typename T>
-  void Environment<T>::link(Environment* env) { parent_ = env; }
+  void Environment<T>::link(Environment* env)
+  {
+    parent_ = env;
+    if (has_definitions_) return;
+    scope_ = env ? env->scope_ : next_scope();
+    generations_ = env ? env->generations_ : 0;
+  }
+
+  template <typename T>
+  const size_t* Environment<T>::generation(const EnvKey& key)
+  {
+    if (generations_ == 0) return 0;
+    return &(*generations_)[key];
+  }
+
+  // call sites cached in stylesheets of other contexts
+  // must not match our frames, so we need our own scope
+  template <typename T>
+  void Environment<T>::generations(DefinitionGenerations* generations)
+  {
+    generations_ = generations;
+    scope_ = next_scope();
+  }
+
+  // a frame gets its own scope with its first definition, since
+  // the lookups from its children may find other definitions now
+  template <typename T>
+  void Environment<T>::declare(const EnvKey& key)
+  {
+    if (!has_definitions_) {
+      has_definitions_ = true;
+      scope_ = next_scope();
+    }
+    if (generations_) ++(*generations_)[key];
+  }
+
+  // the root scope has no parent, or its
+  // parent is a shared (built-in) frame
+  template <typename T>
+  bool Environment<T>::is_root() const
+  {
+    return ! parent_ || parent_->is_shared_;
+  }
 
   // this is used to find the global frame
   // which is the second last on the stack
   template <typename T>
   bool Environment<T>::is_lexical() const
   {
-    return !! parent_ && parent_->parent_;
+    return !! parent_ && ! parent_->is_root();
   }
 
   // only match the real root scope
@@ -41,20 +113,20 @@ namespace Sass {
   template <typename T>
   bool Environment<T>::is_global() const
   {
-    return parent_ && ! parent_->parent_;
+    return parent_ && parent_->is_root();
   }
 
   template <typename T>
-  environment_map<sass::string, T>& Environment<T>::local_frame() {
+  environment_map<T>& Environment<T>::local_frame() {
     return local_frame_;
   }
 
   template <typename T>
-  bool Environment<T>::has_local(const sass::string& key) const
+  bool Environment<T>::has_local(const EnvKey& key) const
   { return local_frame_.find(key) != local_frame_.end(); }
 
   template <typename T> EnvResult
-  Environment<T>::find_local(const sass::string& key)
+  Environment<T>::find_local(const EnvKey& key)
   {
     auto end = local_frame_.end();
     auto it = local_frame_.find(key);
@@ -62,22 +134,24 @@ namespace Sass {
   }
 
   template <typename T>
-  T& Environment<T>::get_local(const sass::string& key)
+  T& Environment<T>::get_local(const EnvKey& key)
   { return local_frame_[key]; }
 
   template <typename T>
-  void Environment<T>::set_local(const sass::string& key, const T& val)
+  void Environment<T>::set_local(const EnvKey& key, const T& val)
   {
+    if (key.kind() != EnvKey::VARIABLE) declare(key);
     local_frame_[key] = val;
   }
   template <typename T>
-  void Environment<T>::set_local(const sass::string& key, T&& val)
+  void Environment<T>::set_local(const EnvKey& key, T&& val)
   {
+    if (key.kind() != EnvKey::VARIABLE) declare(key);
     local_frame_[key] = val;
   }
 
   template <typename T>
-  void Environment<T>::del_local(const sass::string& key)
+  void Environment<T>::del_local(const EnvKey& key)
   { local_frame_.erase(key); }
 
   template <typename T>
@@ -91,30 +165,30 @@ namespace Sass {
   }
 
   template <typename T>
-  bool Environment<T>::has_global(const sass::string& key)
+  bool Environment<T>::has_global(const EnvKey& key)
   { return global_env()->has(key); }
 
   template <typename T>
-  T& Environment<T>::get_global(const sass::string& key)
+  T& Environment<T>::get_global(const EnvKey& key)
   { return (*global_env())[key]; }
 
   template <typename T>
-  void Environment<T>::set_global(const sass::string& key, const T& val)
+  void Environment<T>::set_global(const EnvKey& key, const T& val)
   {
-    global_env()->local_frame_[key] = val;
+    global_env()->set_local(key, val);
   }
   template <typename T>
-  void Environment<T>::set_global(const sass::string& key, T&& val)
+  void Environment<T>::set_global(const EnvKey& key, T&& val)
   {
-    global_env()->local_frame_[key] = val;
+    global_env()->set_local(key, val);
   }
 
   template <typename T>
-  void Environment<T>::del_global(const sass::string& key)
+  void Environment<T>::del_global(const EnvKey& key)
   { global_env()->local_frame_.erase(key); }
 
   template <typename T>
-  Environment<T>* Environment<T>::lexical_env(const sass::string& key)
+  Environment<T>* Environment<T>::lexical_env(const EnvKey& key)
   {
     Environment* cur = this;
     while (cur) {
@@ -130,7 +204,7 @@ namespace Sass {
   // move down the stack but stop before we
   // reach the global frame (is not included)
   template <typename T>
-  bool Environment<T>::has_lexical(const sass::string& key) const
+  bool Environment<T>::has_lexical(const EnvKey& key) const
   {
     auto cur = this;
     while (cur->is_lexical()) {
@@ -144,7 +218,7 @@ namespace Sass {
   // either update already existing lexical value
   // or if flag is set, we create one if no lexical found
   template <typename T>
-  void Environment<T>::set_lexical(const sass::string& key, const T& val)
+  void Environment<T>::set_lexical(const EnvKey& key, const T& val)
   {
     Environment<T>* cur = this;
     bool shadow = false;
@@ -161,7 +235,7 @@ namespace Sass {
   }
   // this one moves the value
   template <typename T>
-  void Environment<T>::set_lexical(const sass::string& key, T&& val)
+  void Environment<T>::set_lexical(const EnvKey& key, T&& val)
   {
     Environment<T>* cur = this;
     bool shadow = false;
@@ -180,7 +254,7 @@ namespace Sass {
   // look on the full stack for key
   // include all scopes available
   template <typename T>
-  bool Environment<T>::has(const sass::string& key) const
+  bool Environment<T>::has(const EnvKey& key) const
   {
     auto cur = this;
     while (cur) {
@@ -195,7 +269,7 @@ namespace Sass {
   // look on the full stack for key
   // include all scopes available
   template <typename T> EnvResult
-  Environment<T>::find(const sass::string& key)
+  Environment<T>::find(const EnvKey& key)
   {
     auto cur = this;
     while (true) {
@@ -208,12 +282,13 @@ namespace Sass {
 
   // use array access for getter and setter functions
   template <typename T>
-  T& Environment<T>::get(const sass::string& key)
+  T& Environment<T>::get(const EnvKey& key)
   {
     auto cur = this;
     while (cur) {
-      if (cur->has_local(key)) {
-        return cur->get_local(key);
+      auto it = cur->local_frame_.find(key);
+      if (it != cur->local_frame_.end()) {
+        return it->second;
       }
       cur = cur->parent_;
     }
@@ -222,16 +297,9 @@ namespace Sass {
 
   // use array access for getter and setter functions
   template <typename T>
-  T& Environment<T>::operator[](const sass::string& key)
+  T& Environment<T>::operator[](const EnvKey& key)
   {
-    auto cur = this;
-    while (cur) {
-      if (cur->has_local(key)) {
-        return cur->get_local(key);
-      }
-      cur = cur->parent_;
-    }
-    return get_local(key);
+    return get(key);
   }
 /*
   #ifdef DEBUG
@@ -241,9 +309,9 @@ namespace Sass {
     size_t indent = 0;
     if (parent_) indent = parent_->print(prefix) + 1;
     std::cerr << prefix << sass::string(indent, ' ') << "== " << this << std::endl;
-    for (typename environment_map<sass::string, T>::iterator i = local_frame_.begin(); i != local_frame_.end(); ++i) {
-      if (!ends_with(i->first, "[f]") && !ends_with(i->first, "[f]4") && !ends_with(i->first, "[f]2")) {
-        std::cerr << prefix << sass::string(indent, ' ') << i->first << " " << i->second;
+    for (typename environment_map<T>::iterator i = local_frame_.begin(); i != local_frame_.end(); ++i) {
+      if (i->first.kind() == EnvKey::VARIABLE) {
+        std::cerr << prefix << sass::string(indent, ' ') << i->first.name() << " " << i->second;
         if (Value* val = Cast<Value>(i->second))
         { std::cerr << " : " << val->to_string(); }
         std::cerr << std::endl;
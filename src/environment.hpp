@@ -5,15 +5,55 @@
 // __EXTENSIONS__ fix on Solaris.
 #include "sass.hpp"
 
-#include <map>
 #include <string>
+#include <unordered_map>
 #include "ast_fwd_decl.hpp"
 #include "ast_def_macros.hpp"
 
 namespace Sass {
 
+  // Key to look up variables, functions and mixins. Each kind has
+  // its own namespace, so we no longer need to append suffixes to
+  // the names. The hash is calculated once on creation, which is
+  // usually when the parser creates the corresponding AST node.
+  class EnvKey {
+  public:
+    enum Kind { VARIABLE, FUNCTION, MIXIN };
+  private:
+    sass::string name_;
+    Kind kind_;
+    size_t hash_;
+  public:
+    EnvKey();
+    EnvKey(const char* name, Kind kind = VARIABLE);
+    EnvKey(const sass::string& name, Kind kind = VARIABLE);
+    const sass::string& name() const { return name_; }
+    Kind kind() const { return kind_; }
+    size_t hash() const { return hash_; }
+    bool operator==(const EnvKey& rhs) const
+    {
+      return hash_ == rhs.hash_
+        && kind_ == rhs.kind_
+        && name_ == rhs.name_;
+    }
+    struct Hasher {
+      size_t operator()(const EnvKey& key) const
+      { return key.hash(); }
+    };
+  };
+
+  // frames are hash maps keyed by the pre-hashed keys
+  template <typename T>
+  using environment_map = std::unordered_map<EnvKey, T, EnvKey::Hasher>;
+
+  // One counter per function or mixin name, owned by the context. It is
+  // incremented whenever a definition with that name is (re)declared.
+  // Call sites compare it to find out if the definition they resolved
+  // earlier is still valid (the counters never move in memory).
+  typedef environment_map<size_t> DefinitionGenerations;
+
   // this defeats the whole purpose of environment being templatable!!
-  typedef environment_map<sass::string, AST_Node_Obj>::iterator EnvIter;
+  typedef environment_map<AST_Node_Obj>::iterator EnvIter;
 
   class EnvResult {
     public:
@@ -26,10 +66,19 @@ namespace Sass {
 
   template <typename T>
   class Environment {
-    // TODO: test with map
-    environment_map<sass::string, T> local_frame_;
+    environment_map<T> local_frame_;
+    // frame holds functions or mixins
+    bool has_definitions_;
+    // unique id of the closest frame holding definitions
+    // (this one or a parent), never reused by other frames
+    size_t scope_;
+    // counters of the context we belong to
+    DefinitionGenerations* generations_;
     ADD_PROPERTY(Environment*, parent)
     ADD_PROPERTY(bool, is_shadow)
+    // frame is shared between compilations (read-only)
+    // it does not count as a level for lexical scoping
+    ADD_PROPERTY(bool, is_shared)
 
   public:
     Environment(bool is_shadow = false);
@@ -40,6 +89,22 @@ namespace Sass {
     void link(Environment& env);
     void link(Environment* env);
 
+    // function and mixin lookups give the same result in all
+    // frames with the same scope, until a name is redeclared
+    size_t scope() const { return scope_; }
+
+    // counter for redeclarations of `key` (null
+    // if the frame does not belong to a context)
+    const size_t* generation(const EnvKey& key);
+
+    // attach the counters of a context to this frame
+    // (and all frames that are created on top of it)
+    void generations(DefinitionGenerations* generations);
+
+    // the root scope has no parent, or its
+    // parent is a shared (built-in) frame
+    bool is_root() const;
+
     // this is used to find the global frame
     // which is the second last on the stack
     bool is_lexical() const;
@@ -52,67 +117,72 @@ namespace Sass {
 
     // scope operates on the current frame
 
-    environment_map<sass::string, T>& local_frame();
+    environment_map<T>& local_frame();
 
-    bool has_local(const sass::string& key) const;
+    bool has_local(const EnvKey& key) const;
 
-    EnvResult find_local(const sass::string& key);
+    EnvResult find_local(const EnvKey& key);
 
-    T& get_local(const sass::string& key);
+    T& get_local(const EnvKey& key);
 
     // set variable on the current frame
-    void set_local(const sass::string& key, const T& val);
-    void set_local(const sass::string& key, T&& val);
+    void set_local(const EnvKey& key, const T& val);
+    void set_local(const EnvKey& key, T&& val);
 
-    void del_local(const sass::string& key);
+    void del_local(const EnvKey& key);
 
     // global operates on the global frame
     // which is the second last on the stack
     Environment* global_env();
     // get the env where the variable already exists
     // if it does not yet exist, we return current env
-    Environment* lexical_env(const sass::string& key);
+    Environment* lexical_env(const EnvKey& key);
 
-    bool has_global(const sass::string& key);
+    bool has_global(const EnvKey& key);
 
-    T& get_global(const sass::string& key);
+    T& get_global(const EnvKey& key);
 
     // set a variable on the global frame
-    void set_global(const sass::string& key, const T& val);
-    void set_global(const sass::string& key, T&& val);
+    void set_global(const EnvKey& key, const T& val);
+    void set_global(const EnvKey& key, T&& val);
 
-    void del_global(const sass::string& key);
+    void del_global(const EnvKey& key);
 
     // see if we have a lexical variable
     // move down the stack but stop before we
     // reach the global frame (is not included)
-    bool has_lexical(const sass::string& key) const;
+    bool has_lexical(const EnvKey& key) const;
 
     // see if we have a lexical we could update
     // either update already existing lexical value
     // or we create a new one on the current frame
-    void set_lexical(const sass::string& key, T&& val);
-    void set_lexical(const sass::string& key, const T& val);
+    void set_lexical(const EnvKey& key, T&& val);
+    void set_lexical(const EnvKey& key, const T& val);
 
     // look on the full stack for key
     // include all scopes available
-    bool has(const sass::string& key) const;
+    bool has(const EnvKey& key) const;
 
     // look on the full stack for key
     // include all scopes available
-    T& get(const sass::string& key);
+    T& get(const EnvKey& key);
 
     // look on the full stack for key
     // include all scopes available
-    EnvResult find(const sass::string& key);
+    EnvResult find(const EnvKey& key);
 
     // use array access for getter and setter functions
-    T& operator[](const sass::string& key);
+    T& operator[](const EnvKey& key);
 
     #ifdef DEBUG
     size_t print(sass::string prefix = "");
     #endif
 
+  private:
+
+    // update the counters before a definition is set
+    void declare(const EnvKey& key);
+
   };
 
   // define typedef for our use case
@@ -91,12 +91,12 @@ namespace Sass {
   Expression* Eval::operator()(Assignment* a)
   {
     Env* env = environment();
-    sass::string var(a->variable());
+    const EnvKey& var(a->key());
     if (a->is_global()) {
       if (!env->has_global(var)) {
         deprecated(
           "!global assignments won't be able to declare new variables in future versions.",
-          "Consider adding `" + var + ": null` at the top level.",
+          "Consider adding `" + var.name() + ": null` at the top level.",
           true, a->pstate());
       }
       if (a->is_default()) {
@@ -176,7 +176,7 @@ namespace Sass {
   // But iteration vars are reset afterwards
   Expression* Eval::operator()(ForRule* f)
   {
-    sass::string variable(f->variable());
+    EnvKey variable(f->variable());
     ExpressionObj low = f->lower_bound()->perform(this);
     if (low->concrete_type() != Expression::NUMBER) {
       traces.push_back(Backtrace(low->pstate()));
@@ -232,7 +232,8 @@ namespace Sass {
   // But iteration vars are reset afterwards
   Expression* Eval::operator()(EachRule* e)
   {
-    sass::vector<sass::string> variables(e->variables());
+    const sass::vector<sass::string>& names(e->variables());
+    sass::vector<EnvKey> variables(names.begin(), names.end());
     ExpressionObj expr = e->list()->perform(this);
     Env env(environment(), true);
     env_stack().push_back(&env);
@@ -344,19 +345,18 @@ namespace Sass {
     Env* env = environment();
 
     // try to use generic function
-    if (env->has("@warn[f]")) {
+    if (env->has(EnvKey("@warn", EnvKey::FUNCTION))) {
 
       // add call stack entry
       callee_stack().push_back({
         "@warn",
         w->pstate().getPath(),
-        w->pstate().getLine(),
-        w->pstate().getColumn(),
+        w->pstate(),
         SASS_CALLEE_FUNCTION,
         { env }
       });
 
-      Definition* def = Cast<Definition>((*env)["@warn[f]"]);
+      Definition* def = Cast<Definition>((*env)[EnvKey("@warn", EnvKey::FUNCTION)]);
       // Block_Obj          body   = def->block();
       // Native_Function func   = def->native_function();
       Sass_Function_Entry c_function = def->c_function();
@@ -392,19 +392,18 @@ namespace Sass {
     Env* env = environment();
 
     // try to use generic function
-    if (env->has("@error[f]")) {
+    if (env->has(EnvKey("@error", EnvKey::FUNCTION))) {
 
       // add call stack entry
       callee_stack().push_back({
         "@error",
         e->pstate().getPath(),
-        e->pstate().getLine(),
-        e->pstate().getColumn(),
+        e->pstate(),
         SASS_CALLEE_FUNCTION,
         { env }
       });
 
-      Definition* def = Cast<Definition>((*env)["@error[f]"]);
+      Definition* def = Cast<Definition>((*env)[EnvKey("@error", EnvKey::FUNCTION)]);
       // Block_Obj          body   = def->block();
       // Native_Function func   = def->native_function();
       Sass_Function_Entry c_function = def->c_function();
@@ -436,19 +435,18 @@ namespace Sass {
     Env* env = environment();
 
     // try to use generic function
-    if (env->has("@debug[f]")) {
+    if (env->has(EnvKey("@debug", EnvKey::FUNCTION))) {
 
       // add call stack entry
       callee_stack().push_back({
         "@debug",
         d->pstate().getPath(),
-        d->pstate().getLine(),
-        d->pstate().getColumn(),
+        d->pstate(),
         SASS_CALLEE_FUNCTION,
         { env }
       });
 
-      Definition* def = Cast<Definition>((*env)["@debug[f]"]);
+      Definition* def = Cast<Definition>((*env)[EnvKey("@debug", EnvKey::FUNCTION)]);
       // Block_Obj          body   = def->block();
       // Native_Function func   = def->native_function();
       Sass_Function_Entry c_function = def->c_function();
@@ -970,15 +968,24 @@ namespace Sass {
       return SASS_MEMORY_NEW(String_Constant, c->pstate(), str);
     }
 
-    sass::string name(Util::normalize_underscores(c->name()));
-    sass::string full_name(name + "[f]");
+    const EnvKey* key = &c->key();
 
     // we make a clone here, need to implement that further
     Arguments_Obj args = c->arguments();
 
     Env* env = environment();
-    if (!env->has(full_name) || (!c->via_call() && Prelexer::re_special_fun(name.c_str()))) {
-      if (!env->has("*[f]")) {
+    static const EnvKey generic("*", EnvKey::FUNCTION);
+    // resolve the definition unless this call site already did
+    Definition* def = c->cache().get(env);
+    bool cached = def != nullptr;
+    if (!cached) {
+      EnvResult found(env->find(*key));
+      if (found.found && (c->via_call() || !Prelexer::re_special_fun(key->name().c_str()))) {
+        def = Cast<Definition>(found.it->second);
+        c->cache().set(env, c->key(), def);
+        cached = true;
+      }
+      else if (!env->has(generic)) {
         for (Argument_Obj arg : args->elements()) {
           if (List_Obj ls = Cast<List>(arg->value())) {
             if (ls->size() == 0) error("() isn't a valid CSS value.", c->pstate(), traces);
@@ -999,23 +1006,24 @@ namespace Sass {
         return str;
       } else {
         // call generic function
-        full_name = "*[f]";
+        key = &generic;
+        def = Cast<Definition>(env->get(generic));
       }
     }
 
     // further delay for calls
-    if (full_name != "call[f]") {
+    if (key->name() != "call") {
       args->set_delayed(false); // verified
     }
-    if (full_name != "if[f]") {
+    if (key->name() != "if") {
       args = Cast<Arguments>(args->perform(this));
     }
-    Definition* def = Cast<Definition>((*env)[full_name]);
-
-    if (c->func()) def = c->func()->definition();
+    if (c->func()) {
+      def = c->func()->definition();
+      cached = false;
+    }
 
     if (def->is_overload_stub()) {
-      sass::ostream ss;
       size_t L = args->length();
       // account for rest arguments
       if (args->has_rest_argument() && args->length() > 0) {
@@ -1024,11 +1032,16 @@ namespace Sass {
         // arguments before rest argument plus rest
         if (rest) L += rest->length() - 1;
       }
-      ss << full_name << L;
-      full_name = ss.str();
-      sass::string resolved_name(full_name);
-      if (!env->has(resolved_name)) error("overloaded function `" + sass::string(c->name()) + "` given wrong number of arguments", c->pstate(), traces);
-      def = Cast<Definition>((*env)[resolved_name]);
+      Definition* overload = cached ? c->cache().overload(L) : nullptr;
+      if (overload == nullptr) {
+        sass::ostream ss;
+        ss << key->name() << "[" << L << "]";
+        EnvKey resolved_name(ss.str(), EnvKey::FUNCTION);
+        if (!env->has(resolved_name)) error("overloaded function `" + sass::string(c->name()) + "` given wrong number of arguments", c->pstate(), traces);
+        overload = Cast<Definition>((*env)[resolved_name]);
+        if (cached) c->cache().overload(L, overload);
+      }
+      def = overload;
     }
 
     ExpressionObj     result = c;
@@ -1049,8 +1062,7 @@ namespace Sass {
       callee_stack().push_back({
         c->name().c_str(),
         c->pstate().getPath(),
-        c->pstate().getLine(),
-        c->pstate().getColumn(),
+        c->pstate(),
         SASS_CALLEE_FUNCTION,
         { env }
       });
@@ -1073,7 +1085,7 @@ namespace Sass {
     // convert call into C-API compatible form
     else if (c_function) {
       Sass_Function_Fn c_func = sass_function_get_function(c_function);
-      if (full_name == "*[f]") {
+      if (key == &generic) {
         String_Quoted_Obj str = SASS_MEMORY_NEW(String_Quoted, c->pstate(), c->name());
         Arguments_Obj new_args = SASS_MEMORY_NEW(Arguments, c->pstate());
         new_args->append(SASS_MEMORY_NEW(Argument, c->pstate(), str));
@@ -1089,8 +1101,7 @@ namespace Sass {
       callee_stack().push_back({
         c->name().c_str(),
         c->pstate().getPath(),
-        c->pstate().getLine(),
-        c->pstate().getColumn(),
+        c->pstate(),
         SASS_CALLEE_C_FUNCTION,
         { env }
       });
@@ -1140,8 +1151,7 @@ namespace Sass {
   {
     ExpressionObj value;
     Env* env = environment();
-    const sass::string& name(v->name());
-    EnvResult rv(env->find(name));
+    EnvResult rv(env->find(v->key()));
     if (rv.found) value = static_cast<Expression*>(rv.it->second.ptr());
     else error("Undefined variable: \"" + v->name() + "\".", v->pstate(), traces);
     if (Argument* arg = Cast<Argument>(value)) value = arg->value();
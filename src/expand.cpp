@@ -186,9 +186,9 @@ namespace Sass {
       return k.detach();
     }
 
+    SelectorListObj sel = r->selector();
     if (r->schema()) {
-      SelectorListObj sel = eval(r->schema());
-      r->selector(sel);
+      sel = eval(r->schema());
       for (auto complex : sel->elements()) {
         // ToDo: maybe we can get rid of chroots?
         complex->chroots(complex->has_real_parent_ref());
@@ -199,7 +199,7 @@ namespace Sass {
     // reset when leaving scope
     LOCAL_FLAG(at_root_without_rule, false);
 
-    SelectorListObj evaled = eval(r->selector());
+    SelectorListObj evaled = eval(sel);
     // do not connect parent again
     Env env(environment());
     if (block_stack.back()->is_root()) {
@@ -357,12 +357,12 @@ namespace Sass {
   Statement* Expand::operator()(Assignment* a)
   {
     Env* env = environment();
-    const sass::string& var(a->variable());
+    const EnvKey& var(a->key());
     if (a->is_global()) {
       if (!env->has_global(var)) {
         deprecated(
           "!global assignments won't be able to declare new variables in future versions.",
-          "Consider adding `" + var + ": null` at the top level.",
+          "Consider adding `" + var.name() + ": null` at the top level.",
           true, a->pstate());
       }
       if (a->is_default()) {
@@ -523,7 +523,7 @@ namespace Sass {
   // But iteration vars are reset afterwards
   Statement* Expand::operator()(ForRule* f)
   {
-    sass::string variable(f->variable());
+    EnvKey variable(f->variable());
     ExpressionObj low = f->lower_bound()->perform(&eval);
     if (low->concrete_type() != Expression::NUMBER) {
       traces.push_back(Backtrace(low->pstate()));
@@ -578,7 +578,8 @@ namespace Sass {
   // But iteration vars are reset afterwards
   Statement* Expand::operator()(EachRule* e)
   {
-    sass::vector<sass::string> variables(e->variables());
+    const sass::vector<sass::string>& names(e->variables());
+    sass::vector<EnvKey> variables(names.begin(), names.end());
     ExpressionObj expr = e->list()->perform(&eval);
     List_Obj list;
     Map_Obj map;
@@ -684,17 +685,20 @@ namespace Sass {
   Statement* Expand::operator()(ExtendRule* e)
   {
 
+    // keep the rule as parsed, it may be expanded again
+    SelectorListObj extendee = e->selector();
+    bool isOptional = e->isOptional();
     // evaluate schema first
     if (e->schema()) {
-      e->selector(eval(e->schema()));
-      e->isOptional(e->selector()->is_optional());
+      extendee = eval(e->schema());
+      isOptional = extendee->is_optional();
     }
     // evaluate the selector
-    e->selector(eval(e->selector()));
+    extendee = eval(extendee);
 
-    if (e->selector()) {
+    if (extendee) {
 
-      for (auto complex : e->selector()->elements()) {
+      for (auto complex : extendee->elements()) {
 
         if (complex->length() != 1) {
           error("complex selectors may not be extended.", complex->pstate(), traces);
@@ -720,13 +724,13 @@ namespace Sass {
             // Make this an error once deprecation is over
             for (SimpleSelectorObj simple : compound->elements()) {
               // Pass every selector we ever see to extender (to make them findable for extend)
-              ctx.extender.addExtension(selector(), simple, mediaStack.back(), e->isOptional());
+              ctx.extender.addExtension(selector(), simple, mediaStack.back(), isOptional);
             }
 
           }
           else {
             // Pass every selector we ever see to extender (to make them findable for extend)
-            ctx.extender.addExtension(selector(), compound->first(), mediaStack.back(), e->isOptional());
+            ctx.extender.addExtension(selector(), compound->first(), mediaStack.back(), isOptional);
           }
 
         }
@@ -744,8 +748,7 @@ namespace Sass {
   {
     Env* env = environment();
     Definition_Obj dd = SASS_MEMORY_COPY(d);
-    env->local_frame()[d->name() +
-                        (d->type() == Definition::MIXIN ? "[m]" : "[f]")] = dd;
+    env->set_local(d->key(), dd);
 
     if (d->type() == Definition::FUNCTION && (
       Prelexer::calc_fn_call(d->name().c_str()) ||
@@ -775,11 +778,15 @@ namespace Sass {
     recursions ++;
 
     Env* env = environment();
-    sass::string full_name(c->name() + "[m]");
-    if (!env->has(full_name)) {
-      error("no mixin named " + c->name(), c->pstate(), traces);
+    Definition_Obj def = c->cache().get(env);
+    if (!def) {
+      EnvResult found(env->find(c->key()));
+      if (!found.found) {
+        error("no mixin named " + c->name(), c->pstate(), traces);
+      }
+      def = Cast<Definition>(found.it->second);
+      c->cache().set(env, c->key(), def);
     }
-    Definition_Obj def = Cast<Definition>((*env)[full_name]);
     Block_Obj body = def->block();
     Parameters_Obj params = def->parameters();
 
@@ -793,8 +800,7 @@ namespace Sass {
     ctx.callee_stack.push_back({
       c->name().c_str(),
       c->pstate().getPath(),
-      c->pstate().getLine(),
-      c->pstate().getColumn(),
+      c->pstate(),
       SASS_CALLEE_MIXIN,
       { env }
     });
@@ -812,7 +818,7 @@ namespace Sass {
                                           c->block(),
                                           Definition::MIXIN);
       thunk->environment(env);
-      new_env.local_frame()["@content[m]"] = thunk;
+      new_env.local_frame()[thunk->key()] = thunk;
     }
 
     bind(sass::string("Mixin"), c->name(), params, args, &new_env, &eval, traces);
@@ -847,7 +853,7 @@ namespace Sass {
   {
     Env* env = environment();
     // convert @content directives into mixin calls to the underlying thunk
-    if (!env->has("@content[m]")) return 0;
+    if (!env->has(EnvKey("@content", EnvKey::MIXIN))) return 0;
     Arguments_Obj args = c->arguments();
     if (!args) args = SASS_MEMORY_NEW(Arguments, c->pstate());
 
@@ -1057,23 +1057,6 @@ namespace Sass {
   }
   // EO extendPseudo
 
-  // ##########################################################################
-  // Rotates the element in list from [start] (inclusive) to [end] (exclusive)
-  // one index higher, looping the final element back to [start].
-  // ##########################################################################
-  void Extender::rotateSlice(
-    sass::vector<ComplexSelectorObj>& list,
-    size_t start, size_t end)
-  {
-    auto element = list[end - 1];
-    for (size_t i = start; i < end; i++) {
-      auto next = list[i];
-      list[i] = element;
-      element = next;
-    }
-  }
-  // EO rotateSlice
-
   // ##########################################################################
   // Removes elements from [selectors] if they're subselectors of other
   // elements. The [isOriginal] callback indicates which selectors are
@@ -1087,17 +1070,33 @@ namespace Sass {
     const ExtCplxSelSet& existing) const
   {
 
-    // Avoid truly horrific quadratic behavior.
-    // TODO(nweiz): I think there may be a way to get perfect trimming 
-    // without going quadratic by building some sort of trie-like
-    // data structure that can be used to look up superselectors.
-    // TODO(mgreter): Check how this performs in C++ (up the limit)
-    if (selectors.size() > 100) return selectors;
+    // Note: dart-sass returns [selectors] untrimmed if there are more than
+    // 100 of them. We trim lists of any size, so output for those differs.
+    // This is n² on the sequences in the worst case, but a superselector must
+    // share a simple selector with the last compound of its subselector. We
+    // therefore index all selectors by one of theirs and only compare against
+    // the ones stored under the keys of [complex1]. Selectors without a key
+    // are always compared. This keeps trimming near-linear in common cases.
+    std::unordered_map<sass::string, sass::vector<size_t>> index;
+    sass::vector<size_t> unindexed;
+    for (size_t n = 0; n < selectors.size(); n++) {
+      sass::string key;
+      if (trimIndexKey(selectors[n], key)) {
+        index[key].push_back(n);
+      }
+      else {
+        unindexed.push_back(n);
+      }
+    }
+
+    // Selectors after [i] that were added to [result]
+    sass::vector<bool> kept(selectors.size(), false);
 
-    // This is n² on the sequences, but only comparing between separate sequences
-    // should limit the quadratic behavior. We iterate from last to first and reverse
-    // the result so that, if two selectors are identical, we keep the first one.
+    // We iterate from last to first and reverse the result so that,
+    // if two selectors are identical, we keep the first one. The
+    // result is built back to front and only reversed at the end.
     sass::vector<ComplexSelectorObj> result; size_t numOriginals = 0;
+    sass::vector<sass::string> keys;
 
     size_t i = selectors.size();
   outer: // Use label to continue loop
@@ -1109,13 +1108,15 @@ namespace Sass {
       if (existing.find(complex1) != existing.end()) {
         // Make sure we don't include duplicate originals, which could
         // happen if a style rule extends a component of its own selector.
-        for (size_t j = 0; j < numOriginals; j++) {
+        for (size_t j = result.size() - numOriginals; j < result.size(); j++) {
           if (ObjEqualityFn(result[j], complex1)) {
-            rotateSlice(result, 0, j + 1);
+            // Move it to the front of the (reversed) result
+            std::rotate(result.begin() + j, result.begin() + j + 1, result.end());
             goto outer;
           }
         }
-        result.insert(result.begin(), complex1);
+        result.push_back(complex1);
+        kept[i] = true;
         numOriginals++;
         continue;
       }
@@ -1130,27 +1131,42 @@ namespace Sass {
           maxSpecificity = std::max(maxSpecificity, maxSourceSpecificity(compound));
         }
       }
-      
 
       // Look in [result] rather than [selectors] for selectors after [i]. This
       // ensures we aren't comparing against a selector that's already been trimmed,
       // and thus that if there are two identical selectors only one is trimmed.
-      if (hasAny(result, dontTrimComplex, complex1, maxSpecificity)) {
-        continue;
+      auto isTrimmedBy = [&](size_t n) {
+        if (n == i || (n > i && !kept[n])) return false;
+        return dontTrimComplex(selectors[n], complex1, maxSpecificity);
+      };
+
+      keys.clear();
+      if (trimLookupKeys(complex1, keys)) {
+        for (size_t n : unindexed) {
+          if (isTrimmedBy(n)) goto outer;
+        }
+        for (size_t k = 0; k < keys.size(); k++) {
+          // Skip keys we already looked up
+          if (std::find(keys.begin(), keys.begin() + k, keys[k]) != keys.begin() + k) continue;
+          auto bucket = index.find(keys[k]);
+          if (bucket == index.end()) continue;
+          for (size_t n : bucket->second) {
+            if (isTrimmedBy(n)) goto outer;
+          }
+        }
       }
-
-      // Check if any element (up to [i]) from [selector] returns true
-      // when passed to [dontTrimComplex]. The arguments [complex1] and
-      // [maxSepcificity] will be passed to the invoked function.
-      if (hasSubAny(selectors, i, dontTrimComplex, complex1, maxSpecificity)) {
-        continue;
+      else {
+        for (size_t n = 0; n < selectors.size(); n++) {
+          if (isTrimmedBy(n)) goto outer;
+        }
       }
 
-      // ToDo: Maybe use deque for front insert?
-      result.insert(result.begin(), complex1);
+      result.push_back(complex1);
+      kept[i] = true;
 
     }
 
+    std::reverse(result.begin(), result.end());
     return result;
 
   }
@@ -1181,6 +1197,67 @@ namespace Sass {
   }
   // EO maxSourceSpecificity(CompoundSelectorObj)
 
+  // ##########################################################################
+  // Returns via [key] the name of a simple selector in the last compound of
+  // [complex]. Every selector it is a superselector of must have it in its
+  // last compound or a selector pseudo there. Returns false if there is none.
+  // ##########################################################################
+  bool Extender::trimIndexKey(
+    const ComplexSelectorObj& complex,
+    sass::string& key)
+  {
+    if (complex->empty()) return false;
+    const CompoundSelector* compound = Cast<CompoundSelector>(complex->last());
+    if (compound == nullptr) return false;
+    bool found = false;
+    for (const SimpleSelectorObj& simple : compound->elements()) {
+      // Selector pseudos are matched by [selectorPseudoIsSuperselector]
+      const PseudoSelector* pseudo = Cast<PseudoSelector>(simple);
+      if (pseudo && pseudo->selector()) continue;
+      // Type selectors are often shared, prefer any other one
+      if (found && Cast<TypeSelector>(simple)) continue;
+      key = simple->name();
+      if (!Cast<TypeSelector>(simple)) return true;
+      found = true;
+    }
+    return found;
+  }
+  // EO trimIndexKey
+
+  // ##########################################################################
+  // Returns via [keys] all index keys a superselector of [complex] could be
+  // stored under. Returns false if no keys can be given for [complex], in
+  // which case every selector must be considered as a superselector.
+  // ##########################################################################
+  bool Extender::trimLookupKeys(
+    const ComplexSelectorObj& complex,
+    sass::vector<sass::string>& keys)
+  {
+    // Selectors with trailing operators have no superselectors
+    if (complex->empty()) return true;
+    const CompoundSelector* compound = Cast<CompoundSelector>(complex->last());
+    if (compound == nullptr) return true;
+    for (const SimpleSelectorObj& simple : compound->elements()) {
+      keys.push_back(simple->name());
+      // Some selector pseudos also match all simple selectors that are
+      // contained in their compound selectors (see [simpleIsSuperselector]).
+      const PseudoSelector* pseudo = Cast<PseudoSelector>(simple);
+      if (pseudo && pseudo->selector()) {
+        const SelectorList* list = pseudo->selector();
+        if (list->empty()) return false;
+        const ComplexSelectorObj& first = list->first();
+        if (first->length() != 1) continue;
+        const CompoundSelector* inner = Cast<CompoundSelector>(first->first());
+        if (inner == nullptr) return false;
+        for (const SimpleSelectorObj& contained : inner->elements()) {
+          keys.push_back(contained->name());
+        }
+      }
+    }
+    return true;
+  }
+  // EO trimLookupKeys
+
   // ##########################################################################
   // Helper function used as callbacks on lists
   // ##########################################################################
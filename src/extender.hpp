@@ -351,14 +351,6 @@ namespace Sass {
       const ExtSelExtMap& extensions,
       const CssMediaRuleObj& mediaQueryContext);
 
-    // ##########################################################################
-    // Rotates the element in list from [start] (inclusive) to [end] (exclusive)
-    // one index higher, looping the final element back to [start].
-    // ##########################################################################
-    static void rotateSlice(
-      sass::vector<ComplexSelectorObj>& list,
-      size_t start, size_t end);
-
     // ##########################################################################
     // Removes elements from [selectors] if they're subselectors of other
     // elements. The [isOriginal] callback indicates which selectors are
@@ -378,6 +370,24 @@ namespace Sass {
     // ##########################################################################
     size_t maxSourceSpecificity(const CompoundSelectorObj& compound) const;
 
+    // ##########################################################################
+    // Returns via [key] the name of a simple selector in the last compound of
+    // [complex]. Every selector it is a superselector of must have it in its
+    // last compound or a selector pseudo there. Returns false if there is none.
+    // ##########################################################################
+    static bool trimIndexKey(
+      const ComplexSelectorObj& complex,
+      sass::string& key);
+
+    // ##########################################################################
+    // Returns via [keys] all index keys a superselector of [complex] could be
+    // stored under. Returns false if no keys can be given for [complex], in
+    // which case every selector must be considered as a superselector.
+    // ##########################################################################
+    static bool trimLookupKeys(
+      const ComplexSelectorObj& complex,
+      sass::vector<sass::string>& keys);
+
     // ##########################################################################
     // Helper function used as callbacks on lists
     // ##########################################################################
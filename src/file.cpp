@@ -12,8 +12,11 @@
 # define S_ISDIR(mode) (((mode) & S_IFMT) == S_IFDIR)
 #else
 # include <unistd.h>
+# include <fcntl.h>
+# include <sys/mman.h>
 #endif
 #include <cstdio>
+#include <cstring>
 #include <vector>
 #include <algorithm>
 #include <sys/stat.h>
@@ -26,6 +29,7 @@
 #include "util.hpp"
 #include "util_string.hpp"
 #include "sass2scss.h"
+#include "directory_cache.hpp"
 
 #ifdef _WIN32
 # include <windows.h>
@@ -341,8 +345,11 @@ namespace Sass {
     // (4) given + extension
     // (5) given + _index.scss
     // (6) given + _index.sass
-    sass::vector<Include> resolve_includes(const sass::string& root, const sass::string& file, const sass::vector<sass::string>& exts)
+    sass::vector<Include> resolve_includes(const sass::string& root, const sass::string& file, DirectoryCache* listings, const sass::vector<sass::string>& exts)
     {
+      auto file_exists = [listings](const sass::string& path) {
+        return listings ? listings->file_exists(path) : File::file_exists(path);
+      };
       sass::string filename = join_paths(root, file);
       // split the filename
       sass::string base(dir_name(file));
@@ -437,11 +444,59 @@ namespace Sass {
       return sass::string("");
     }
 
+    #ifndef _WIN32
+
+    // smaller files are faster to read than to map
+    const size_t map_threshold = 64 * 1024;
+
+    // Maps [size] bytes of [fd] followed by at least one zero page. The
+    // kernel fills the rest of the last file page with zeros as well, so
+    // we get the two null chars the lexer expects without a copy.
+    // Accessing it raises SIGBUS once the file shrinks, so it is only
+    // done if the `map_source_files` option asks for it.
+    static char* map_file(int fd, size_t size, size_t& mapped)
+    {
+      const size_t page = sysconf(_SC_PAGESIZE);
+      const size_t length = (size + page - 1) / page * page;
+      // reserve the range including the zero page(s)
+      void* base = mmap(NULL, length + page, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (base == MAP_FAILED) return nullptr;
+      // private, so accidental writes never reach the file
+      if (mmap(base, length, PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, length + page);
+        return nullptr;
+      }
+      mapped = length + page;
+      return static_cast<char*>(base);
+    }
+
+    #endif
+
+    // release what `read_file` returned
+    void free_file(char* contents, size_t mapped)
+    {
+      #ifndef _WIN32
+        if (mapped) {
+          munmap(contents, mapped);
+          return;
+        }
+      #endif
+      free(contents);
+    }
+
     // try to load the given filename
     // returned memory must be freed
     // will auto convert .sass files
-    char* read_file(const sass::string& path)
+    char* read_file(const sass::string& path, size_t* mapped, size_t* length)
     {
+      sass::string extension;
+      if (path.length() > 5) {
+        extension = path.substr(path.length() - 5, 5);
+      }
+      Util::ascii_str_tolower(&extension);
+      if (mapped) *mapped = 0;
       #ifdef _WIN32
         BYTE* pBuffer;
         DWORD dwBytes;
@@ -469,6 +524,7 @@ namespace Sass {
         CloseHandle(hFile);
         // just convert from unsigned char*
         char* contents = (char*) pBuffer;
+        if (length) *length = dwFileLength;
       #else
         // Read the file using `<cstdio>` instead of `<fstream>` for better portability.
         // The `<fstream>` header initializes `<locale>` and this buggy in GCC4/5 with static linking.
@@ -477,6 +533,19 @@ namespace Sass {
         // https://github.com/sass/sassc-ruby/issues/128
         struct stat st;
         if (stat(path.c_str(), &st) == -1 || S_ISDIR(st.st_mode)) return 0;
+        // indented syntax is converted anyway
+        if (mapped && S_ISREG(st.st_mode) &&
+            size_t(st.st_size) >= map_threshold && extension != ".sass") {
+          int fd = open(path.c_str(), O_RDONLY);
+          if (fd == -1) return nullptr;
+          char* contents = map_file(fd, st.st_size, *mapped);
+          close(fd);
+          // just read it otherwise
+          if (contents) {
+            if (length) *length = st.st_size;
+            return contents;
+          }
+        }
         FILE* fd = std::fopen(path.c_str(), "rb");
         if (fd == nullptr) return nullptr;
         const std::size_t size = st.st_size;
@@ -492,15 +561,12 @@ namespace Sass {
         }
         contents[size] = '\0';
         contents[size + 1] = '\0';
+        if (length) *length = size;
       #endif
-      sass::string extension;
-      if (path.length() > 5) {
-        extension = path.substr(path.length() - 5, 5);
-      }
-      Util::ascii_str_tolower(&extension);
       if (extension == ".sass" && contents != 0) {
         char * converted = sass2scss(contents, SASS2SCSS_PRETTIFY_1 | SASS2SCSS_KEEP_COMMENT);
         free(contents); // free the indented contents
+        if (length) *length = std::strlen(converted);
         return converted; // should be freed by caller
       } else {
         return contents;
@@ -66,7 +66,13 @@ namespace Sass {
     // try to load the given filename
     // returned memory must be freed
     // will auto convert .sass files
-    char* read_file(const sass::string& file);
+    // large files are mapped into memory if [mapped]
+    // is given, which then gets the size of the mapping
+    // [length] gets the length of the contents if given
+    char* read_file(const sass::string& file, size_t* mapped = nullptr, size_t* length = nullptr);
+
+    // release what `read_file` returned
+    void free_file(char* contents, size_t mapped);
 
   }
 
@@ -106,15 +112,25 @@ namespace Sass {
       char* contents;
       // connected sourcemap
       char* srcmap;
+      // size of the memory mapping
+      // (zero if contents are malloced)
+      size_t mapped;
+      // length of the contents
+      // (npos if it is not known)
+      size_t length;
     public:
-      Resource(char* contents, char* srcmap)
-      : contents(contents), srcmap(srcmap)
+      Resource(char* contents, char* srcmap, size_t mapped = 0, size_t length = sass::string::npos)
+      : contents(contents), srcmap(srcmap), mapped(mapped), length(length)
       { }
   };
 
+  class DirectoryCache;
+
   namespace File {
 
+    // checks the candidates via [listings] if given
     sass::vector<Include> resolve_includes(const sass::string& root, const sass::string& file,
+      DirectoryCache* listings = nullptr,
       const sass::vector<sass::string>& exts = { ".scss", ".sass", ".css" });
 
   }
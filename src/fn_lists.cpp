@@ -169,7 +169,6 @@ namespace Sass {
       if (m2) {
         l2 = m2->to_list(pstate);
       }
-      size_t len = l1->length() + l2->length();
       sass::string sep_str = unquote(sep->value());
       if (sep_str == "space") sep_val = SASS_SPACE;
       else if (sep_str == "comma") sep_val = SASS_COMMA;
@@ -179,9 +178,14 @@ namespace Sass {
       if (!bracketed_is_auto) {
         is_bracketed = !bracketed->is_false();
       }
-      List_Obj result = SASS_MEMORY_NEW(List, pstate, len, sep_val, false, is_bracketed);
-      result->concat(l1);
+      List_Obj result = SASS_MEMORY_NEW(List, pstate, 0, sep_val, false, is_bracketed);
+      // shares the items of l1
+      result->share(*l1);
       result->concat(l2);
+      // all items are already evaluated
+      if (!l1->is_arglist() && !l2->is_arglist()) {
+        result->is_expanded(true);
+      }
       return result.detach();
     }
 
@@ -202,7 +206,13 @@ namespace Sass {
       if (m) {
         l = m->to_list(pstate);
       }
-      List* result = SASS_MEMORY_COPY(l);
+      List* result = SASS_MEMORY_NEW(List, l->pstate(), 0, l->separator(),
+        l->is_arglist(), l->is_bracketed());
+      // shares the items of l
+      result->share(*l);
+      result->from_selector(l->from_selector());
+      result->is_delayed(l->is_delayed());
+      result->is_interpolant(l->is_interpolant());
       sass::string sep_str(unquote(sep->value()));
       if (sep_str != "auto") { // check default first
         if (sep_str == "space") result->separator(SASS_SPACE);
@@ -219,6 +229,8 @@ namespace Sass {
 
       } else {
         result->append(v);
+        // all items are already evaluated
+        result->is_expanded(true);
       }
       return result;
     }
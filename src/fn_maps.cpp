@@ -64,28 +64,34 @@ namespace Sass {
       Map_Obj m1 = ARGM("$map1", Map);
       Map_Obj m2 = ARGM("$map2", Map);
 
-      size_t len = m1->length() + m2->length();
-      Map* result = SASS_MEMORY_NEW(Map, pstate, len);
+      Map* result = SASS_MEMORY_NEW(Map, pstate);
       // concat not implemented for maps
+      // shares all entries of m1
       *result += m1;
       *result += m2;
+      // both maps are already evaluated
+      result->is_expanded(true);
       return result;
     }
 
     Signature map_remove_sig = "map-remove($map, $keys...)";
     BUILT_IN(map_remove)
     {
-      bool remove;
       Map_Obj m = ARGM("$map", Map);
       List_Obj arglist = ARG("$keys", List);
-      Map* result = SASS_MEMORY_NEW(Map, pstate, 1);
-      for (auto key : m->keys()) {
-        remove = false;
-        for (size_t j = 0, K = arglist->length(); j < K && !remove; ++j) {
-          remove = Operators::eq(key, arglist->value_at_index(j));
+      Map* result = SASS_MEMORY_NEW(Map, pstate);
+      *result += m;
+      for (size_t j = 0, K = arglist->length(); j < K; ++j) {
+        ExpressionObj key = arglist->value_at_index(j);
+        if (result->erase(key)) continue;
+        // keys can be equal with different hashes (e.g. `1` and `1px`)
+        ExpressionObj equal;
+        for (auto other : result->keys()) {
+          if (Operators::eq(other, key)) { equal = other; break; }
         }
-        if (!remove) *result << std::make_pair(key, m->at(key));
+        if (equal) result->erase(equal);
       }
+      result->is_expanded(true);
       return result;
     }
 
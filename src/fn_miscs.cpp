@@ -55,7 +55,7 @@ namespace Sass {
 
       sass::string name = Util::normalize_underscores(unquote(ss->value()));
 
-      if(d_env.has(name+"[f]")) {
+      if(d_env.has(EnvKey(name, EnvKey::FUNCTION))) {
         return SASS_MEMORY_NEW(Boolean, pstate, true);
       }
       else {
@@ -68,7 +68,7 @@ namespace Sass {
     {
       sass::string s = Util::normalize_underscores(unquote(ARG("$name", String_Constant)->value()));
 
-      if(d_env.has(s+"[m]")) {
+      if(d_env.has(EnvKey(s, EnvKey::MIXIN))) {
         return SASS_MEMORY_NEW(Boolean, pstate, true);
       }
       else {
@@ -76,18 +76,20 @@ namespace Sass {
       }
     }
 
+    // not a function local static, since it must be created
+    // outside of any compiler's memory pool (it's never freed)
+    static const auto *const features = new std::unordered_set<sass::string> {
+      "global-variable-shadowing",
+      "extend-selector-pseudoclass",
+      "at-error",
+      "units-level-3",
+      "custom-property"
+    };
+
     Signature feature_exists_sig = "feature-exists($feature)";
     BUILT_IN(feature_exists)
     {
       sass::string s = unquote(ARG("$feature", String_Constant)->value());
-
-      static const auto *const features = new std::unordered_set<sass::string> {
-        "global-variable-shadowing",
-        "extend-selector-pseudoclass",
-        "at-error",
-        "units-level-3",
-        "custom-property"
-      };
       return SASS_MEMORY_NEW(Boolean, pstate, features->find(s) != features->end());
     }
 
@@ -205,7 +207,7 @@ namespace Sass {
       if (!d_env.has_global("is_in_mixin")) {
         error("Cannot call content-exists() except within a mixin.", pstate, traces);
       }
-      return SASS_MEMORY_NEW(Boolean, pstate, d_env.has_lexical("@content[m]"));
+      return SASS_MEMORY_NEW(Boolean, pstate, d_env.has_lexical(EnvKey("@content", EnvKey::MIXIN)));
     }
 
     Signature get_function_sig = "get-function($name, $css: false)";
@@ -217,7 +219,7 @@ namespace Sass {
       }
 
       sass::string name = Util::normalize_underscores(unquote(ss->value()));
-      sass::string full_name = name + "[f]";
+      EnvKey full_name(name, EnvKey::FUNCTION);
 
       Boolean_Obj css = ARG("$css", Boolean);
       if (!css->is_false()) {
@@ -50,7 +50,9 @@ namespace Sass {
     // random_device degrades sharply once the entropy pool
     // is exhausted. For practical use, random_device is
     // generally only used to seed a PRNG such as mt19937.
-    static std::mt19937 rand(static_cast<unsigned int>(GetSeed()));
+    // Each thread gets its own generator, as the state is
+    // modified on every call (compilations run in parallel).
+    static thread_local std::mt19937 rand(static_cast<unsigned int>(GetSeed()));
 
     ///////////////////
     // NUMBER FUNCTIONS
@@ -0,0 +1,205 @@
+// sass.hpp must go before all system headers to get the
+// __EXTENSIONS__ fix on Solaris.
+#include "sass.hpp"
+
+#include <system_error>
+
+#include "import_prefetch.hpp"
+#include "context.hpp"
+#include "prelexer.hpp"
+#include "memory.hpp"
+#include "file.hpp"
+#include "util.hpp"
+
+namespace Sass {
+
+  ImportPrefetch::ImportPrefetch(Context& ctx, size_t threads)
+  : ctx(ctx),
+    stopping(false)
+  {
+    // custom importers may take over any import
+    if (!ctx.c_importers.empty()) return;
+    if (!ctx.c_headers.empty()) return;
+    try {
+      for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&ImportPrefetch::work, this);
+      }
+    }
+    // just use the workers we got
+    catch (const std::system_error&) {}
+    if (!workers.empty()) ctx.prefetch = this;
+  }
+
+  ImportPrefetch::~ImportPrefetch()
+  {
+    if (ctx.prefetch == this) {
+      ctx.prefetch = nullptr;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    changed.notify_all();
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+    // release contents nobody asked for
+    for (auto& job : jobs) {
+      File::free_file(job.second.contents, job.second.mapped);
+    }
+  }
+
+  void ImportPrefetch::work()
+  {
+    // The pool of the compiler is not thread safe, so our own
+    // data comes from the system and every tree has its pool.
+    MemoryPoolScope scope(nullptr);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      changed.wait(lock, [this] { return stopping || !queue.empty(); });
+      if (stopping) return;
+      sass::string abs_path(queue.front());
+      queue.pop_front();
+      Job& job = jobs[abs_path];
+      // the context may have read it itself
+      if (job.state != QUEUED) continue;
+      job.state = RUNNING;
+      lock.unlock();
+
+      char* contents = nullptr;
+      size_t mapped = 0, length = 0;
+      MemoryPoolPtr pool(makeSharedPool());
+      SourceFileObj source;
+      Block_Obj root;
+      sass::vector<DeferredImport> imports;
+      sass::vector<sass::string> paths;
+      try {
+        contents = File::read_file(abs_path,
+          ctx.c_options.map_source_files ? &mapped : nullptr, &length);
+        if (contents) {
+          {
+            MemoryPoolScope scope(pool.get());
+            // gets the real index once it is registered
+            source = SASS_MEMORY_NEW(SourceFile,
+              abs_path.c_str(), contents, sass::string::npos, true, length);
+            root = ctx.parse_deferred(source, imports);
+          }
+          if (!root.isNull()) {
+            find_includes(imports, source->getPath(), paths);
+          }
+        }
+      }
+      catch (...) {
+        root = {};
+        imports.clear();
+      }
+
+      lock.lock();
+      // Reference counts are not atomic, so we must hand over
+      // our references while the context can't take them yet.
+      job.pool = pool;
+      job.contents = contents;
+      job.mapped = mapped;
+      job.length = length;
+      job.source = source; source = {};
+      job.root = root; root = {};
+      job.imports.swap(imports);
+      job.state = DONE;
+      schedule(paths);
+      changed.notify_all();
+    }
+  }
+
+  void ImportPrefetch::find_includes(const sass::vector<DeferredImport>& imports,
+    const char* ctx_path, sass::vector<sass::string>& paths)
+  {
+    using namespace Prelexer;
+    for (const DeferredImport& deferred : imports) {
+      // these are kept as plain css imports
+      if (deferred.imp->import_queries()) continue;
+      for (auto location : deferred.locations) {
+        if (location.second) continue;
+        // same checks as in `Context::import_url`
+        sass::string imp_path(unquote(location.first));
+        if (const char* proto = sequence< identifier, exactly<':'>, exactly<'/'>, exactly<'/'> >(imp_path.c_str())) {
+          if (sass::string(imp_path.c_str(), proto - 3) != "file") continue;
+        }
+        if (imp_path.substr(0, 2) == "//") continue;
+        if (imp_path.length() > 4 && imp_path.substr(imp_path.length() - 4, 4) == ".css") continue;
+        // ambiguous or missing imports are reported by the context
+        const sass::vector<Include> resolved(ctx.find_includes({ imp_path, ctx_path }));
+        if (resolved.size() == 1) paths.push_back(resolved[0].abs_path);
+      }
+    }
+  }
+
+  void ImportPrefetch::schedule(const sass::vector<sass::string>& paths)
+  {
+    for (const sass::string& path : paths) {
+      if (jobs.count(path)) continue;
+      jobs[path].state = QUEUED;
+      queue.push_back(path);
+    }
+  }
+
+  Block_Obj ImportPrefetch::parse(SourceFile* source,
+    sass::vector<DeferredImport>& imports)
+  {
+    Block_Obj root = ctx.parse_deferred(source, imports);
+    if (root.isNull()) return {};
+    // the workers release these
+    MemoryPoolScope scope(nullptr);
+    sass::vector<sass::string> paths;
+    find_includes(imports, source->getPath(), paths);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      schedule(paths);
+    }
+    changed.notify_all();
+    return root;
+  }
+
+  char* ImportPrefetch::read_file(const sass::string& abs_path, size_t* mapped, size_t* length)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = jobs.find(abs_path);
+    if (it != jobs.end()) {
+      Job& job = it->second;
+      // faster to read it than to wait
+      if (job.state == QUEUED) {
+        job.state = TAKEN;
+      }
+      changed.wait(lock, [&job] { return job.state != RUNNING; });
+      if (job.state == DONE && job.contents) {
+        job.given = job.contents;
+        job.contents = nullptr;
+        if (mapped) *mapped = job.mapped;
+        if (length) *length = job.length;
+        return const_cast<char*>(job.given);
+      }
+    }
+    lock.unlock();
+    return File::read_file(abs_path, mapped, length);
+  }
+
+  bool ImportPrefetch::take(const sass::string& abs_path, const char* contents,
+    SourceFileObj& source, Block_Obj& root,
+    sass::vector<DeferredImport>& imports,
+    MemoryPoolPtr& pool)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = jobs.find(abs_path);
+    if (it == jobs.end()) return false;
+    Job& job = it->second;
+    if (job.state != DONE) return false;
+    if (job.given != contents) return false;
+    if (job.root.isNull()) return false;
+    source = job.source; job.source = {};
+    root = job.root; job.root = {};
+    imports.swap(job.imports);
+    pool = job.pool;
+    job.state = TAKEN;
+    return true;
+  }
+
+}
@@ -0,0 +1,101 @@
+#ifndef SASS_IMPORT_PREFETCH_H
+#define SASS_IMPORT_PREFETCH_H
+
+// sass.hpp must go before all system headers to get the
+// __EXTENSIONS__ fix on Solaris.
+#include "sass.hpp"
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "parser.hpp"
+#include "source.hpp"
+
+namespace Sass {
+
+  // Reads and parses imported files ahead of time on worker threads.
+  // Files are parsed with deferred imports (see `DeferredImport`), the
+  // context then resolves them on its own thread in document order.
+  // Resources thereby get the same indexes as without prefetching and
+  // the evaluation order is unchanged. Workers never touch the context
+  // apart from resolving include paths. Files that fail to parse are
+  // parsed again the regular way, which reports the error as before.
+  // Every file is parsed into its own memory pool, since the pools
+  // are not thread safe and the tree may outlive the compilation.
+  // Prefetching is only enabled if there are no custom importers.
+  class ImportPrefetch {
+
+  private:
+
+    enum State { QUEUED, RUNNING, DONE, TAKEN };
+
+    struct Job {
+      // the nodes are allocated from (released last)
+      MemoryPoolPtr pool;
+      State state;
+      // file contents (until handed out)
+      char* contents;
+      // see `File::read_file`
+      size_t mapped;
+      size_t length;
+      // contents that were handed out
+      const char* given;
+      SourceFileObj source;
+      Block_Obj root;
+      sass::vector<DeferredImport> imports;
+      Job() : state(QUEUED), contents(nullptr), mapped(0), length(0), given(nullptr) {}
+    };
+
+    Context& ctx;
+    std::mutex mutex;
+    std::condition_variable changed;
+    // all files ever scheduled by absolute path
+    std::map<sass::string, Job> jobs;
+    std::deque<sass::string> queue;
+    std::vector<std::thread> workers;
+    bool stopping;
+
+    // Main loop of every worker thread
+    void work();
+
+    // Appends the files [imports] will resolve to
+    void find_includes(const sass::vector<DeferredImport>& imports,
+      const char* ctx_path, sass::vector<sass::string>& paths);
+
+    // Queues all [paths] not scheduled yet (must hold the lock)
+    void schedule(const sass::vector<sass::string>& paths);
+
+  public:
+
+    // Starts [threads] workers and registers on [ctx]
+    ImportPrefetch(Context& ctx, size_t threads);
+
+    // Stops and joins all workers
+    ~ImportPrefetch();
+
+    // Parses [source] on the calling thread with deferred
+    // [imports] and schedules the imported files right away.
+    // Returns a null block if it must be parsed regularly.
+    Block_Obj parse(SourceFile* source,
+      sass::vector<DeferredImport>& imports);
+
+    // Returns the contents of [abs_path] like `File::read_file`.
+    // Waits for the worker if the file is currently being read.
+    char* read_file(const sass::string& abs_path, size_t* mapped, size_t* length);
+
+    // Takes the ast of [abs_path] if it was parsed from [contents]
+    // (as returned by `read_file`) with its deferred [imports].
+    // The nodes come from [pool], which must outlive all users.
+    bool take(const sass::string& abs_path, const char* contents,
+      SourceFileObj& source, Block_Obj& root,
+      sass::vector<DeferredImport>& imports,
+      MemoryPoolPtr& pool);
+
+  };
+
+}
+
+#endif
@@ -5,7 +5,7 @@
 #include <cmath>
 #include <string>
 #include <iostream>
-#include <iomanip>
+#include <sstream>
 #include <stdint.h>
 #include <stdint.h>
 
@@ -14,6 +14,7 @@
 #include "context.hpp"
 #include "listize.hpp"
 #include "color_maps.hpp"
+#include "util_string.hpp"
 #include "utf8/checked.h"
 
 namespace Sass {
@@ -570,30 +571,12 @@ namespace Sass {
     // reduce units
     n->reduce();
 
-    sass::ostream ss;
-    ss.precision(opt.precision);
-    ss << std::fixed << n->value();
-
-    sass::string res = ss.str();
-    size_t s = res.length();
-
-    // delete trailing zeros
-    for(s = s - 1; s > 0; --s)
-    {
-        if(res[s] == '0') {
-          res.erase(s, 1);
-        }
-        else break;
-    }
-
-    // delete trailing decimal separator
-    if(res[s] == '.') res.erase(s, 1);
+    // without trailing zeros and decimal separator
+    sass::string res;
+    Util::append_fixed(res, n->value(), opt.precision);
 
     // some final cosmetics
-    if (res == "0.0") res = "0";
-    else if (res == "") res = "0";
-    else if (res == "-0") res = "0";
-    else if (res == "-0.0") res = "0";
+    if (res == "-0") res = "0";
     else if (opt.output_style == COMPRESSED)
     {
       if (n->zero()) {
@@ -624,10 +607,29 @@ namespace Sass {
     else                return c;
   }
 
+  // appends the alpha channel like a stream with its default
+  // precision of 6 significant digits (but without the stream)
+  static void append_alpha(sass::string& res, double a)
+  {
+    // streams switch to scientific notation below 0.0001
+    if (a == 0 || (a >= 0.0001 && a < 1)) {
+      int decimals = 6;
+      if (a < 0.1) ++decimals;
+      if (a < 0.01) ++decimals;
+      if (a < 0.001) ++decimals;
+      Util::append_fixed(res, a, decimals);
+    }
+    else {
+      sass::ostream ss;
+      ss << a;
+      res += ss.str();
+    }
+  }
+
   void Inspect::operator()(Color_RGBA* c)
   {
     // output the final token
-    sass::ostream ss;
+    sass::string res;
 
     // original color name
     // maybe an unknown token
@@ -656,57 +658,65 @@ namespace Sass {
         res_name = color_to_name(numval);
     }
 
-    sass::ostream hexlet;
+    // channels are capped to 0-255
+    static const char digits[] = "0123456789abcdef";
+    const unsigned long channels[] = {
+      static_cast<unsigned long>(r),
+      static_cast<unsigned long>(g),
+      static_cast<unsigned long>(b)
+    };
+
+    sass::string hexlet(1, '#');
     // dart sass compressed all colors in regular css always
     // ruby sass and libsass does it only when not delayed
     // since color math is going to be removed, this can go too
     bool compressed = opt.output_style == COMPRESSED;
-    hexlet << '#' << std::setw(1) << std::setfill('0');
     // create a short color hexlet if there is any need for it
     if (compressed && is_color_doublet(r, g, b) && a == 1) {
-      hexlet << std::hex << std::setw(1) << (static_cast<unsigned long>(r) >> 4);
-      hexlet << std::hex << std::setw(1) << (static_cast<unsigned long>(g) >> 4);
-      hexlet << std::hex << std::setw(1) << (static_cast<unsigned long>(b) >> 4);
+      for (unsigned long channel : channels) {
+        hexlet += digits[channel >> 4];
+      }
     } else {
-      hexlet << std::hex << std::setw(2) << static_cast<unsigned long>(r);
-      hexlet << std::hex << std::setw(2) << static_cast<unsigned long>(g);
-      hexlet << std::hex << std::setw(2) << static_cast<unsigned long>(b);
+      for (unsigned long channel : channels) {
+        hexlet += digits[channel >> 4];
+        hexlet += digits[channel & 0xF];
+      }
     }
 
     if (compressed && !c->is_delayed()) name = "";
     if (opt.output_style == INSPECT && a >= 1) {
-      append_token(hexlet.str(), c);
+      append_token(hexlet, c);
       return;
     }
 
     // retain the originally specified color definition if unchanged
     if (name != "") {
-      ss << name;
+      res = name;
     }
     else if (a >= 1) {
       if (res_name != "") {
-        if (compressed && hexlet.str().size() < res_name.size()) {
-          ss << hexlet.str();
+        if (compressed && hexlet.size() < res_name.size()) {
+          res = hexlet;
         } else {
-          ss << res_name;
+          res = res_name;
         }
       }
       else {
-        ss << hexlet.str();
+        res = hexlet;
       }
     }
     else {
-      ss << "rgba(";
-      ss << static_cast<unsigned long>(r) << ",";
-      if (!compressed) ss << " ";
-      ss << static_cast<unsigned long>(g) << ",";
-      if (!compressed) ss << " ";
-      ss << static_cast<unsigned long>(b) << ",";
-      if (!compressed) ss << " ";
-      ss << a << ')';
+      const char* separator = compressed ? "," : ", ";
+      res = "rgba(";
+      for (unsigned long channel : channels) {
+        res += std::to_string(channel).c_str();
+        res += separator;
+      }
+      append_alpha(res, a);
+      res += ')';
     }
 
-    append_token(ss.str(), c);
+    append_token(res, c);
 
   }
 
@@ -4,10 +4,39 @@
 
 #include <iostream>
 #include <iomanip>
+#include <cstdint>
 #include "lexer.hpp"
 #include "constants.hpp"
 #include "util_string.hpp"
 
+#ifndef __has_feature
+#define __has_feature(feature) 0
+#endif
+
+// The aligned loads below may read past the terminating null, but never
+// into another page (like libc's strlen). Sanitizers can't tell these
+// reads apart from real overflows (they may hit a neighbouring block
+// that was freed by another thread), so they only get the scalar loops.
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__) || \
+    __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || \
+    __has_feature(memory_sanitizer)
+#define SASS_LEXER_SANITIZED
+#endif
+
+// SSE2 is part of every x86-64 target
+#if !defined(SASS_LEXER_SANITIZED) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SASS_LEXER_SSE2
+#include <emmintrin.h>
+#endif
+
+// In case a sanitizer is used without announcing itself
+#if defined(SASS_LEXER_SSE2) && defined(__GNUC__)
+#define SASS_LEXER_NO_SANITIZE __attribute__((no_sanitize_address, no_sanitize_thread))
+#else
+#define SASS_LEXER_NO_SANITIZE
+#endif
+
 
 namespace Sass {
   using namespace Constants;
@@ -86,6 +115,55 @@ namespace Sass {
     // Match any single character.
     const char* any_char(const char* src) { return *src ? src + 1 : src; }
 
+    SASS_LEXER_NO_SANITIZE
+    const char* find_first_of(const char* src, char a, char b, char c, char d)
+    {
+      #ifdef SASS_LEXER_SSE2
+      // go char by char until the loads are aligned
+      // most runs are short and end in here already
+      while (reinterpret_cast<uintptr_t>(src) & 15) {
+        if (!*src || *src == a || *src == b || *src == c || *src == d) return src;
+        ++ src;
+      }
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b);
+      const __m128i vc = _mm_set1_epi8(c), vd = _mm_set1_epi8(d);
+      while (true) {
+        __m128i chunk = _mm_load_si128(reinterpret_cast<const __m128i*>(src));
+        __m128i hits = _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(chunk, zero), _mm_cmpeq_epi8(chunk, va)),
+          _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, vb), _mm_cmpeq_epi8(chunk, vc)), _mm_cmpeq_epi8(chunk, vd)));
+        // the scalar loop finds it within this chunk
+        if (_mm_movemask_epi8(hits)) break;
+        src += 16;
+      }
+      #endif
+      while (*src && *src != a && *src != b && *src != c && *src != d) ++ src;
+      return src;
+    }
+
+    SASS_LEXER_NO_SANITIZE
+    const char* find_first_not_in(const char* src, char lo, char hi)
+    {
+      #ifdef SASS_LEXER_SSE2
+      while (reinterpret_cast<uintptr_t>(src) & 15) {
+        if (*src < lo || *src > hi) return src;
+        ++ src;
+      }
+      // signed compares, so non-ascii chars are below lo
+      const __m128i below = _mm_set1_epi8(lo - 1);
+      const __m128i above = _mm_set1_epi8(hi + 1);
+      while (true) {
+        __m128i chunk = _mm_load_si128(reinterpret_cast<const __m128i*>(src));
+        __m128i inside = _mm_and_si128(_mm_cmpgt_epi8(chunk, below), _mm_cmplt_epi8(chunk, above));
+        if (_mm_movemask_epi8(inside) != 0xFFFF) break;
+        src += 16;
+      }
+      #endif
+      while (*src >= lo && *src <= hi) ++ src;
+      return src;
+    }
+
     // Match word boundary (zero-width lookahead).
     const char* word_boundary(const char* src) { return is_character(*src) || *src == '#' ? 0 : src; }
 
@@ -53,6 +53,14 @@ namespace Sass {
     // Match any single character (/./).
     const char* any_char(const char* src);
 
+    // Skip to the first of the chars or the terminating null.
+    // Scans 16 chars per step where SSE2 is available.
+    const char* find_first_of(const char* src, char a, char b, char c, char d);
+
+    // Skip to the first char outside of [lo, hi] (must not
+    // contain null). Scans 16 chars per step with SSE2.
+    const char* find_first_not_in(const char* src, char lo, char hi);
+
     // Assert word boundary (/\b/)
     // Is a zero-width positive lookaheads
     const char* word_boundary(const char* src);
@@ -168,6 +176,25 @@ namespace Sass {
       return (*src && *src != chr) ? src + 1 : 0;
     }
 
+    // Match all except the supplied ones.
+    // Skips long runs in one go (see above).
+    // Regex equivalent: /[^abcd]+/
+    template <char a, char b = a, char c = b, char d = c>
+    const char* any_chars_but(const char* src) {
+      const char* p = find_first_of(src, a, b, c, d);
+      return p == src ? 0 : p;
+    }
+
+    // Match chars within the supplied ascii range.
+    // Skips long runs in one go (see above).
+    // Regex equivalent: /[lo-hi]+/
+    template <char lo, char hi>
+    const char* char_ranges(const char* src) {
+      static_assert(lo > 0 && lo <= hi && hi < 127, "invalid char range");
+      const char* p = find_first_not_in(src, lo, hi);
+      return p == src ? 0 : p;
+    }
+
     // Succeeds if the matcher fails.
     // Aka. zero-width negative lookahead.
     // Regex equivalent: /(?!literal)/
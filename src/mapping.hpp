@@ -7,11 +7,13 @@
 namespace Sass {
 
   struct Mapping {
-    Position original_position;
-    Position generated_position;
+    // only resolved once the source map is rendered
+    SourceSpan original_position;
+    // byte offset into the generated output
+    size_t generated_offset;
 
-    Mapping(const Position& original_position, const Position& generated_position)
-    : original_position(original_position), generated_position(generated_position) { }
+    Mapping(const SourceSpan& original_position, size_t generated_offset)
+    : original_position(original_position), generated_offset(generated_offset) { }
   };
 
 }
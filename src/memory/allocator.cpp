@@ -15,32 +15,85 @@ namespace Sass {
   // Only use PODs for thread_local
   // Objects get unpredictable init order
   static thread_local MemoryPool* pool;
-  static thread_local size_t allocations;
+
+  MemoryPoolScope::MemoryPoolScope(MemoryPool* active)
+  : previous(pool)
+  {
+    pool = active;
+  }
+
+  MemoryPoolScope::~MemoryPoolScope()
+  {
+    pool = previous;
+  }
 
   void* allocateMem(size_t size)
   {
+    // Allocations outside of any compiler
+    // (e.g. statics) don't belong to a pool
     if (pool == nullptr) {
-      pool = new MemoryPool();
+      return MemoryPool::allocateMem(size);
     }
-    allocations++;
     return pool->allocate(size);
   }
 
   void deallocateMem(void* ptr, size_t size)
   {
+    // Memory always goes back to where it came
+    // from, no matter which pool is active now
+    if (MemoryPool* owner = MemoryPool::owner(ptr)) {
+      owner->deallocate(ptr);
+      return;
+    }
+    MemoryPool::releaseMem(ptr);
+  }
 
-    // It seems thread_local variable might be discharged!?
-    // But the destructors of e.g. static strings is still
-    // called, although their memory was discharged too.
-    // Fine with me as long as address sanitizer is happy.
-    if (pool == nullptr || allocations == 0) { return; }
+  MemoryPoolPtr makeSharedPool()
+  {
+    return std::make_shared<MemoryPool>();
+  }
 
-    pool->deallocate(ptr);
-    if (--allocations == 0) {
-      delete pool;
-      pool = nullptr;
-    }
+  void retainPool(MemoryPool* pool, const MemoryPoolPtr& other)
+  {
+    if (pool != nullptr) pool->retain(other);
+  }
+
+  MemoryPool* ownerOf(const void* ptr)
+  {
+    return MemoryPool::owner(ptr);
+  }
+
+  bool isReleased(const void* ptr)
+  {
+    MemoryPool* owner = MemoryPool::owner(ptr);
+    return owner != nullptr && owner->isReleased();
+  }
 
+#else
+
+  MemoryPoolScope::MemoryPoolScope(MemoryPool* active)
+  : previous(nullptr)
+  { }
+
+  MemoryPoolScope::~MemoryPoolScope()
+  { }
+
+  MemoryPoolPtr makeSharedPool()
+  {
+    return {};
+  }
+
+  void retainPool(MemoryPool* pool, const MemoryPoolPtr& other)
+  { }
+
+  MemoryPool* ownerOf(const void* ptr)
+  {
+    return nullptr;
+  }
+
+  bool isReleased(const void* ptr)
+  {
+    return false;
   }
 
 #endif
@@ -7,12 +7,49 @@
 
 #include <vector>
 #include <limits>
+#include <memory>
 #include <iostream>
 #include <algorithm>
 #include <functional>
 
 namespace Sass {
 
+  class MemoryPool;
+
+  // Pools of objects that outlive a single compiler (e.g. cached
+  // stylesheets) are shared by everything referencing them.
+  typedef std::shared_ptr<MemoryPool> MemoryPoolPtr;
+
+  // Routes all allocations of the current thread to `pool` until
+  // it goes out of scope, then the previous pool is active again.
+  // Pass a nullptr for objects that must outlive the current pool
+  // (e.g. lazily initialized statics). Without the custom allocator
+  // this does nothing at all.
+  class MemoryPoolScope {
+  public:
+    MemoryPoolScope(MemoryPool* pool);
+    ~MemoryPoolScope();
+  private:
+    MemoryPool* previous;
+  };
+
+  // Creates a pool that can be shared between compilers.
+  // Returns null without the custom allocator.
+  MemoryPoolPtr makeSharedPool();
+
+  // Keeps [other] alive as long as [pool] is, since
+  // the objects of [pool] hold references into it.
+  void retainPool(MemoryPool* pool, const MemoryPoolPtr& other);
+
+  // Returns the pool the object at [ptr] was allocated
+  // from, or null if it did not come from any pool.
+  MemoryPool* ownerOf(const void* ptr);
+
+  // Whether the object at [ptr] goes away with its pool. Such
+  // objects must not be destroyed one by one anymore, since they
+  // may still reference objects the pool has already given up.
+  bool isReleased(const void* ptr);
+
 #ifndef SASS_CUSTOM_ALLOCATOR
 
   template <typename T> using Allocator = std::allocator<T>;
@@ -2,7 +2,8 @@
 #define SASS_MEMORY_CONFIG_H
 
 // Define memory alignment requirements
-#define SASS_MEM_ALIGN sizeof(unsigned int)
+// Enough for pointers and doubles on all platforms
+#define SASS_MEM_ALIGN 8
 
 // Minimal alignment for memory fragments. Must be a multiple
 // of `SASS_MEM_ALIGN` and should not be too big (maybe 1 or 2)
@@ -11,10 +12,11 @@
 // The number of bytes we use for our book-keeping before every
 // memory fragment. Needed to know to which bucket we belongs on
 // deallocations, or if it should go directly to the `free` call.
-#define SassAllocatorBookSize sizeof(unsigned int)
+// Padded to the alignment, so the returned memory is aligned too.
+#define SassAllocatorBookSize SASS_MEM_ALIGN
 
-// Bytes reserve for book-keeping on the arenas
-// Currently unused and for later optimization
-#define SassAllocatorArenaHeadSize 0
+// Bytes reserved for book-keeping on the arenas.
+// Holds the pool owning the arena (see `MemoryPool::owner`).
+#define SassAllocatorArenaHeadSize SASS_MEM_ALIGN
 
-#endif
\ No newline at end of file
+#endif
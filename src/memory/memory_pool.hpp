@@ -2,11 +2,17 @@
 #define SASS_MEMORY_POOL_H
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <iostream>
 #include <algorithm>
 #include <climits>
+#include <memory>
 #include <vector>
 
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
 namespace Sass {
 
   // SIMPLE MEMORY-POOL ALLOCATOR WITH FREE-LIST ON TOP
@@ -34,17 +40,37 @@ namespace Sass {
   // and return it to the caller. Otherwise we have to take out
   // a new slice from the current `arena` and increase `offset`.
 
+  // Allocations that are too big for the buckets are passed to
+  // malloc. They are linked to the pool, so they are released
+  // with the arenas. Allocations made while no pool is active
+  // are marked, so they can be freed without any pool at all.
+
+  // Arenas are aligned to their size and start with a pointer
+  // to their pool. So the pool of every slice can be found from
+  // its address alone (see `owner`). Deallocations always go to
+  // the pool the memory came from, no matter which is active.
+
   // Note that this is not thread safe. This is on purpose as we
-  // want to use the memory pool in a thread local usage. In order
-  // to get this thread safe you need to only allocate one pool
-  // per thread. This can be achieved by using thread local PODs.
-  // Simply create a pool on the first allocation and dispose
-  // it once all allocations have been returned. E.g. by using:
-  // static thread_local size_t allocations;
-  // static thread_local MemoryPool* pool;
+  // want to use the memory pool in a thread local usage. Every
+  // compiler owns one pool, which it activates for the current
+  // thread while it runs (see `MemoryPoolScope`). Once the pool
+  // is deleted, all its arenas are returned to the system at once.
 
   class MemoryPool {
 
+    // Header of allocations too big for the buckets
+    struct LargeHead {
+      MemoryPool* pool;
+      LargeHead* prev;
+      LargeHead* next;
+      size_t size;
+    };
+
+    // Book-keeping of memory from malloc without a pool
+    static const unsigned int SYSTEM = UINT_MAX;
+    // Book-keeping of memory from malloc with a `LargeHead`
+    static const unsigned int LARGE = UINT_MAX - 1;
+
     // Current arena we fill up
     char* arena;
 
@@ -54,39 +80,161 @@ namespace Sass {
     // A list of full arenas
     std::vector<void*> arenas;
 
+    // The most recent allocation too big for the buckets
+    LargeHead* large;
+
     // One pointer for every bucket (zero init)
     #ifdef _MSC_VER
     #pragma warning (suppress:4351)
     #endif
     void* freeList[SassAllocatorBuckets]{};
 
+    // Bytes currently handed out and the most ever
+    size_t bytes;
+    size_t peak;
+
+    // Set once all objects go away with the pool
+    bool released;
+
+    // Pools our objects hold references into
+    std::vector<std::shared_ptr<MemoryPool>> retained;
+
     // Increase the address until it sits on a
     // memory aligned address (maybe use `aligned`).
     inline static size_t alignMemAddr(size_t addr) {
       return (addr + SASS_MEM_ALIGN - 1) & ~(SASS_MEM_ALIGN - 1);
     }
 
+    // Get an arena that is aligned to its size
+    static char* allocateArena()
+    {
+      void* ptr = nullptr;
+      #ifdef _WIN32
+      ptr = _aligned_malloc(SassAllocatorArenaSize, SassAllocatorArenaSize);
+      #else
+      if (posix_memalign(&ptr, SassAllocatorArenaSize, SassAllocatorArenaSize) != 0) ptr = nullptr;
+      #endif
+      if (ptr == nullptr) throw std::bad_alloc();
+      return (char*)ptr;
+    }
+
+    static void freeArena(void* ptr)
+    {
+      #ifdef _WIN32
+      _aligned_free(ptr);
+      #else
+      free(ptr);
+      #endif
+    }
+
+    void count(size_t size)
+    {
+      bytes += size;
+      if (bytes > peak) peak = bytes;
+    }
+
+    // Allocate via malloc, but linked to this pool
+    void* allocateLarge(size_t size)
+    {
+      char* buffer = (char*)malloc(sizeof(LargeHead)
+        + SassAllocatorBookSize + size);
+      if (buffer == nullptr) {
+        throw std::bad_alloc();
+      }
+      LargeHead* head = (LargeHead*)buffer;
+      head->pool = this;
+      head->prev = nullptr;
+      head->next = large;
+      head->size = size;
+      if (large) large->prev = head;
+      large = head;
+      buffer += sizeof(LargeHead);
+      // Mark it for deallocation via free
+      ((unsigned int*)buffer)[0] = LARGE;
+      count(size);
+      // Return pointer after our book-keeping space
+      return (void*)(buffer + SassAllocatorBookSize);
+    }
+
   public:
 
+    // Allocate directly via malloc, but with the same
+    // book-keeping, so it can be released via any pool
+    // or `releaseMem` (used when no pool is active).
+    static void* allocateMem(size_t size)
+    {
+      char* buffer = (char*)malloc(
+        SassAllocatorBookSize + size);
+      if (buffer == nullptr) {
+        throw std::bad_alloc();
+      }
+      // Mark it for deallocation via free
+      ((unsigned int*)buffer)[0] = SYSTEM;
+      // Return pointer after our book-keeping space
+      return (void*)(buffer + SassAllocatorBookSize);
+    }
+
+    // Release memory from `allocateMem`, memory
+    // of pools is released via its pool.
+    static void releaseMem(void* ptr)
+    {
+      // Rewind buffer from pointer
+      char* buffer = (char*)ptr -
+        SassAllocatorBookSize;
+      if (((unsigned int*)buffer)[0] == SYSTEM) {
+        free(buffer);
+      }
+    }
+
+    // Returns the pool [ptr] was allocated from,
+    // or null if it came from `allocateMem`.
+    static MemoryPool* owner(const void* ptr)
+    {
+      // Rewind buffer from pointer
+      const char* buffer = (const char*)ptr -
+        SassAllocatorBookSize;
+      unsigned int bucket = ((const unsigned int*)buffer)[0];
+      if (bucket == SYSTEM) return nullptr;
+      if (bucket == LARGE) {
+        return ((const LargeHead*)buffer - 1)->pool;
+      }
+      // Slices never cross the end of their arena
+      uintptr_t base = (uintptr_t)buffer &
+        ~(uintptr_t)(SassAllocatorArenaSize - 1);
+      return ((MemoryPool* const*)base)[0];
+    }
+
     // Default ctor
     MemoryPool() :
       // Wait for first allocation
       arena(nullptr),
       // Set to maximum value in order to
       // make an allocation on the first run
-      offset(std::string::npos)
+      offset(std::string::npos),
+      large(nullptr),
+      bytes(0),
+      peak(0),
+      released(false)
     {
     }
 
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+
     // Destructor
     ~MemoryPool() {
       // Delete full arenas
       for (auto area : arenas) {
-        free(area);
+        freeArena(area);
       }
       // Delete current arena
-      free(arena);
-
+      if (arena) freeArena(arena);
+      // Delete big allocations
+      while (large) {
+        LargeHead* next = large->next;
+        free(large);
+        large = next;
+      }
     }
 
     // Allocate a slice of the memory pool
@@ -108,14 +256,7 @@ namespace Sass {
       // Everything bigger is allocated via malloc
       // Malloc is optimized for exactly this case
       if (bucket >= SassAllocatorBuckets) {
-        char* buffer = (char*)malloc(size);
-        if (buffer == nullptr) {
-          throw std::bad_alloc();
-        }
-        // Mark it for deallocation via free
-        ((unsigned int*)buffer)[0] = UINT_MAX;
-        // Return pointer after our book-keeping space
-        return (void*)(buffer + SassAllocatorBookSize);
+        return allocateLarge(size);
       }
       // Use custom allocator
       else {
@@ -127,6 +268,7 @@ namespace Sass {
           void* ptr = free;
           // Update free list pointer
           free = ((void**)ptr)[0];
+          count(size);
           // Return popped item
           return ptr;
         }
@@ -135,8 +277,9 @@ namespace Sass {
       // Make sure we have enough space in the arena
       if (!arena || offset > SassAllocatorArenaSize - size) {
         if (arena) arenas.emplace_back(arena);
-        arena = (char*)malloc(SassAllocatorArenaSize);
-        if (arena == nullptr) throw std::bad_alloc();
+        arena = allocateArena();
+        // Let slices find their pool
+        ((MemoryPool**)arena)[0] = this;
         offset = SassAllocatorArenaHeadSize;
       }
 
@@ -144,6 +287,7 @@ namespace Sass {
       char* buffer = arena + offset;
       // Consume object size
       offset += size;
+      count(size);
 
       // Set the bucket index for this slice
       ((unsigned int*)buffer)[0] = (unsigned int)bucket;
@@ -154,9 +298,13 @@ namespace Sass {
     }
     // EO allocate
 
+    // Give back memory allocated from this pool
     void deallocate(void* ptr)
     {
 
+      // Everything is freed at once anyway
+      if (released) return;
+
       // Rewind buffer from pointer
       char* buffer = (char*)ptr -
         SassAllocatorBookSize;
@@ -165,20 +313,46 @@ namespace Sass {
       unsigned int bucket = ((unsigned int*)buffer)[0];
 
       // Check allocation method
-      if (bucket != UINT_MAX) {
+      if (bucket != LARGE) {
         // Let memory point to previous item in free list
         ((void**)ptr)[0] = freeList[bucket];
         // Free list now points to our memory
         freeList[bucket] = (void*)ptr;
+        bytes -= bucket * SASS_MEM_ALIGN;
       }
       else {
-        // Release memory
-        free(buffer);
+        // Unlink and release memory
+        LargeHead* head = (LargeHead*)buffer - 1;
+        if (head->prev) head->prev->next = head->next;
+        else large = head->next;
+        if (head->next) head->next->prev = head->prev;
+        bytes -= head->size;
+        free(head);
       }
 
     }
     // EO deallocate
 
+    // From now on objects of this pool are not destroyed one
+    // by one anymore, they all go away once it is deleted.
+    void release() { released = true; }
+    bool isReleased() const { return released; }
+
+    // Keeps [other] alive as long as this pool,
+    // since our objects hold references into it
+    void retain(const std::shared_ptr<MemoryPool>& other)
+    {
+      if (!other || other.get() == this) return;
+      for (const auto& pool : retained) {
+        if (pool == other) return;
+      }
+      retained.push_back(other);
+    }
+
+    size_t getBytes() const { return bytes; }
+    size_t getPeak() const { return peak; }
+    size_t getArenas() const { return arenas.size() + (arena ? 1 : 0); }
+
   };
 
 }
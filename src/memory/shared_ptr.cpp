@@ -13,6 +13,7 @@ namespace Sass {
 
   #ifdef DEBUG_SHARED_PTR
   void SharedObj::dumpMemLeaks() {
+    std::lock_guard<std::mutex> lock(allMutex);
     if (!all.empty()) {
       std::cerr << "###################################\n";
       std::cerr << "# REPORTING MISSING DEALLOCATIONS #\n";
@@ -26,8 +27,9 @@ namespace Sass {
       }
     }
   }
+  std::mutex SharedObj::allMutex;
   sass::vector<SharedObj*> SharedObj::all;
   #endif
 
-  bool SharedObj::taint = false;
+  thread_local bool SharedObj::taint = false;
 }
@@ -10,6 +10,9 @@
 #include <string>
 #include <type_traits>
 #include <vector>
+#ifdef DEBUG_SHARED_PTR
+#include <mutex>
+#endif
 
 // https://lokiastari.com/blog/2014/12/30/c-plus-plus-by-example-smart-pointer/index.html
 // https://lokiastari.com/blog/2015/01/15/c-plus-plus-by-example-smart-pointer-part-ii/index.html
@@ -63,11 +66,13 @@ namespace Sass {
    public:
     SharedObj() : refcount(0), detached(false) {
       #ifdef DEBUG_SHARED_PTR
+      std::lock_guard<std::mutex> lock(allMutex);
       if (taint) all.push_back(this);
       #endif
     }
     virtual ~SharedObj() {
       #ifdef DEBUG_SHARED_PTR
+      std::lock_guard<std::mutex> lock(allMutex);
       for (size_t i = 0; i < all.size(); i++) {
         if (all[i] == this) {
           all.erase(all.begin() + i);
@@ -105,13 +110,21 @@ namespace Sass {
    protected:
     friend class SharedPtr;
     friend class Memory_Manager;
+    // Reference counting is not atomic. Objects must not be used by
+    // two threads at once. Each compilation runs on a single thread,
+    // and trees from the stylesheet cache are leased to one compiler
+    // at a time, which may run on another thread than the previous
+    // one. A lease only ends with `sass_delete_compiler`, so the cache
+    // must never hand the same tree to two compilations at once.
     size_t refcount;
     bool detached;
-    static bool taint;
+    static thread_local bool taint;
     #ifdef DEBUG_SHARED_PTR
     sass::string file;
     size_t line;
     bool dbg = false;
+    // shared by all threads
+    static std::mutex allMutex;
     static sass::vector<SharedObj*> all;
     #endif
   };
@@ -170,6 +183,10 @@ namespace Sass {
       if (node->dbg) std::cerr << "- " << node << " X " << node->refcount << " (" << this << ") " << "\n";
       #endif
       if (node->refcount == 0 && !node->detached) {
+        #ifdef SASS_CUSTOM_ALLOCATOR
+        // freed with its pool at once
+        if (isReleased(dynamic_cast<void*>(node))) return;
+        #endif
         #ifdef DEBUG_SHARED_PTR
         if (node->dbg) std::cerr << "DELETE NODE " << node << "\n";
         #endif
@@ -11,7 +11,9 @@ namespace Sass {
   Output::Output(Sass_Output_Options& opt)
   : Inspect(Emitter(opt)),
     charset(""),
-    top_nodes(0)
+    top_nodes(0),
+    ascii_only(false),
+    late_imports(false)
   {}
 
   Output::~Output() { }
@@ -29,10 +31,8 @@ namespace Sass {
       // should be handle in check_expression
       throw Exception::InvalidValue({}, *n);
     }
-    // use values to_string facility
-    sass::string res = n->to_string(opt);
     // output the final token
-    append_token(res, n);
+    Inspect::operator()(n);
   }
 
   void Output::operator()(Import* imp)
@@ -46,7 +46,45 @@ namespace Sass {
     throw Exception::InvalidValue({}, *m);
   }
 
-  OutputBuffer Output::get_buffer(void)
+  // whether an import in [block] is not one of the leading
+  // statements of the root, which are hoisted before any output
+  static bool has_late_import(Block* block, bool leading)
+  {
+    for (size_t i = 0, L = block->length(); i < L; ++i) {
+      Statement* stm = block->get(i);
+      if (Cast<Import>(stm)) {
+        if (leading) continue;
+        return true;
+      }
+      if (!Cast<Comment>(stm)) leading = false;
+      if (ParentStatement* parent = Cast<ParentStatement>(stm)) {
+        if (parent->block() && has_late_import(parent->block(), false)) return true;
+      }
+    }
+    return false;
+  }
+
+  void Output::stream(Block* root, Sass_Output_Sink sink, void* cookie, bool mappings, bool ascii)
+  {
+    ascii_only = ascii;
+    late_imports = has_late_import(root, true);
+    // held back until the header is known
+    set_sink(sink, cookie, mappings, true);
+    root->perform(this);
+  }
+
+  bool Output::prepare_header(void)
+  {
+    // they would have to go in front of handed off output
+    if (late_imports) return false;
+    // the charset is known once a char above 127 is appended
+    if (!ascii_only && !wbuf.non_ascii) return false;
+    // nodes are only hoisted before the first output
+    render_header(false, wbuf.non_ascii);
+    return true;
+  }
+
+  void Output::render_header(bool empty, bool non_ascii)
   {
 
     Emitter emitter(opt);
@@ -60,31 +98,44 @@ namespace Sass {
 
     // flush scheduled outputs
     // maybe omit semicolon if possible
-    inspect.finalize(wbuf.buffer.size() == 0);
-    // prepend buffer on top
-    prepend_output(inspect.output());
-    // make sure we end with a linefeed
-    if (!ends_with(wbuf.buffer, opt.linefeed)) {
-      // if the output is not completely empty
-      if (!wbuf.buffer.empty()) append_string(opt.linefeed);
-    }
+    inspect.finalize(empty);
+    // goes on top of the buffer
+    const OutputBuffer& top = inspect.output();
 
-    // search for unicode char
-    for(const char& chr : wbuf.buffer) {
-      // skip all ascii chars
-      // static cast to unsigned to handle `char` being signed / unsigned
-      if (static_cast<unsigned>(chr) < 128) continue;
+    // tracked while appending
+    if (non_ascii || top.non_ascii) {
       // declare the charset
       if (output_style() != COMPRESSED)
         charset = "@charset \"UTF-8\";"
                 + sass::string(opt.linefeed);
       else charset = "\xEF\xBB\xBF";
-      // abort search
-      break;
     }
 
     // add charset as first line, before comments and imports
-    if (!charset.empty()) prepend_string(charset);
+    // the buffer is only joined with them when it is handed off
+    wbuf.header.reserve(charset.size() + top.buffer.size());
+    wbuf.header = charset;
+    wbuf.header += top.buffer;
+    wbuf.smap.set_header(top.smap, charset.size());
+
+  }
+
+  const OutputBuffer& Output::get_buffer(void)
+  {
+
+    // unless already handed to the sink
+    if (sink == 0 || sink_held) render_header(wbuf.buffer.size() == 0, wbuf.non_ascii);
+
+    // make sure we end with a linefeed
+    const sass::string linefeed(opt.linefeed);
+    if (wbuf.buffer.size() >= linefeed.size()) {
+      if (!ends_with(wbuf.buffer, linefeed)) append_string(linefeed);
+    }
+    // if the output is not completely empty
+    else if (!wbuf.buffer.empty() || !wbuf.header.empty()) {
+      // only join them if the buffer is too short
+      if (!ends_with(wbuf.header + wbuf.buffer, linefeed)) append_string(linefeed);
+    }
 
     return wbuf;
 
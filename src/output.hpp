@@ -22,9 +22,21 @@ namespace Sass {
   protected:
     sass::string charset;
     sass::vector<AST_Node*> top_nodes;
+    // renders the charset and the hoisted nodes
+    void render_header(bool empty, bool non_ascii);
+    // whether the output is known to be ascii only
+    bool ascii_only;
+    // whether imports are hoisted after the first output
+    bool late_imports;
+    // renders the header while streaming if it is known
+    virtual bool prepare_header(void);
 
   public:
-    OutputBuffer get_buffer(void);
+    const OutputBuffer& get_buffer(void);
+    // renders [root] and hands it to [sink] in chunks once
+    // the header is known, [ascii] tells if no char above
+    // 127 can be output, otherwise it is known at the first
+    void stream(Block* root, Sass_Output_Sink sink, void* cookie, bool mappings, bool ascii);
 
     virtual void operator()(Map*);
     virtual void operator()(StyleRule*);
@@ -31,13 +31,12 @@ namespace Sass {
     begin(source->begin()),
     position(source->begin()),
     end(source->end()),
-    before_token(0, 0),
-    after_token(0, 0),
     pstate(source->getSourceSpan()),
     traces(traces),
     indentation(0),
     nestings(0),
-    allow_parent(allow_parent)
+    allow_parent(allow_parent),
+    deferred(nullptr)
   {
     Block_Obj root = SASS_MEMORY_NEW(Block, pstate);
     stack.push_back(Scope::Root);
@@ -48,9 +47,8 @@ namespace Sass {
   void Parser::advanceToNextToken() {
       lex < css_comments >(false);
       // advance to position
-      pstate.position += pstate.offset;
-      pstate.offset.column = 0;
-      pstate.offset.line = 0;
+      pstate.position += pstate.length;
+      pstate.length = 0;
     }
 
   SelectorListObj Parser::parse_selector(SourceData* source, Context& ctx, Backtraces traces, bool allow_parent)
@@ -70,15 +68,20 @@ namespace Sass {
   Block_Obj Parser::parse()
   {
 
+    // source spans use 32-bit offsets
+    if (source->size() > UINT32_MAX) {
+      error("Input is too large (4GB at most)");
+    }
+
     // consume unicode BOM
     read_bom();
 
     // scan the input to find invalid utf8 sequences
-    const char* it = utf8::find_invalid(position, end);
+    const char* it = Util::find_invalid_utf8(position, end);
 
     // report invalid utf8
     if (it != end) {
-      pstate.position += Offset::init(position, it);
+      pstate.position = uint32_t(it - begin);
       traces.push_back(Backtrace(pstate));
       throw Exception::InvalidSass(pstate, traces, "Invalid UTF-8 sequence");
     }
@@ -87,7 +90,7 @@ namespace Sass {
     Block_Obj root = SASS_MEMORY_NEW(Block, pstate, 0, true);
 
     // check seems a bit esoteric but works
-    if (ctx.resources.size() == 1) {
+    if (!deferred && ctx.resources.size() == 1) {
       // apply headers only on very first include
       ctx.apply_custom_headers(root, getPath(), pstate);
     }
@@ -349,17 +352,15 @@ namespace Sass {
       imp->import_queries(import_queries);
     }
 
-    for(auto location : to_import) {
-      if (location.second) {
-        imp->urls().push_back(location.second);
-      }
-      // check if custom importers want to take over the handling
-      else if (!ctx.call_importers(unquote(location.first), getPath(), pstate, imp)) {
-        // nobody wants it, so we do our import
-        ctx.import_url(imp, location.first, getPath());
-      }
+    // resolved once the whole file is parsed
+    if (deferred) {
+      Block_Obj block = block_stack.back();
+      deferred->push_back({ imp, pstate, block, block->length(), to_import, 0 });
+      return imp;
     }
 
+    ctx.resolve_import(imp, to_import, getPath(), pstate);
+
     return imp;
   }
 
@@ -553,7 +554,7 @@ namespace Sass {
         if (i < p) {
           sass::string parsed(i, p);
           String_Constant_Obj str = SASS_MEMORY_NEW(String_Constant, pstate, parsed);
-          pstate.position += Offset(parsed);
+          pstate.position += uint32_t(parsed.size());
           str->update_pstate(pstate);
           schema->append(str);
         }
@@ -575,7 +576,7 @@ namespace Sass {
         // add to the string schema
         schema->append(interpolant);
         // advance parser state
-        pstate.position.add(p+2, j);
+        pstate.position += uint32_t(j - p - 2);
         // advance position
         i = j;
       }
@@ -586,7 +587,7 @@ namespace Sass {
         if (i < end_of_selector) {
           sass::string parsed(i, end_of_selector);
           String_Constant_Obj str = SASS_MEMORY_NEW(String_Constant, pstate, parsed);
-          pstate.position += Offset(parsed);
+          pstate.position += uint32_t(parsed.size());
           str->update_pstate(pstate);
           i = end_of_selector;
           schema->append(str);
@@ -603,8 +604,6 @@ namespace Sass {
     selector_schema->update_pstate(pstate);
     schema->update_pstate(pstate);
 
-    after_token = before_token = pstate.position;
-
     // return parsed result
     return selector_schema.detach();
   }
@@ -949,7 +948,7 @@ namespace Sass {
     }
 
     SourceSpan ps = map->pstate();
-    ps.offset = pstate.position - ps.position + pstate.offset;
+    ps.length = pstate.position + pstate.length - ps.position;
     map->pstate(ps);
 
     return map;
@@ -1089,7 +1088,7 @@ namespace Sass {
     if (operands.size() == 0) return conj;
     // fold all operands into one binary expression
     ExpressionObj ex = fold_operands(conj, operands, { Sass_OP::OR });
-    state.offset = pstate.position - state.position + pstate.offset;
+    state.length = pstate.position + pstate.length - state.position;
     ex->pstate(state);
     return ex;
   }
@@ -1112,7 +1111,7 @@ namespace Sass {
     if (operands.size() == 0) return rel;
     // fold all operands into one binary expression
     ExpressionObj ex = fold_operands(rel, operands, { Sass_OP::AND });
-    state.offset = pstate.position - state.position + pstate.offset;
+    state.length = pstate.position + pstate.length - state.position;
     ex->pstate(state);
     return ex;
   }
@@ -1161,7 +1160,7 @@ namespace Sass {
     // single nested items. So we cannot set delay on the
     // returned result here, as we have lost nestings ...
     ExpressionObj ex = fold_operands(lhs, operands, operators);
-    state.offset = pstate.position - state.position + pstate.offset;
+    state.length = pstate.position + pstate.length - state.position;
     ex->pstate(state);
     return ex;
   }
@@ -1210,7 +1209,7 @@ namespace Sass {
 
     if (operands.size() == 0) return lhs;
     ExpressionObj ex = fold_operands(lhs, operands, operators);
-    state.offset = pstate.position - state.position + pstate.offset;
+    state.length = pstate.position + pstate.length - state.position;
     ex->pstate(state);
     return ex;
   }
@@ -1240,7 +1239,7 @@ namespace Sass {
     }
     // operands and operators to binary expression
     ExpressionObj ex = fold_operands(factor, operands, operators);
-    state.offset = pstate.position - state.position + pstate.offset;
+    state.length = pstate.position + pstate.length - state.position;
     ex->pstate(state);
     return ex;
   }
@@ -1445,10 +1444,11 @@ namespace Sass {
   Value* Parser::color_or_string(const sass::string& lexed) const
   {
     if (auto color = name_to_color(lexed)) {
-      auto c = SASS_MEMORY_NEW(Color_RGBA, color);
+      // don't copy the static color table entry, since that would
+      // touch the reference counter of its shared source span
+      auto c = SASS_MEMORY_NEW(Color_RGBA, pstate,
+        color->r(), color->g(), color->b(), color->a(), lexed);
       c->is_delayed(true);
-      c->pstate(pstate);
-      c->disp(lexed);
       return c;
     } else {
       return SASS_MEMORY_NEW(String_Constant, pstate, lexed);
@@ -1654,8 +1654,7 @@ namespace Sass {
     Token str(lexed);
     // static values always have trailing white-
     // space and end delimiter (\s*[;]$) included
-    --pstate.offset.column;
-    --after_token.column;
+    --pstate.length;
     --str.end;
     --position;
 
@@ -35,6 +35,20 @@ struct Lookahead {
 
 namespace Sass {
 
+  // An @import whose locations are only resolved once the whole file is
+  // parsed. Used when files are parsed on another thread, which must not
+  // touch the context (see `ImportPrefetch`). The resulting nodes go to
+  // [block] at [index], where they would have been appended right away.
+  struct DeferredImport {
+    Import_Obj imp;
+    SourceSpan pstate;
+    Block_Obj block;
+    size_t index;
+    sass::vector<std::pair<sass::string, Function_Call_Obj>> locations;
+    // nodes inserted at [index] once resolved
+    size_t inserted;
+  };
+
   class Parser : public SourceSpan {
   public:
 
@@ -47,14 +61,14 @@ namespace Sass {
     const char* begin;
     const char* position;
     const char* end;
-    Offset before_token;
-    Offset after_token;
     SourceSpan pstate;
     Backtraces traces;
     size_t indentation;
     size_t nestings;
     bool allow_parent;
     Token lexed;
+    // defer resolving of imports if set
+    sass::vector<DeferredImport>* deferred;
 
     Parser(SourceData* source, Context& ctx, Backtraces, bool allow_parent = true);
 
@@ -173,14 +187,11 @@ namespace Sass {
       // create new lexed token object (holds the parse results)
       lexed = Token(position, it_before_token, it_after_token);
 
-      // advance position (add whitespace before current token)
-      before_token = after_token.add(position, it_before_token);
-
-      // update after_token position for current token
-      after_token.add(it_before_token, it_after_token);
-
-      // ToDo: could probably do this incremental on original object (API wants offset?)
-      pstate = SourceSpan(source, before_token, after_token - before_token);
+      // update parser state for the current token
+      // the initial state may be from an outer source
+      if (pstate.source != source) pstate.source = source;
+      pstate.position = uint32_t(it_before_token - begin);
+      pstate.length = uint32_t(it_after_token - it_before_token);
 
       // advance internal char iterator
       return position = it_after_token;
@@ -197,8 +208,6 @@ namespace Sass {
       Token prev = lexed;
       // store previous pointer
       const char* oldpos = position;
-      Offset bt = before_token;
-      Offset at = after_token;
       SourceSpan op = pstate;
       // throw away comments
       // update srcmap position
@@ -210,8 +219,6 @@ namespace Sass {
         pstate = op;
         lexed = prev;
         position = oldpos;
-        after_token = at;
-        before_token = bt;
       }
       // return match
       return pos;
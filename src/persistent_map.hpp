@@ -0,0 +1,222 @@
+#ifndef SASS_PERSISTENT_MAP_H
+#define SASS_PERSISTENT_MAP_H
+
+#include <algorithm>
+#include "memory.hpp"
+
+namespace Sass {
+
+  // ##########################################################################
+  // Persistent (immutable) insertion ordered hash map. Copies share all
+  // nodes with the original, updates only copy the nodes on the path to
+  // the changed entry. Insert, lookup and erase are therefore O(log n).
+  // Implemented as two balanced (AVL) trees: an index from key hashes to
+  // insertion sequence numbers and the entries ordered by that sequence.
+  // ##########################################################################
+  template<
+    class Key,
+    class T,
+    class Hash = std::hash<Key>,
+    class KeyEqual = std::equal_to<Key>
+  >
+  class persistent_map {
+
+  private:
+
+    // Immutable tree node, ordered by `id`
+    template <class V>
+    class Node : public SharedObj {
+    public:
+      const size_t id;
+      const V val;
+      const SharedImpl<Node> left;
+      const SharedImpl<Node> right;
+      const size_t height;
+      Node(size_t id, const V& val, const SharedImpl<Node>& left, const SharedImpl<Node>& right)
+      : id(id), val(val), left(left), right(right),
+        height(std::max(depth(left), depth(right)) + 1)
+      { }
+      sass::string to_string() const override { return "persistent_map::node"; }
+    };
+
+    template <class V>
+    using NodeObj = SharedImpl<Node<V>>;
+
+    template <class V>
+    static size_t depth(const NodeObj<V>& node) {
+      return node ? node->height : 0;
+    }
+
+    // Creates a new node with the given children
+    // and rotates it if the heights got off balance
+    template <class V>
+    static NodeObj<V> balance(size_t id, const V& val, const NodeObj<V>& l, const NodeObj<V>& r) {
+      if (depth(l) > depth(r) + 1) {
+        if (depth(l->left) >= depth(l->right)) {
+          return SASS_MEMORY_NEW(Node<V>, l->id, l->val, l->left,
+            SASS_MEMORY_NEW(Node<V>, id, val, l->right, r));
+        }
+        const NodeObj<V>& lr = l->right;
+        return SASS_MEMORY_NEW(Node<V>, lr->id, lr->val,
+          SASS_MEMORY_NEW(Node<V>, l->id, l->val, l->left, lr->left),
+          SASS_MEMORY_NEW(Node<V>, id, val, lr->right, r));
+      }
+      if (depth(r) > depth(l) + 1) {
+        if (depth(r->right) >= depth(r->left)) {
+          return SASS_MEMORY_NEW(Node<V>, r->id, r->val,
+            SASS_MEMORY_NEW(Node<V>, id, val, l, r->left), r->right);
+        }
+        const NodeObj<V>& rl = r->left;
+        return SASS_MEMORY_NEW(Node<V>, rl->id, rl->val,
+          SASS_MEMORY_NEW(Node<V>, id, val, l, rl->left),
+          SASS_MEMORY_NEW(Node<V>, r->id, r->val, rl->right, r->right));
+      }
+      return SASS_MEMORY_NEW(Node<V>, id, val, l, r);
+    }
+
+    template <class V>
+    static const Node<V>* lookup(const NodeObj<V>& root, size_t id) {
+      const Node<V>* node = root.ptr();
+      while (node && node->id != id) {
+        node = id < node->id ? node->left.ptr() : node->right.ptr();
+      }
+      return node;
+    }
+
+    // Returns a new tree with `val` stored under `id`
+    template <class V>
+    static NodeObj<V> insert(const NodeObj<V>& node, size_t id, const V& val) {
+      if (!node) return SASS_MEMORY_NEW(Node<V>, id, val, {}, {});
+      if (id < node->id) return balance(node->id, node->val, insert(node->left, id, val), node->right);
+      if (id > node->id) return balance(node->id, node->val, node->left, insert(node->right, id, val));
+      return SASS_MEMORY_NEW(Node<V>, id, val, node->left, node->right);
+    }
+
+    // Returns a new tree without the leftmost node
+    template <class V>
+    static NodeObj<V> erase_first(const NodeObj<V>& node) {
+      if (!node->left) return node->right;
+      return balance(node->id, node->val, erase_first(node->left), node->right);
+    }
+
+    // Returns a new tree without `id` (must exist)
+    template <class V>
+    static NodeObj<V> erase(const NodeObj<V>& node, size_t id) {
+      if (id < node->id) return balance(node->id, node->val, erase(node->left, id), node->right);
+      if (id > node->id) return balance(node->id, node->val, node->left, erase(node->right, id));
+      if (!node->left) return node->right;
+      if (!node->right) return node->left;
+      const Node<V>* first = node->right.ptr();
+      while (first->left) first = first->left.ptr();
+      return balance(first->id, first->val, node->left, erase_first(node->right));
+    }
+
+    template <class V, class Fn>
+    static void each(const NodeObj<V>& node, Fn& fn) {
+      if (!node) return;
+      each(node->left, fn);
+      fn(node->val);
+      each(node->right, fn);
+    }
+
+    // Entries sharing the same key hash
+    using Bucket = sass::vector<std::pair<Key, size_t>>;
+    using Entry = std::pair<Key, T>;
+
+    // Key hash to insertion sequence number(s)
+    NodeObj<Bucket> _index;
+    // Insertion sequence number to key and value
+    NodeObj<Entry> _entries;
+
+    size_t _size;
+    size_t _next;
+
+    // Returns the sequence number of `key` via `seq`
+    bool find(const Key& key, size_t hash, size_t& seq) const {
+      if (const Node<Bucket>* node = lookup(_index, hash)) {
+        for (const auto& item : node->val) {
+          if (KeyEqual()(item.first, key)) {
+            seq = item.second;
+            return true;
+          }
+        }
+      }
+      return false;
+    }
+
+  public:
+
+    persistent_map() :
+      _size(0), _next(0)
+    {
+    }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    bool hasKey(const Key& key) const {
+      size_t seq;
+      return find(key, Hash()(key), seq);
+    }
+
+    // Returns nullptr if `key` does not exist
+    const T* get(const Key& key) const {
+      size_t seq;
+      if (!find(key, Hash()(key), seq)) return nullptr;
+      return &lookup(_entries, seq)->val.second;
+    }
+
+    // Existing keys keep their position and their original key
+    // object (e.g. `a` stays unquoted when merged with `"a"`),
+    // but get the new value.
+    // Returns false if the key already existed in the map.
+    bool insert(const Key& key, const T& val) {
+      size_t seq, hash = Hash()(key);
+      if (find(key, hash, seq)) {
+        const Key& orig = lookup(_entries, seq)->val.first;
+        _entries = insert(_entries, seq, Entry(orig, val));
+        return false;
+      }
+      seq = _next++;
+      Bucket bucket;
+      if (const Node<Bucket>* node = lookup(_index, hash)) {
+        bucket = node->val;
+      }
+      bucket.push_back(std::make_pair(key, seq));
+      _index = insert(_index, hash, bucket);
+      _entries = insert(_entries, seq, Entry(key, val));
+      _size += 1;
+      return true;
+    }
+
+    bool erase(const Key& key) {
+      size_t seq, hash = Hash()(key);
+      if (!find(key, hash, seq)) return false;
+      Bucket bucket(lookup(_index, hash)->val);
+      for (size_t i = 0; i < bucket.size(); i += 1) {
+        if (bucket[i].second == seq) {
+          bucket.erase(bucket.begin() + i);
+          break;
+        }
+      }
+      if (bucket.empty()) _index = erase(_index, hash);
+      else _index = insert(_index, hash, bucket);
+      _entries = erase(_entries, seq);
+      _size -= 1;
+      return true;
+    }
+
+    // Calls `fn(key, value)` in insertion order
+    template <class Fn>
+    void each(Fn fn) const {
+      auto visit = [&fn](const Entry& entry) {
+        fn(entry.first, entry.second);
+      };
+      each(_entries, visit);
+    }
+
+  };
+
+}
+
+#endif
@@ -117,10 +117,22 @@ namespace Sass {
 
 
   SourceSpan::SourceSpan(const char* path)
-  : source(SASS_MEMORY_NEW(SynthFile, path)), position(0, 0), offset(0, 0) { }
+  : source(SASS_MEMORY_NEW(SynthFile, path)), position(0), length(0) { }
 
-  SourceSpan::SourceSpan(SourceDataObj source, const Offset& position, const Offset& offset)
-    : source(source), position(position), offset(offset) { }
+  SourceSpan::SourceSpan(SourceDataObj source, uint32_t position, uint32_t length)
+    : source(source), position(position), length(length) { }
+
+  Offset SourceSpan::getPosition() const
+  {
+    if (source == nullptr) return Offset(0, 0);
+    return source->getLineColumn(position);
+  }
+
+  Offset SourceSpan::getEndPosition() const
+  {
+    if (source == nullptr) return Offset(0, 0);
+    return source->getLineColumn(size_t(position) + length);
+  }
 
   Position Position::add(const char* begin, const char* end)
   {
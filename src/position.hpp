@@ -100,6 +100,9 @@ namespace Sass {
     bool operator==(Token t)  { return to_string() == t.to_string(); }
   };
 
+  // A range of a source. It only stores byte offsets into the
+  // data of the source, since most spans are never reported.
+  // Line and column are resolved via the source on demand.
   class SourceSpan {
 
     public:
@@ -107,8 +110,8 @@ namespace Sass {
       SourceSpan(const char* path);
 
       SourceSpan(SourceDataObj source,
-        const Offset& position = Offset(0, 0),
-        const Offset& offset = Offset(0, 0));
+        uint32_t position = 0,
+        uint32_t length = 0);
 
       const char* getPath() const {
         return source->getPath();
@@ -118,16 +121,16 @@ namespace Sass {
         return source->getRawData();
       }
 
-      Offset getPosition() const {
-        return position;
-      }
+      Offset getPosition() const;
+
+      Offset getEndPosition() const;
 
       size_t getLine() const {
-        return position.line + 1;
+        return getPosition().line + 1;
       }
 
       size_t getColumn() const {
-        return position.column + 1;
+        return getPosition().column + 1;
       }
 
       size_t getSrcId() const {
@@ -137,8 +140,10 @@ namespace Sass {
       }
 
       SourceDataObj source;
-      Offset position;
-      Offset offset;
+      // byte offset of the first char
+      uint32_t position;
+      // number of bytes spanned
+      uint32_t length;
 
   };
 
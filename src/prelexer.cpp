@@ -72,7 +72,6 @@ namespace Sass {
       false => string_re('"', '"'),
       true => string_re('', '"')
     */
-    extern const char string_double_negates[] = "\"\\#";
     const char* re_string_double_close(const char* src)
     {
       return sequence <
@@ -92,8 +91,8 @@ namespace Sass {
               >
             >,
             // other valid chars
-            neg_class_char <
-              string_double_negates
+            any_chars_but <
+              '"', '\\', '#'
             >
           >
         >,
@@ -127,8 +126,8 @@ namespace Sass {
               >
             >,
             // other valid chars
-            neg_class_char <
-              string_double_negates
+            any_chars_but <
+              '"', '\\', '#'
             >
           >
         >,
@@ -141,7 +140,6 @@ namespace Sass {
       >(src);
     }
 
-    extern const char string_single_negates[] = "'\\#";
     const char* re_string_single_close(const char* src)
     {
       return sequence <
@@ -161,8 +159,8 @@ namespace Sass {
               >
             >,
             // other valid chars
-            neg_class_char <
-              string_single_negates
+            any_chars_but <
+              '\'', '\\', '#'
             >
           >
         >,
@@ -196,8 +194,8 @@ namespace Sass {
               >
             >,
             // other valid chars
-            neg_class_char <
-              string_single_negates
+            any_chars_but <
+              '\'', '\\', '#'
             >
           >
         >,
@@ -221,6 +219,8 @@ namespace Sass {
       return sequence <
         non_greedy<
           alternatives<
+            // skip runs of uri chars
+            char_ranges< '*', '~' >,
             class_char< real_uri_chars >,
             uri_character,
             NONASCII,
@@ -249,6 +249,8 @@ namespace Sass {
           quoted_string,
           non_greedy<
             alternatives<
+              // skip runs of uri chars
+              char_ranges< '*', '~' >,
               class_char< real_uri_chars >,
               uri_character,
               NONASCII,
@@ -270,9 +272,11 @@ namespace Sass {
                exactly <
                  slash_slash
                >,
-               non_greedy<
-                 any_char,
-                 end_of_line
+               // up to end_of_line
+               optional <
+                 any_chars_but <
+                   '\n', '\r', '\f'
+                 >
                >
              >(src);
     }
@@ -280,13 +284,15 @@ namespace Sass {
     // Match a block comment.
     const char* block_comment(const char* src)
     {
-      return sequence<
-               delimited_by<
-                 slash_star,
-                 star_slash,
-                 false
-               >
-             >(src);
+      src = exactly<slash_star>(src);
+      if (!src) return 0;
+      // jump from star to star
+      while (true) {
+        src = optional< any_chars_but<'*'> >(src);
+        if (*src == 0) return 0;
+        if (*(src + 1) == '/') return src + 2;
+        ++ src;
+      }
     }
     /* not use anymore - remove?
     const char* block_comment_prefix(const char* src) {
@@ -526,6 +532,8 @@ namespace Sass {
             unicode_seq,
             // skip interpolants
             interpolant,
+            // skip runs of non delimiters
+            any_chars_but < '\'', '\\', '#' >,
             // skip non delimiters
             any_char_but < '\'' >
           >
@@ -550,6 +558,8 @@ namespace Sass {
             unicode_seq,
             // skip interpolants
             interpolant,
+            // skip runs of non delimiters
+            any_chars_but < '"', '\\', '#' >,
             // skip non delimiters
             any_char_but < '"' >
           >
@@ -1486,6 +1496,8 @@ namespace Sass {
       sequence<
         non_greedy<
           alternatives<
+            // skip runs of uri chars
+            char_ranges< '*', '~' >,
             class_char< real_uri_chars >,
             uri_character,
             NONASCII,
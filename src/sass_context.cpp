@@ -5,6 +5,7 @@
 
 #include "sass_functions.hpp"
 #include "json.hpp"
+#include "stylesheet_cache.hpp"
 
 #define LFEED "\n"
 
@@ -31,6 +32,9 @@ namespace Sass {
     c_ctx->error_message = sass_copy_string(msg_stream.str());
     c_ctx->error_text = sass_copy_c_string(msg.c_str());
     c_ctx->error_status = severety;
+    // the output may be rendered before the source map fails
+    free(c_ctx->output_string);
+    free(c_ctx->source_map_string);
     c_ctx->output_string = 0;
     c_ctx->source_map_string = 0;
     json_delete(json_err);
@@ -75,10 +79,10 @@ namespace Sass {
       }
 
       // now create the code trace (ToDo: maybe have util functions?)
-      if (e.pstate.position.line != sass::string::npos &&
-          e.pstate.position.column != sass::string::npos &&
+      Offset offset(e.pstate.getPosition());
+      if (offset.line != sass::string::npos &&
+          offset.column != sass::string::npos &&
           e.pstate.source != nullptr) {
-        Offset offset(e.pstate.position);
         size_t lines = offset.line;
         // scan through src until target line
         // move line_beg pointer to line start
@@ -124,6 +128,8 @@ namespace Sass {
       c_ctx->error_line = e.pstate.getLine();
       c_ctx->error_column = e.pstate.getColumn();
       c_ctx->error_src = sass_copy_c_string(e.pstate.getRawData());
+      free(c_ctx->output_string);
+      free(c_ctx->source_map_string);
       c_ctx->output_string = 0;
       c_ctx->source_map_string = 0;
       json_delete(json_err);
@@ -155,6 +161,25 @@ namespace Sass {
     catch (...) { return handle_error(c_ctx); }
   }
 
+  // every compiler gets its own arenas with the custom allocator,
+  // otherwise everything comes from the system and there is no pool
+  static MemoryPool* make_pool()
+  {
+    #ifdef SASS_CUSTOM_ALLOCATOR
+      return new MemoryPool();
+    #else
+      return nullptr;
+    #endif
+  }
+
+  // create the cpp context with its memory coming from `pool`
+  template <class T, class C>
+  static Context* make_context(C* c_ctx, MemoryPool* pool)
+  {
+    MemoryPoolScope scope(pool);
+    return new T(*c_ctx);
+  }
+
   static Block_Obj sass_parse_block(Sass_Compiler* compiler) throw()
   {
 
@@ -242,8 +267,9 @@ extern "C" {
 
 
   // generic compilation function (not exported, use file/data compile instead)
-  static Sass_Compiler* sass_prepare_context (Sass_Context* c_ctx, Context* cpp_ctx) throw()
+  static Sass_Compiler* sass_prepare_context (Sass_Context* c_ctx, Context* cpp_ctx, MemoryPool* pool) throw()
   {
+    MemoryPoolScope scope(pool);
     try {
       // register our custom functions
       if (c_ctx->c_functions) {
@@ -292,6 +318,7 @@ extern "C" {
       // store in sass compiler
       compiler->c_ctx = c_ctx;
       compiler->cpp_ctx = cpp_ctx;
+      compiler->pool = pool;
       cpp_ctx->c_compiler = compiler;
 
       // use to parse block
@@ -307,11 +334,11 @@ extern "C" {
   }
 
   // generic compilation function (not exported, use file/data compile instead)
-  static int sass_compile_context (Sass_Context* c_ctx, Context* cpp_ctx)
+  static int sass_compile_context (Sass_Context* c_ctx, Context* cpp_ctx, MemoryPool* pool)
   {
 
     // prepare sass compiler with context and options
-    Sass_Compiler* compiler = sass_prepare_context(c_ctx, cpp_ctx);
+    Sass_Compiler* compiler = sass_prepare_context(c_ctx, cpp_ctx, pool);
 
     try {
       // call each compiler step
@@ -382,15 +409,17 @@ extern "C" {
   struct Sass_Compiler* ADDCALL sass_make_data_compiler (struct Sass_Data_Context* data_ctx)
   {
     if (data_ctx == 0) return 0;
-    Context* cpp_ctx = new Data_Context(*data_ctx);
-    return sass_prepare_context(data_ctx, cpp_ctx);
+    MemoryPool* pool = make_pool();
+    Context* cpp_ctx = make_context<Data_Context>(data_ctx, pool);
+    return sass_prepare_context(data_ctx, cpp_ctx, pool);
   }
 
   struct Sass_Compiler* ADDCALL sass_make_file_compiler (struct Sass_File_Context* file_ctx)
   {
     if (file_ctx == 0) return 0;
-    Context* cpp_ctx = new File_Context(*file_ctx);
-    return sass_prepare_context(file_ctx, cpp_ctx);
+    MemoryPool* pool = make_pool();
+    Context* cpp_ctx = make_context<File_Context>(file_ctx, pool);
+    return sass_prepare_context(file_ctx, cpp_ctx, pool);
   }
 
   int ADDCALL sass_compile_data_context(Sass_Data_Context* data_ctx)
@@ -404,8 +433,9 @@ extern "C" {
       // if (*data_ctx->source_string == 0) { throw(std::runtime_error("Data context has empty source string")); }
     }
     catch (...) { return handle_errors(data_ctx) | 1; }
-    Context* cpp_ctx = new Data_Context(*data_ctx);
-    return sass_compile_context(data_ctx, cpp_ctx);
+    MemoryPool* pool = make_pool();
+    Context* cpp_ctx = make_context<Data_Context>(data_ctx, pool);
+    return sass_compile_context(data_ctx, cpp_ctx, pool);
   }
 
   int ADDCALL sass_compile_file_context(Sass_File_Context* file_ctx)
@@ -418,8 +448,9 @@ extern "C" {
       if (*file_ctx->input_path == 0) { throw(std::runtime_error("File context has empty input path")); }
     }
     catch (...) { return handle_errors(file_ctx) | 1; }
-    Context* cpp_ctx = new File_Context(*file_ctx);
-    return sass_compile_context(file_ctx, cpp_ctx);
+    MemoryPool* pool = make_pool();
+    Context* cpp_ctx = make_context<File_Context>(file_ctx, pool);
+    return sass_compile_context(file_ctx, cpp_ctx, pool);
   }
 
   int ADDCALL sass_compiler_parse(struct Sass_Compiler* compiler)
@@ -431,6 +462,7 @@ extern "C" {
     if (compiler->cpp_ctx == NULL) return 1;
     if (compiler->c_ctx->error_status)
       return compiler->c_ctx->error_status;
+    MemoryPoolScope scope(compiler->pool);
     // parse the context we have set up (file or data)
     compiler->root = sass_parse_block(compiler);
     // success
@@ -448,6 +480,7 @@ extern "C" {
     if (compiler->c_ctx->error_status)
       return compiler->c_ctx->error_status;
     compiler->state = SASS_COMPILER_EXECUTED;
+    MemoryPoolScope scope(compiler->pool);
     Context* cpp_ctx = compiler->cpp_ctx;
     Block_Obj root = compiler->root;
     // compile the parsed root block
@@ -567,11 +600,24 @@ extern "C" {
     if (compiler == 0) {
       return;
     }
-    Context* cpp_ctx = compiler->cpp_ctx;
-    if (cpp_ctx) delete(cpp_ctx);
-    compiler->cpp_ctx = NULL;
-    compiler->c_ctx = NULL;
-    compiler->root = {};
+    MemoryPool* pool = compiler->pool;
+    // the nodes of the compilation are not destroyed one
+    // by one, they all go away with the arenas of the pool
+    if (pool) pool->release();
+    {
+      MemoryPoolScope scope(pool);
+      compiler->root = {};
+      Context* cpp_ctx = compiler->cpp_ctx;
+      StylesheetCache* cache = nullptr;
+      if (cpp_ctx) cache = cpp_ctx->stylesheet_cache;
+      if (cpp_ctx) delete(cpp_ctx);
+      compiler->cpp_ctx = NULL;
+      compiler->c_ctx = NULL;
+      // remove the nodes of our pool from the leased sheets
+      if (cache) cache->release(compiler);
+    }
+    // return all arenas at once
+    delete pool;
     free(compiler);
   }
 
@@ -609,6 +655,9 @@ extern "C" {
 
   // Getters for Sass_Compiler options (get connected sass context)
   enum Sass_Compiler_State ADDCALL sass_compiler_get_state(struct Sass_Compiler* compiler) { return compiler->state; }
+  size_t ADDCALL sass_compiler_get_alloc_bytes(struct Sass_Compiler* compiler) { return compiler->pool ? compiler->pool->getBytes() : 0; }
+  size_t ADDCALL sass_compiler_get_alloc_peak(struct Sass_Compiler* compiler) { return compiler->pool ? compiler->pool->getPeak() : 0; }
+  size_t ADDCALL sass_compiler_get_alloc_arenas(struct Sass_Compiler* compiler) { return compiler->pool ? compiler->pool->getArenas() : 0; }
   struct Sass_Context* ADDCALL sass_compiler_get_context(struct Sass_Compiler* compiler) { return compiler->c_ctx; }
   struct Sass_Options* ADDCALL sass_compiler_get_options(struct Sass_Compiler* compiler) { return compiler->c_ctx; }
   // Getters for Sass_Compiler options (query import stack)
@@ -633,6 +682,12 @@ extern "C" {
   IMPLEMENT_SASS_OPTION_ACCESSOR(bool, source_map_file_urls);
   IMPLEMENT_SASS_OPTION_ACCESSOR(bool, omit_source_map_url);
   IMPLEMENT_SASS_OPTION_ACCESSOR(bool, is_indented_syntax_src);
+  IMPLEMENT_SASS_OPTION_ACCESSOR(int, import_threads);
+  IMPLEMENT_SASS_OPTION_ACCESSOR(bool, map_source_files);
+  IMPLEMENT_SASS_OPTION_ACCESSOR(struct Sass_Stylesheet_Cache*, stylesheet_cache);
+  IMPLEMENT_SASS_OPTION_ACCESSOR(struct Sass_Directory_Cache*, directory_cache);
+  IMPLEMENT_SASS_OPTION_ACCESSOR(Sass_Output_Sink, output_sink);
+  IMPLEMENT_SASS_OPTION_ACCESSOR(void*, output_sink_cookie);
   IMPLEMENT_SASS_OPTION_ACCESSOR(Sass_Function_List, c_functions);
   IMPLEMENT_SASS_OPTION_ACCESSOR(Sass_Importer_List, c_importers);
   IMPLEMENT_SASS_OPTION_ACCESSOR(Sass_Importer_List, c_headers);
@@ -56,6 +56,25 @@ struct Sass_Options : Sass_Output_Options {
   // Directly inserted in source maps
   char* source_map_root;
 
+  // Number of threads that read and parse
+  // imported files ahead of time (0 = none)
+  int import_threads;
+
+  // Map large source files into memory instead
+  // of reading them (POSIX only, see the docs)
+  bool map_source_files;
+
+  // Parsed stylesheets shared between compilations
+  struct Sass_Stylesheet_Cache* stylesheet_cache;
+
+  // Directory listings shared between compilations
+  struct Sass_Directory_Cache* directory_cache;
+
+  // Receives the css output in chunks
+  // instead of the output string
+  Sass_Output_Sink output_sink;
+  void* output_sink_cookie;
+
   // Custom functions that can be called from sccs code
   Sass_Function_List c_functions;
 
@@ -124,6 +143,9 @@ struct Sass_Compiler {
   Sass::Context* cpp_ctx;
   // Sass::Block
   Sass::Block_Obj root;
+  // memory for everything the compiler allocates
+  // (null without SASS_CUSTOM_ALLOCATOR)
+  Sass::MemoryPool* pool;
 };
 
 #endif
@@ -163,8 +163,8 @@ extern "C" {
   // Getter for callee entry
   const char* ADDCALL sass_callee_get_name(Sass_Callee_Entry entry) { return entry->name; }
   const char* ADDCALL sass_callee_get_path(Sass_Callee_Entry entry) { return entry->path; }
-  size_t ADDCALL sass_callee_get_line(Sass_Callee_Entry entry) { return entry->line; }
-  size_t ADDCALL sass_callee_get_column(Sass_Callee_Entry entry) { return entry->column; }
+  size_t ADDCALL sass_callee_get_line(Sass_Callee_Entry entry) { return entry->pstate.getLine(); }
+  size_t ADDCALL sass_callee_get_column(Sass_Callee_Entry entry) { return entry->pstate.getColumn(); }
   enum Sass_Callee_Type ADDCALL sass_callee_get_type(Sass_Callee_Entry entry) { return entry->type; }
   Sass_Env_Frame ADDCALL sass_callee_get_env (Sass_Callee_Entry entry) { return &entry->env; }
 
@@ -34,8 +34,8 @@ struct Sass_Env {
 struct Sass_Callee {
   const char* name;
   const char* path;
-  size_t line;
-  size_t column;
+  // line and column are resolved on request
+  Sass::SourceSpan pstate;
   enum Sass_Callee_Type type;
   struct Sass_Env env;
 };
@@ -6,6 +6,8 @@
 // When enabled we use our custom memory pool allocator
 // With intense workloads this can double the performance
 // Max memory usage mostly only grows by a slight amount
+// Enable it via `make SASS_CUSTOM_ALLOCATOR=1` or via
+// `./configure --enable-custom-allocator`
 // #define SASS_CUSTOM_ALLOCATOR
 
 // How many buckets should we have for the free-list
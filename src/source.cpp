@@ -1,8 +1,10 @@
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include "source.hpp"
 #include "utf8/checked.h"
 #include "position.hpp"
+#include "util_string.hpp"
 
 namespace Sass {
 
@@ -11,22 +13,90 @@ namespace Sass {
   {
   }
 
+  void SourceData::indexLines() const
+  {
+    MemoryPoolScope scope(ownerOf(dynamic_cast<const void*>(this)));
+    const char* data = begin();
+    const char* last = end();
+    const char* start = data;
+    lines.push_back(0);
+    // memchr and the word-wise ascii test beat a byte loop
+    while (const char* nl = (const char*) memchr(start, '\n', last - start)) {
+      ascii.push_back(Util::ascii_only(start, nl));
+      start = nl + 1;
+      lines.push_back(uint32_t(start - data));
+    }
+    ascii.push_back(Util::ascii_only(start, last));
+  }
+
+  Offset SourceData::getLineColumn(size_t position) const
+  {
+    std::call_once(indexed, [this]() { indexLines(); });
+    const char* data = begin();
+    if (position > size()) position = size();
+    // find the last line starting at or before position
+    auto it = std::upper_bound(lines.begin(), lines.end(), position) - 1;
+    size_t line = it - lines.begin();
+    size_t column = position - *it;
+    // do not count any utf8 continuation bytes
+    if (!ascii[line]) {
+      column = Util::count_code_points(data + *it, data + position);
+    }
+    // the parser skips the unicode BOM
+    if (line == 0 && position >= 3 && size() >= 3 &&
+        memcmp(data, "\xEF\xBB\xBF", 3) == 0) column -= 1;
+    return Offset(line, column);
+  }
+
   SourceFile::SourceFile(
     const char* path,
     const char* data,
     size_t srcid) :
     SourceData(),
-    path(sass_copy_c_string(path)),
-    data(sass_copy_c_string(data)),
-    length(0),
-    srcid(srcid)
+    path(path),
+    owned(data),
+    data(owned.c_str()),
+    length(owned.size()),
+    srcid(srcid),
+    borrowed(false)
+  {
+  }
+
+  SourceFile::SourceFile(
+    const char* path,
+    const char* data,
+    size_t srcid,
+    bool borrow,
+    size_t length) :
+    SourceData(),
+    path(path),
+    owned(),
+    data(data),
+    length(length),
+    srcid(srcid),
+    borrowed(borrow)
   {
-    length = strlen(data);
+    if (length == sass::string::npos) this->length = strlen(data);
+    if (!borrow) {
+      owned.assign(data, this->length);
+      this->data = owned.c_str();
+    }
   }
 
+  // Our memory comes from the pool of the
+  // source, so nothing is left to release
   SourceFile::~SourceFile() {
-    sass_free_memory(path);
-    sass_free_memory(data);
+  }
+
+  void SourceFile::ownData()
+  {
+    if (!borrowed) return;
+    owned.reserve(length + 1);
+    owned.assign(data, length);
+    // keep the sentinels for the lexer
+    owned.push_back('\0');
+    data = owned.c_str();
+    borrowed = false;
   }
 
   const char* SourceFile::end() const
@@ -65,5 +135,21 @@ namespace Sass {
     return SourceSpan(pstate);
   }
 
+  PosFile::PosFile(SourceDataObj source, const Offset& position) :
+    SourceData(),
+    source(source),
+    position(position)
+  {}
+
+  Offset PosFile::getLineColumn(size_t) const
+  {
+    return position;
+  }
+
+  SourceSpan PosFile::getSourceSpan()
+  {
+    return SourceSpan(this);
+  }
+
 }
 
@@ -11,10 +11,14 @@ namespace Sass {
   class SourceFile :
     public SourceData {
   protected:
-    char* path;
-    char* data;
+    sass::string path;
+    // our copy of the data
+    sass::string owned;
+    const char* data;
     size_t length;
     size_t srcid;
+    // data is not ours
+    bool borrowed;
   public:
 
     SourceFile(
@@ -22,8 +26,22 @@ namespace Sass {
       const char* data,
       size_t srcid);
 
+    // Uses [data] without a copy, so it must outlive this
+    // object (e.g. the resources of the context) or be
+    // copied via `ownData` before it goes away. Pass the
+    // [length] if known, so it does not have to be counted.
+    SourceFile(
+      const char* path,
+      const char* data,
+      size_t srcid,
+      bool borrow,
+      size_t length = sass::string::npos);
+
     ~SourceFile();
 
+    // Copies borrowed data so it can outlive its owner
+    void ownData();
+
     const char* end() const override final;
     const char* begin() const override final;
     virtual const char* getRawData() const override;
@@ -34,13 +52,19 @@ namespace Sass {
     }
 
     virtual const char* getPath() const override {
-      return path;
+      return path.c_str();
     }
 
     virtual size_t getSrcId() const override {
       return srcid;
     }
 
+    // Files parsed ahead of time only get
+    // their index once they are registered
+    void setSrcId(size_t id) {
+      srcid = id;
+    }
+
   };
 
   class SynthFile :
@@ -90,6 +114,40 @@ namespace Sass {
     SourceSpan getSourceSpan() override final;
   };
 
+  // Reports a fixed line and column of [source] for all its
+  // spans, e.g. for an error position given by an importer
+  class PosFile :
+    public SourceData {
+  private:
+    SourceDataObj source;
+    Offset position;
+  public:
+
+    PosFile(SourceDataObj source,
+      const Offset& position);
+
+    ~PosFile() {}
+
+    const char* end() const override final { return source->end(); }
+    const char* begin() const override final { return source->begin(); }
+    const char* getRawData() const override final { return source->getRawData(); }
+    Offset getLineColumn(size_t position) const override final;
+    SourceSpan getSourceSpan() override final;
+
+    size_t size() const override final {
+      return source->size();
+    }
+
+    const char* getPath() const override final {
+      return source->getPath();
+    }
+
+    size_t getSrcId() const override final {
+      return source->getSrcId();
+    }
+
+  };
+
 }
 
 #endif
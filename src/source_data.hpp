@@ -1,11 +1,15 @@
 #ifndef SASS_SOURCE_DATA_H
 #define SASS_SOURCE_DATA_H
 
+#include <mutex>
+#include <cstdint>
+
 #include "sass.hpp"
 #include "memory.hpp"
 
 namespace Sass {
 
+  class Offset;
   class SourceSpan;
 
   class SourceData :
@@ -21,10 +25,24 @@ namespace Sass {
     virtual const char* getRawData() const = 0;
     virtual SourceSpan getSourceSpan() = 0;
 
+    // Returns the line and column of byte [position]
+    virtual Offset getLineColumn(size_t position) const;
+
     sass::string to_string() const override {
       return sass::string{ begin(), end() };
     }
     ~SourceData() {}
+
+  private:
+    // Byte offsets where each line starts. Only built once
+    // a position is resolved, e.g. for an error or a source
+    // map. Sources may be shared by compilers via the cache,
+    // so this comes from the memory pool of the source.
+    mutable sass::vector<uint32_t> lines;
+    // Lines without any multi-byte chars
+    mutable sass::vector<bool> ascii;
+    mutable std::once_flag indexed;
+    void indexLines() const;
   };
 
 }
@@ -6,41 +6,224 @@
 #include <sstream>
 #include <iostream>
 #include <iomanip>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
 
 #include "ast.hpp"
 #include "json.hpp"
 #include "context.hpp"
 #include "position.hpp"
 #include "source_map.hpp"
+#include "util_string.hpp"
 
 namespace Sass {
-  SourceMap::SourceMap() : current_position(0, 0, 0), file("stdin") { }
-  SourceMap::SourceMap(const sass::string& file) : current_position(0, 0, 0), file(file) { }
+  SourceMap::SourceMap() : file("stdin") { }
+  SourceMap::SourceMap(const sass::string& file) : file(file) { }
 
-  sass::string SourceMap::render_srcmap(Context &ctx) {
+  // appends [str] quoted and escaped like json_stringify does
+  static void append_json_string(sass::string& out, const char* str)
+  {
+    const char* beg = str;
+    const char* end = str + std::strlen(str);
+    // json.cpp reports (or replaces) invalid utf8
+    if (Util::find_invalid_utf8(beg, end) != end) {
+      char* quoted = json_encode_string(str);
+      out += quoted;
+      free(quoted);
+      return;
+    }
+    const uint64_t ones = 0x0101010101010101ull;
+    const uint64_t high_bits = 0x8080808080808080ull;
+    out += '"';
+    const char* run = beg;
+    const char* cur = beg;
+    while (cur < end) {
+      // skip words without control chars, quotes or backslashes
+      if (end - cur >= 8) {
+        uint64_t word;
+        std::memcpy(&word, cur, 8);
+        const uint64_t quotes = word ^ (ones * '"');
+        const uint64_t slashes = word ^ (ones * '\\');
+        const uint64_t found = ((word - ones * 0x20) & ~word)
+          | ((quotes - ones) & ~quotes) | ((slashes - ones) & ~slashes);
+        if ((found & high_bits) == 0) {
+          cur += 8;
+          continue;
+        }
+      }
+      const unsigned char c = *cur;
+      if (c >= 0x20 && c != '"' && c != '\\') {
+        ++cur;
+        continue;
+      }
+      out.append(run, cur);
+      switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+          // json.cpp writes 0x1F as it is
+          if (c < 0x1F) {
+            const char* hex = "0123456789ABCDEF";
+            out += "\\u00";
+            out += hex[c >> 4];
+            out += hex[c & 0xF];
+          }
+          else out += c;
+      }
+      run = ++cur;
+    }
+    out.append(run, end);
+    out += '"';
+  }
 
-    const bool include_sources = ctx.c_options.source_map_contents;
-    const sass::vector<sass::string> links = ctx.srcmap_links;
-    const sass::vector<Resource>& sources(ctx.resources);
+  InputSourceMap::InputSourceMap() { }
+
+  bool InputSourceMap::parse(const char* json)
+  {
+    JsonNode* root = json_decode(json);
+    if (root == nullptr) return false;
+    JsonNode* version = json_find_member(root, "version");
+    JsonNode* source_root = json_find_member(root, "sourceRoot");
+    JsonNode* source_list = json_find_member(root, "sources");
+    JsonNode* content_list = json_find_member(root, "sourcesContent");
+    JsonNode* mappings = json_find_member(root, "mappings");
+    // index maps (with sections) are not supported
+    bool valid = version && version->tag == JSON_NUMBER && version->number_ == 3
+      && source_list && source_list->tag == JSON_ARRAY
+      && mappings && mappings->tag == JSON_STRING;
+
+    if (valid) {
+      sass::string prefix;
+      if (source_root && source_root->tag == JSON_STRING) prefix = source_root->string_;
+      if (!prefix.empty() && prefix.back() != '/') prefix += '/';
+      JsonNode* node;
+      // segments into null sources are not mapped
+      sass::vector<bool> named;
+      json_foreach(node, source_list) {
+        named.push_back(node->tag == JSON_STRING);
+        sources.push_back(named.back() ? prefix + node->string_ : prefix);
+      }
+      contents.resize(sources.size());
+      has_contents.resize(sources.size(), false);
+      if (content_list && content_list->tag == JSON_ARRAY) {
+        size_t i = 0;
+        json_foreach(node, content_list) {
+          if (i == sources.size()) break;
+          if (node->tag == JSON_STRING) {
+            contents[i] = node->string_;
+            has_contents[i] = true;
+          }
+          i += 1;
+        }
+      }
+      index.resize(sources.size(), sass::string::npos);
+
+      Base64VLQ base64vlq;
+      const char* cur = mappings->string_;
+      const char* end = cur + std::strlen(cur);
+      // all fields but the generated column are relative across lines
+      int generated_column = 0, source = 0, line = 0, column = 0;
+      // sorts the segments of the last line by column
+      auto finish_line = [this]() {
+        std::stable_sort(segments.begin() + lines.back(), segments.end(),
+          [](const Segment& a, const Segment& b) { return a.generated_column < b.generated_column; });
+        lines.push_back(segments.size());
+      };
+      lines.push_back(0);
+      while (valid && cur < end) {
+        if (*cur == ';') {
+          finish_line();
+          generated_column = 0;
+          ++cur;
+          continue;
+        }
+        if (*cur == ',') {
+          ++cur;
+          continue;
+        }
+        // one, four or five fields
+        int fields[5];
+        size_t count = 0;
+        while (valid && cur < end && *cur != ',' && *cur != ';') {
+          valid = count < 5 && base64vlq.decode(cur, end, fields[count]);
+          count += 1;
+        }
+        if (!valid || count == 2 || count == 3) {
+          valid = false;
+          break;
+        }
+        generated_column += fields[0];
+        if (generated_column < 0) {
+          valid = false;
+          break;
+        }
+        Segment segment = { static_cast<size_t>(generated_column), sass::string::npos, 0, 0 };
+        if (count > 1) {
+          source += fields[1];
+          line += fields[2];
+          column += fields[3];
+          if (source < 0 || static_cast<size_t>(source) >= sources.size() || line < 0 || column < 0) {
+            valid = false;
+            break;
+          }
+          if (named[source]) segment.source = source;
+          segment.line = line;
+          segment.column = column;
+        }
+        segments.push_back(segment);
+      }
+      if (valid) finish_line();
+    }
 
-    JsonNode* json_srcmap = json_mkobject();
+    json_delete(root);
+    if (!valid) *this = InputSourceMap();
+    return valid;
+  }
 
-    json_append_member(json_srcmap, "version", json_mknumber(3));
+  bool InputSourceMap::empty() const
+  {
+    return lines.empty();
+  }
 
-    const char *file_name = file.c_str();
-    JsonNode *json_file_name = json_mkstring(file_name);
-    json_append_member(json_srcmap, "file", json_file_name);
+  const InputSourceMap::Segment* InputSourceMap::find(size_t line, size_t column) const
+  {
+    if (line + 1 >= lines.size()) return nullptr;
+    auto beg = segments.begin() + lines[line];
+    auto end = segments.begin() + lines[line + 1];
+    // the last segment that starts at or before the column
+    auto it = std::upper_bound(beg, end, column,
+      [](size_t column, const Segment& segment) { return column < segment.generated_column; });
+    if (it == beg) return nullptr;
+    --it;
+    return it->source == sass::string::npos ? nullptr : &*it;
+  }
 
-    // pass-through sourceRoot option
-    if (!ctx.source_map_root.empty()) {
-      JsonNode* root = json_mkstring(ctx.source_map_root.c_str());
-      json_append_member(json_srcmap, "sourceRoot", root);
+  void SourceMap::render_srcmap(Context &ctx, const sass::string& header, const sass::string& output,
+    sass::string& out, bool base64) {
+
+    const bool include_sources = ctx.c_options.source_map_contents;
+    const sass::vector<sass::string>& links = ctx.srcmap_links;
+    const sass::vector<Resource>& sources(ctx.resources);
+
+    // finish on a copy, so this can be called again
+    Writer rest(writer);
+    if (!rest.header_done) {
+      rest.has_bom = header.compare(0, 3, "\xEF\xBB\xBF") == 0;
+      rest.write(header.data(), header.size(), 0, header_mappings, 0, *this);
     }
+    rest.write(output.data(), output.size(), rest.offset, mappings, header.size(), *this);
 
-    JsonNode *json_sources = json_mkarray();
-    for (size_t i = 0; i < source_index.size(); ++i) {
-      sass::string source(links[source_index[i]]);
-      if (ctx.c_options.source_map_file_urls) {
+    sass::vector<sass::string> names;
+    size_t size = 128 + file.size() + ctx.source_map_root.size() + rest.result.size();
+    auto add_name = [&](sass::string source) {
+      // urls of input maps are taken as they are
+      if (ctx.c_options.source_map_file_urls && source.find("://") == sass::string::npos) {
         source = File::rel2abs(source);
         // check for windows abs path
         if (source[0] == '/') {
@@ -51,152 +234,256 @@ namespace Sass {
           source = "file:///" + source;
         }
       }
-      const char* source_name = source.c_str();
-      JsonNode *json_source_name = json_mkstring(source_name);
-      json_append_element(json_sources, json_source_name);
+      size += source.size() + 8;
+      names.push_back(std::move(source));
+    };
+    for (size_t i = 0; i < source_index.size(); ++i) {
+      add_name(links[source_index[i]]);
+    }
+    for (const auto& input : input_sources) {
+      add_name(input_maps[input.first].sources[input.second]);
+    }
+    if (include_sources) {
+      for (size_t i = 0; i < source_index.size(); ++i) {
+        // escapes take some more
+        size_t length = std::strlen(sources[source_index[i]].contents);
+        size += length + length / 16 + 8;
+      }
+      for (const auto& input : input_sources) {
+        size_t length = input_maps[input.first].contents[input.second].size();
+        size += length + length / 16 + 8;
+      }
+    }
+
+    // written like json_stringify with tabs would do
+    // base64 is encoded piece by piece while it is written,
+    // so the whole json never exists as one string then
+    sass::string json;
+    sass::string& result = base64 ? json : out;
+    out.reserve(out.size() + (base64 ? (size + 2) / 3 * 4 : size));
+    auto drain = [&](bool done) {
+      if (!base64) return;
+      // keep the bytes that don't fill a group yet
+      size_t length = done ? json.size() : json.size() / 3 * 3;
+      Util::append_base64(out, json.data(), length);
+      json.erase(0, length);
+    };
+    result += "{\n\t\"version\": 3,\n\t\"file\": ";
+    append_json_string(result, file.c_str());
+
+    // pass-through sourceRoot option
+    if (!ctx.source_map_root.empty()) {
+      result += ",\n\t\"sourceRoot\": ";
+      append_json_string(result, ctx.source_map_root.c_str());
     }
-    json_append_member(json_srcmap, "sources", json_sources);
 
-    if (include_sources && source_index.size()) {
-      JsonNode *json_contents = json_mkarray();
+    result += ",\n\t\"sources\": ";
+    if (names.empty()) result += "[]";
+    else {
+      result += "[\n";
+      for (size_t i = 0; i < names.size(); ++i) {
+        result += "\t\t";
+        append_json_string(result, names[i].c_str());
+        result += i + 1 < names.size() ? ",\n" : "\n";
+      }
+      result += "\t]";
+    }
+    drain(false);
+
+    if (include_sources && names.size()) {
+      result += ",\n\t\"sourcesContent\": [\n";
       for (size_t i = 0; i < source_index.size(); ++i) {
-        const Resource& resource(sources[source_index[i]]);
-        JsonNode *json_content = json_mkstring(resource.contents);
-        json_append_element(json_contents, json_content);
+        result += "\t\t";
+        append_json_string(result, sources[source_index[i]].contents);
+        result += i + 1 < names.size() ? ",\n" : "\n";
+        drain(false);
       }
-      json_append_member(json_srcmap, "sourcesContent", json_contents);
+      for (size_t i = 0; i < input_sources.size(); ++i) {
+        const InputSourceMap& map = input_maps[input_sources[i].first];
+        const size_t source = input_sources[i].second;
+        result += "\t\t";
+        if (map.has_contents[source]) append_json_string(result, map.contents[source].c_str());
+        else result += "null";
+        result += source_index.size() + i + 1 < names.size() ? ",\n" : "\n";
+        drain(false);
+      }
+      result += "\t]";
     }
 
-    JsonNode *json_names = json_mkarray();
     // so far we have no implementation for names
     // no problem as we do not alter any identifiers
-    json_append_member(json_srcmap, "names", json_names);
-
-    sass::string mappings = serialize_mappings();
-    JsonNode *json_mappings = json_mkstring(mappings.c_str());
-    json_append_member(json_srcmap, "mappings", json_mappings);
+    result += ",\n\t\"names\": []";
 
-    char *str = json_stringify(json_srcmap, "\t");
-    sass::string result = sass::string(str);
-    free(str);
-    json_delete(json_srcmap);
-    return result;
+    result += ",\n\t\"mappings\": ";
+    append_json_string(result, rest.result.c_str());
+    result += "\n}";
+    drain(true);
   }
 
-  sass::string SourceMap::serialize_mappings() {
-    sass::string result = "";
-
-    size_t previous_generated_line = 0;
-    size_t previous_generated_column = 0;
-    size_t previous_original_line = 0;
-    size_t previous_original_column = 0;
-    size_t previous_original_file = 0;
-    for (size_t i = 0; i < mappings.size(); ++i) {
-      const size_t generated_line = mappings[i].generated_position.line;
-      const size_t generated_column = mappings[i].generated_position.column;
-      const size_t original_line = mappings[i].original_position.line;
-      const size_t original_column = mappings[i].original_position.column;
-      const size_t original_file = mappings[i].original_position.file;
+  SourceMap::Writer::Writer()
+  : result(),
+    has_bom(false),
+    header_done(false),
+    header_size(0),
+    offset(0),
+    line(0),
+    column(0),
+    count(0),
+    previous_generated_line(0),
+    previous_generated_column(0),
+    previous_original_line(0),
+    previous_original_column(0),
+    previous_original_file(0),
+    base64vlq()
+  { }
+
+  size_t SourceMap::Writer::write(const char* data, size_t size, size_t base,
+    const sass::vector<Mapping>& mappings, size_t shift, SourceMap& smap)
+  {
+    const size_t end = base + size;
+
+    // walks forward over the output (mappings are in order)
+    auto resolve = [&](size_t target) {
+      while (offset < target) {
+        const char* beg = data + (offset - base);
+        const char* nl = (const char*) memchr(beg, '\n', target - offset);
+        if (nl == nullptr) {
+          column += Util::count_code_points(beg, data + (target - base));
+          offset = target;
+        }
+        else {
+          offset = base + (nl - data) + 1;
+          line += 1;
+          column = 0;
+        }
+      }
+    };
+
+    size_t i = 0;
+    for (; i < mappings.size(); ++i) {
+      const Mapping& mapping(mappings[i]);
+      const size_t target = mapping.generated_offset + shift;
+      // not handed off yet
+      if (target > end) break;
+      resolve(target);
+      const size_t generated_line = line;
+      const size_t generated_column = line == 0 && has_bom && target >= 3 ? column - 1 : column;
+      const Offset original_position(mapping.original_position.getPosition());
+      size_t original_line = original_position.line;
+      size_t original_column = original_position.column;
+      size_t original_file = mapping.original_position.getSrcId();
+      smap.remap(original_file, original_line, original_column);
 
       if (generated_line != previous_generated_line) {
         previous_generated_column = 0;
         if (generated_line > previous_generated_line) {
-          result += sass::string(generated_line - previous_generated_line, ';');
+          result.append(generated_line - previous_generated_line, ';');
           previous_generated_line = generated_line;
         }
       }
-      else if (i > 0) {
+      else if (count > 0) {
         result += ",";
       }
+      count += 1;
 
+      // four fields of at most 7 chars each
+      char segment[32];
+      char* cur = segment;
       // generated column
-      result += base64vlq.encode(static_cast<int>(generated_column) - static_cast<int>(previous_generated_column));
+      cur = base64vlq.encode(cur, static_cast<int>(generated_column) - static_cast<int>(previous_generated_column));
       previous_generated_column = generated_column;
       // file
-      result += base64vlq.encode(static_cast<int>(original_file) - static_cast<int>(previous_original_file));
+      cur = base64vlq.encode(cur, static_cast<int>(original_file) - static_cast<int>(previous_original_file));
       previous_original_file = original_file;
       // source line
-      result += base64vlq.encode(static_cast<int>(original_line) - static_cast<int>(previous_original_line));
+      cur = base64vlq.encode(cur, static_cast<int>(original_line) - static_cast<int>(previous_original_line));
       previous_original_line = original_line;
       // source column
-      result += base64vlq.encode(static_cast<int>(original_column) - static_cast<int>(previous_original_column));
+      cur = base64vlq.encode(cur, static_cast<int>(original_column) - static_cast<int>(previous_original_column));
       previous_original_column = original_column;
+      result.append(segment, cur);
     }
 
-    return result;
+    resolve(end);
+    return i;
   }
 
-  void SourceMap::prepend(const OutputBuffer& out)
+  void SourceMap::flush_header(const sass::string& header)
   {
-    Offset size(out.smap.current_position);
-    for (Mapping mapping : out.smap.mappings) {
-      if (mapping.generated_position.line > size.line) {
-        throw(std::runtime_error("prepend sourcemap has illegal line"));
-      }
-      if (mapping.generated_position.line == size.line) {
-        if (mapping.generated_position.column > size.column) {
-          throw(std::runtime_error("prepend sourcemap has illegal column"));
-        }
-      }
-    }
-    // adjust the buffer offset
-    prepend(Offset(out.buffer));
-    // now add the new mappings
-    VECTOR_UNSHIFT(mappings, out.smap.mappings);
+    // do not count the utf8 bom of the charset
+    // seems it is not counted in any UA
+    writer.has_bom = header.compare(0, 3, "\xEF\xBB\xBF") == 0;
+    writer.write(header.data(), header.size(), 0, header_mappings, 0, *this);
+    writer.header_done = true;
+    writer.header_size = header.size();
+    header_mappings.clear();
   }
 
-  void SourceMap::append(const OutputBuffer& out)
+  void SourceMap::flush(const char* data, size_t size)
   {
-    append(Offset(out.buffer));
+    // mappings are relative to the start of the body
+    size_t written = writer.write(data, size, writer.offset, mappings, writer.header_size, *this);
+    mappings.erase(mappings.begin(), mappings.begin() + written);
   }
 
-  void SourceMap::prepend(const Offset& offset)
+  void SourceMap::discard(void)
   {
-    if (offset.line != 0 || offset.column != 0) {
-      for (Mapping& mapping : mappings) {
-        // move stuff on the first old line
-        if (mapping.generated_position.line == 0) {
-          mapping.generated_position.column += offset.column;
-        }
-        // make place for the new lines
-        mapping.generated_position.line += offset.line;
-      }
-    }
-    if (current_position.line == 0) {
-      current_position.column += offset.column;
+    header_mappings.clear();
+    mappings.clear();
+  }
+
+  void SourceMap::set_header(const SourceMap& top, size_t offset)
+  {
+    header_mappings = top.mappings;
+    for (Mapping& mapping : header_mappings) {
+      mapping.generated_offset += offset;
     }
-    current_position.line += offset.line;
   }
 
-  void SourceMap::append(const Offset& offset)
+  void SourceMap::add_input_map(size_t idx, InputSourceMap&& map)
   {
-    current_position += offset;
+    if (map.empty()) return;
+    if (input_maps.size() <= idx) input_maps.resize(idx + 1);
+    input_maps[idx] = std::move(map);
   }
 
-  void SourceMap::add_open_mapping(const AST_Node* node)
+  void SourceMap::remap(size_t& file, size_t& line, size_t& column)
   {
-    const SourceSpan& span(node->pstate());
-    Position from(span.getSrcId(), span.position);
-    mappings.push_back(Mapping(from, current_position));
+    if (file >= input_maps.size()) return;
+    InputSourceMap& map = input_maps[file];
+    if (map.empty()) return;
+    const InputSourceMap::Segment* segment = map.find(line, column);
+    // keeps pointing to the generated source
+    if (segment == nullptr) return;
+    size_t& source = map.index[segment->source];
+    // sources get their index once they are used
+    if (source == sass::string::npos) {
+      const sass::string& link = map.sources[segment->source];
+      auto it = input_links.find(link);
+      if (it != input_links.end()) source = it->second;
+      else {
+        source = source_index.size() + input_sources.size();
+        input_links.emplace(link, source);
+        input_sources.emplace_back(file, segment->source);
+      }
+    }
+    file = source;
+    line = segment->line;
+    column = segment->column;
   }
 
-  void SourceMap::add_close_mapping(const AST_Node* node)
+  void SourceMap::add_open_mapping(const AST_Node* node, size_t offset)
   {
     const SourceSpan& span(node->pstate());
-    Position to(span.getSrcId(), span.position + span.offset);
-    mappings.push_back(Mapping(to, current_position));
+    SourceSpan from(span.source, span.position);
+    mappings.push_back(Mapping(from, offset));
   }
 
-  SourceSpan SourceMap::remap(const SourceSpan& pstate) {
-    for (size_t i = 0; i < mappings.size(); ++i) {
-      if (
-        mappings[i].generated_position.file == pstate.getSrcId() &&
-        mappings[i].generated_position.line == pstate.position.line &&
-        mappings[i].generated_position.column == pstate.position.column
-      ) return SourceSpan(pstate.source, mappings[i].original_position, pstate.offset);
-    }
-    return SourceSpan(pstate.source, Position(-1, -1, -1), Offset(0, 0));
-
+  void SourceMap::add_close_mapping(const AST_Node* node, size_t offset)
+  {
+    const SourceSpan& span(node->pstate());
+    SourceSpan to(span.source, span.position + span.length);
+    mappings.push_back(Mapping(to, offset));
   }
 
 }
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
 
 #include "ast_fwd_decl.hpp"
 #include "base64vlq.hpp"
@@ -20,6 +21,46 @@ namespace Sass {
   class Context;
   class OutputBuffer;
 
+  // A source map that came with a source (e.g. from an importer).
+  // Mappings into that source are remapped through it, so the
+  // resulting source map points to the original sources.
+  class InputSourceMap {
+
+  public:
+    struct Segment {
+      size_t generated_column;
+      // npos if the segment maps to nothing
+      size_t source;
+      size_t line;
+      size_t column;
+    };
+
+    // sources as given in the map (with the source root)
+    sass::vector<sass::string> sources;
+    // content of every source (if present)
+    sass::vector<sass::string> contents;
+    sass::vector<bool> has_contents;
+
+    InputSourceMap();
+
+    // parses the json of a source map (version 3), returns
+    // false and stays empty if it is not a valid one
+    bool parse(const char* json);
+    bool empty() const;
+
+    // finds the segment that covers [column] on [line]
+    const Segment* find(size_t line, size_t column) const;
+
+  private:
+    // segments of every line sorted by column
+    sass::vector<Segment> segments;
+    // first segment of every line (and the end)
+    sass::vector<size_t> lines;
+    // global index of every source once it is used
+    sass::vector<size_t> index;
+    friend class SourceMap;
+  };
+
   class SourceMap {
 
   public:
@@ -27,37 +68,101 @@ namespace Sass {
     SourceMap();
     SourceMap(const sass::string& file);
 
-    void append(const Offset& offset);
-    void prepend(const Offset& offset);
-    void append(const OutputBuffer& out);
-    void prepend(const OutputBuffer& out);
-    void add_open_mapping(const AST_Node* node);
-    void add_close_mapping(const AST_Node* node);
-
-    sass::string render_srcmap(Context &ctx);
-    SourceSpan remap(const SourceSpan& pstate);
+    // takes the mappings of output that is put in front of
+    // the rest, [offset] bytes into the header (see below)
+    void set_header(const SourceMap& top, size_t offset);
+    // [offset] is the current size of the generated output
+    void add_open_mapping(const AST_Node* node, size_t offset);
+    void add_close_mapping(const AST_Node* node, size_t offset);
+    // mappings into source [idx] are remapped through [map]
+    // the sources of [map] must be linked to the output file
+    void add_input_map(size_t idx, InputSourceMap&& map);
+
+    // serializes the mappings of output that is handed off
+    // the header goes first, then the rest in [size] chunks
+    void flush_header(const sass::string& header);
+    void flush(const char* data, size_t size);
+    // forgets the mappings of output that is handed off
+    void discard(void);
+
+    // the generated output is [header] followed by [output]
+    // [output] is what is left of the rest after any flush
+    // appends the map to [out], base64 encoded if [base64]
+    void render_srcmap(Context &ctx, const sass::string& header, const sass::string& output,
+      sass::string& out, bool base64 = false);
 
   private:
 
-    sass::string serialize_mappings();
-
+    // input maps by source index (empty for most)
+    sass::vector<InputSourceMap> input_maps;
+    // sources of input maps that are used by any mapping
+    // they are listed after ours (deduplicated by link)
+    // (index of the input map, index of the source in it)
+    sass::vector<std::pair<size_t, size_t>> input_sources;
+    std::unordered_map<sass::string, size_t> input_links;
+
+    // maps a position in source [file] through its input map
+    void remap(size_t& file, size_t& line, size_t& column);
+
+    // serializes mappings while sweeping forward over the output
+    // the state is kept so the output can be handed off in chunks
+    struct Writer {
+      Writer();
+      // sweeps over [size] bytes at [base] in the whole output
+      // and serializes the leading [mappings] located in them
+      size_t write(const char* data, size_t size, size_t base,
+        const sass::vector<Mapping>& mappings, size_t shift, SourceMap& smap);
+      sass::string result;
+      // the utf8 bom is not counted as column
+      bool has_bom;
+      bool header_done;
+      size_t header_size;
+      // where the sweep is in the whole output
+      size_t offset;
+      size_t line;
+      size_t column;
+      size_t count;
+      size_t previous_generated_line;
+      size_t previous_generated_column;
+      size_t previous_original_line;
+      size_t previous_original_column;
+      size_t previous_original_file;
+      Base64VLQ base64vlq;
+    };
+
+    Writer writer;
+
+    // relative to the start of the header
+    sass::vector<Mapping> header_mappings;
+    // relative to the end of the header
     sass::vector<Mapping> mappings;
-    Position current_position;
 public:
     sass::string file;
-private:
-    Base64VLQ base64vlq;
   };
 
   class OutputBuffer {
     public:
       OutputBuffer(void)
-      : buffer(),
-        smap()
+      : header(),
+        buffer(),
+        smap(),
+        flushed(0),
+        start(0),
+        non_ascii(false)
       { }
     public:
+      // hoisted output (charset, imports and comments)
+      // that is put in front of the buffer at the end
+      sass::string header;
       sass::string buffer;
       SourceMap smap;
+      // bytes dropped from the front of the buffer
+      size_t flushed;
+      // bytes at the front of the buffer that are
+      // handed off to a sink, but not dropped yet
+      size_t start;
+      // set once a char above 127 is appended
+      bool non_ascii;
   };
 
 }
@@ -0,0 +1,154 @@
+// sass.hpp must go before all system headers to get the
+// __EXTENSIONS__ fix on Solaris.
+#include "sass.hpp"
+
+#include <cstring>
+
+#include "stylesheet_cache.hpp"
+#include "sass_context.hpp"
+
+namespace Sass {
+
+  StylesheetCache::StylesheetCache(size_t max_sheets)
+  : max_sheets(max_sheets),
+    hits(0),
+    misses(0)
+  { }
+
+  void StylesheetCache::release(const Sass_Compiler* owner)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Entry& entry : entries) {
+      if (entry.owner != owner) continue;
+      // in document order, so the indexes are still valid
+      for (DeferredImport& deferred : entry.imports) {
+        Block* block = deferred.block;
+        auto begin = block->begin() + deferred.index;
+        block->elements().erase(begin, begin + deferred.inserted);
+        deferred.imp->urls().clear();
+        deferred.imp->incs().clear();
+        deferred.inserted = 0;
+      }
+      entry.source->setSrcId(sass::string::npos);
+      entry.owner = nullptr;
+    }
+  }
+
+  StylesheetCache::Entries::iterator StylesheetCache::drop(Entries::iterator entry)
+  {
+    auto range = index.equal_range(entry->path);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second != entry) continue;
+      index.erase(it);
+      break;
+    }
+    // nobody uses the tree anymore, so
+    // it goes away with its pool at once
+    if (entry->pool) entry->pool->release();
+    return entries.erase(entry);
+  }
+
+  bool StylesheetCache::evict(size_t room)
+  {
+    auto it = entries.end();
+    while (entries.size() + room > max_sheets) {
+      if (it == entries.begin()) return false;
+      if ((--it)->owner) continue;
+      it = drop(it);
+    }
+    return true;
+  }
+
+  bool StylesheetCache::lease(const Sass_Compiler* owner, const sass::string& path, const char* contents,
+    SourceFileObj& source, Block_Obj& root, sass::vector<DeferredImport>*& imports,
+    MemoryPoolPtr& pool)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t length = std::strlen(contents);
+    auto range = index.equal_range(path);
+    for (auto it = range.first; it != range.second;) {
+      Entries::iterator entry = (it++)->second;
+      // only valid for the exact same contents
+      if (entry->source->size() != length ||
+          std::memcmp(entry->source->begin(), contents, length) != 0) {
+        // the file has changed since
+        if (!entry->owner) drop(entry);
+        continue;
+      }
+      // try the next tree
+      if (entry->owner) continue;
+      hits += 1;
+      entry->owner = owner;
+      entries.splice(entries.begin(), entries, entry);
+      source = entry->source;
+      root = entry->root;
+      imports = &entry->imports;
+      pool = entry->pool;
+      return true;
+    }
+    misses += 1;
+    return false;
+  }
+
+  bool StylesheetCache::insert(const Sass_Compiler* owner, const sass::string& path,
+    SourceFileObj& source, Block_Obj& root, sass::vector<DeferredImport>*& imports,
+    const MemoryPoolPtr& pool)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!evict(1)) return false;
+    {
+      // the resource goes away with the context
+      MemoryPoolScope scope(pool.get());
+      source->ownData();
+    }
+    // entries are dropped by any thread
+    MemoryPoolScope scope(nullptr);
+    entries.push_front({ pool, path, source, root, {}, owner });
+    Entry& entry = entries.front();
+    entry.imports.swap(*imports);
+    index.emplace(path, entries.begin());
+    imports = &entry.imports;
+    return true;
+  }
+
+  size_t StylesheetCache::getHits()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+  }
+
+  size_t StylesheetCache::getMisses()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+  }
+
+  size_t StylesheetCache::getSize()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+  }
+
+}
+
+extern "C" {
+  using namespace Sass;
+
+  struct Sass_Stylesheet_Cache* ADDCALL sass_make_stylesheet_cache(size_t max_sheets)
+  {
+    // must outlive the memory pool of any compiler
+    MemoryPoolScope scope(nullptr);
+    return new Sass_Stylesheet_Cache(max_sheets);
+  }
+
+  void ADDCALL sass_delete_stylesheet_cache(struct Sass_Stylesheet_Cache* cache)
+  {
+    MemoryPoolScope scope(nullptr);
+    delete cache;
+  }
+
+  size_t ADDCALL sass_stylesheet_cache_get_hits(struct Sass_Stylesheet_Cache* cache) { return cache->getHits(); }
+  size_t ADDCALL sass_stylesheet_cache_get_misses(struct Sass_Stylesheet_Cache* cache) { return cache->getMisses(); }
+  size_t ADDCALL sass_stylesheet_cache_get_size(struct Sass_Stylesheet_Cache* cache) { return cache->getSize(); }
+
+}
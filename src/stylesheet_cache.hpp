@@ -0,0 +1,98 @@
+#ifndef SASS_STYLESHEET_CACHE_H
+#define SASS_STYLESHEET_CACHE_H
+
+// sass.hpp must go before all system headers to get the
+// __EXTENSIONS__ fix on Solaris.
+#include "sass.hpp"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "parser.hpp"
+#include "source.hpp"
+
+namespace Sass {
+
+  // Parsed stylesheets that can be shared between compilations.
+  // Sheets are parsed with deferred imports (see `DeferredImport`),
+  // so every compilation can resolve them against its own include
+  // paths. An entry is only valid for the exact contents it was
+  // parsed from. Reference counts are not atomic and evaluation
+  // writes to the tree, so a sheet is leased to one compilation
+  // at a time. It is returned, with its imports unresolved again,
+  // once the compiler that leased it is deleted. A compilation that
+  // wants a sheet whose trees are all leased parses another one, which
+  // is added to the cache too. So there are as many trees of a sheet
+  // as compilations used it at once (e.g. one per batch worker).
+  // Every tree has its own memory pool, which compilations using
+  // it retain, so the tree stays valid until they are all deleted.
+  class StylesheetCache {
+
+  private:
+
+    struct Entry {
+      // released after the nodes
+      MemoryPoolPtr pool;
+      sass::string path;
+      SourceFileObj source;
+      Block_Obj root;
+      sass::vector<DeferredImport> imports;
+      // compiler that currently uses it
+      const Sass_Compiler* owner;
+    };
+
+    // most recently used first
+    typedef std::list<Entry> Entries;
+
+    std::mutex mutex;
+    Entries entries;
+    // all trees of a path
+    std::unordered_multimap<sass::string, Entries::iterator> index;
+    size_t max_sheets;
+    size_t hits;
+    size_t misses;
+
+    // Drops idle entries until there is room for [room] more
+    bool evict(size_t room);
+
+    // Removes [entry] and returns the one after it
+    Entries::iterator drop(Entries::iterator entry);
+
+  public:
+
+    // Keeps at most [max_sheets] stylesheets
+    StylesheetCache(size_t max_sheets);
+
+    // Leases an idle tree of [path] to [owner] if it was parsed
+    // from [contents]. The imports must be resolved by the caller.
+    bool lease(const Sass_Compiler* owner, const sass::string& path, const char* contents,
+      SourceFileObj& source, Block_Obj& root, sass::vector<DeferredImport>*& imports,
+      MemoryPoolPtr& pool);
+
+    // Adds a newly parsed tree, leased to [owner] right away. Its
+    // nodes must come from [pool] (and nothing else may do so).
+    // Returns false if it could not be added to the cache.
+    bool insert(const Sass_Compiler* owner, const sass::string& path,
+      SourceFileObj& source, Block_Obj& root, sass::vector<DeferredImport>*& imports,
+      const MemoryPoolPtr& pool);
+
+    // Returns all sheets of [owner], after removing the
+    // nodes their imports have been resolved to again.
+    void release(const Sass_Compiler* owner);
+
+    size_t getHits();
+    size_t getMisses();
+    size_t getSize();
+
+  };
+
+}
+
+// The opaque handle for the C-API
+struct Sass_Stylesheet_Cache : public Sass::StylesheetCache {
+  Sass_Stylesheet_Cache(size_t max_sheets)
+  : StylesheetCache(max_sheets) {}
+};
+
+#endif
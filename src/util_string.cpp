@@ -1,7 +1,14 @@
 #include "util_string.hpp"
+#include "utf8/core.h"
 
 #include <iostream>
+#include <locale>
+#include <sstream>
 #include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 
 namespace Sass {
   namespace Util {
@@ -39,6 +46,182 @@ namespace Sass {
       }
     }
 
+    // the high bit of every byte in a word
+    static const uint64_t high_bits = 0x8080808080808080ull;
+
+    bool ascii_only(const char* beg, const char* end) {
+      uint64_t seen = 0;
+      while (end - beg >= 8) {
+        uint64_t word;
+        std::memcpy(&word, beg, 8);
+        seen |= word;
+        beg += 8;
+      }
+      while (beg < end) seen |= static_cast<unsigned char>(*beg++);
+      return (seen & high_bits) == 0;
+    }
+
+    size_t count_code_points(const char* beg, const char* end) {
+      size_t bytes = end - beg;
+      size_t continuations = 0;
+      while (end - beg >= 8) {
+        uint64_t word;
+        std::memcpy(&word, beg, 8);
+        // continuation bytes have bit 7 set and bit 6 clear
+        uint64_t marks = word & ~(word << 1) & high_bits;
+        // add up the marks of all bytes in the top byte
+        continuations += ((marks >> 7) * 0x0101010101010101ull) >> 56;
+        beg += 8;
+      }
+      while (beg < end) {
+        if ((*beg++ & 192) == 128) continuations += 1;
+      }
+      return bytes - continuations;
+    }
+
+    const char* find_invalid_utf8(const char* beg, const char* end) {
+      while (beg < end) {
+        // most input is plain ascii
+        while (end - beg >= 16) {
+          uint64_t lo, hi;
+          std::memcpy(&lo, beg, 8);
+          std::memcpy(&hi, beg + 8, 8);
+          if ((lo | hi) & high_bits) break;
+          beg += 16;
+        }
+        while (beg < end && static_cast<unsigned char>(*beg) < 128) ++beg;
+        if (beg == end) break;
+        // decode one multi-byte sequence (resets on error)
+        if (utf8::internal::validate_next(beg, end) != utf8::internal::UTF8_OK) {
+          return beg;
+        }
+      }
+      return end;
+    }
+
+    // returns the rounding error of [product] = [a] * [b]
+    static double product_error(double a, double b, double product)
+    {
+      #ifdef FP_FAST_FMA
+      return std::fma(a, b, -product);
+      #else
+      // split into halves that multiply exactly (Dekker)
+      const double a_split = 134217729.0 * a;
+      const double a_hi = a_split - (a_split - a);
+      const double a_lo = a - a_hi;
+      const double b_split = 134217729.0 * b;
+      const double b_hi = b_split - (b_split - b);
+      const double b_lo = b - b_hi;
+      return ((a_hi * b_hi - product) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo;
+      #endif
+    }
+
+    // removes trailing zeros and then the decimal point
+    // a fixed stream with precision 0 loses zeros too
+    static void trim_fixed(sass::string& out, size_t start)
+    {
+      size_t s = out.size();
+      while (s > start + 1 && out[s - 1] == '0') --s;
+      if (s > start + 1 && out[s - 1] == '.') --s;
+      out.resize(s);
+    }
+
+    void append_fixed(sass::string& out, double value, int precision)
+    {
+      static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+        1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+      };
+      const size_t start = out.size();
+      const double abs = std::fabs(value);
+
+      // needs exact double arithmetic (no x87 registers)
+      if (FLT_EVAL_METHOD != 0 || precision < 0 || precision > 15 || !(abs < 1e18)) {
+        sass::ostream ss;
+        ss.imbue(std::locale::classic());
+        ss.precision(precision);
+        ss << std::fixed << value;
+        out += ss.str();
+        trim_fixed(out, start);
+        return;
+      }
+
+      // both parts are exact
+      const double whole = std::floor(abs);
+      const double fraction = abs - whole;
+      uint64_t integer = static_cast<uint64_t>(whole);
+
+      // the decimals are [scaled] plus an exact [error]
+      const double scale = powers[precision];
+      const double scaled = fraction * scale;
+      const double error = product_error(fraction, scale, scaled);
+      const double floored = std::floor(scaled);
+      const double rest = scaled - floored;
+      uint64_t decimals = static_cast<uint64_t>(floored);
+
+      // round half to even on the exact binary value
+      // the error can't move the rest across a half
+      bool odd = (precision ? decimals : integer) & 1;
+      if (rest > 0.5 || (rest == 0.5 && (error > 0 || (error == 0 && odd)))) {
+        decimals += 1;
+      }
+      if (decimals == static_cast<uint64_t>(scale)) {
+        decimals = 0;
+        integer += 1;
+      }
+
+      char digits[48];
+      char* end = digits + sizeof(digits);
+      char* cur = end;
+      for (int i = 0; i < precision; ++i) {
+        *--cur = '0' + decimals % 10;
+        decimals /= 10;
+      }
+      if (precision) *--cur = '.';
+      do {
+        *--cur = '0' + integer % 10;
+        integer /= 10;
+      } while (integer);
+      if (std::signbit(value)) *--cur = '-';
+      out.append(cur, end);
+      trim_fixed(out, start);
+    }
+
+    void append_base64(sass::string& out, const char* data, size_t size)
+    {
+      static const char* alphabet =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+      // both chars for every 12 bits
+      static const struct Pairs {
+        char chars[4096][2];
+        Pairs() {
+          for (size_t i = 0; i < 4096; ++i) {
+            chars[i][0] = alphabet[i >> 6];
+            chars[i][1] = alphabet[i & 63];
+          }
+        }
+      } pairs;
+
+      const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+      const size_t whole = size / 3;
+      const size_t start = out.size();
+      out.resize(start + (size + 2) / 3 * 4);
+      char* cur = &out[start];
+      for (size_t i = 0; i < whole; ++i, in += 3, cur += 4) {
+        const uint32_t bits = (in[0] << 16) | (in[1] << 8) | in[2];
+        std::memcpy(cur, pairs.chars[bits >> 12], 2);
+        std::memcpy(cur + 2, pairs.chars[bits & 0xFFF], 2);
+      }
+      // pad the last one or two bytes
+      if (size % 3) {
+        const uint32_t bits = (in[0] << 16) | (size % 3 == 2 ? in[1] << 8 : 0);
+        cur[0] = alphabet[bits >> 18];
+        cur[1] = alphabet[(bits >> 12) & 63];
+        cur[2] = size % 3 == 2 ? alphabet[(bits >> 6) & 63] : '=';
+        cur[3] = '=';
+      }
+    }
+
     sass::string rtrim(sass::string str) {
       auto it = std::find_if_not(str.rbegin(), str.rend(), ascii_isspace);
       str.erase(str.rend() - it);
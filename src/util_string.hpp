@@ -68,6 +68,30 @@ namespace Sass {
 
     void ascii_str_toupper(sass::string* s);
 
+    // Returns true if [beg, end) has no bytes above 127.
+    // Tests a whole machine word per step.
+    bool ascii_only(const char* beg, const char* end);
+
+    // Returns the number of utf8 code points in [beg, end),
+    // i.e. every byte that is not a continuation byte.
+    // Counts a whole machine word per step.
+    size_t count_code_points(const char* beg, const char* end);
+
+    // Returns the first invalid utf8 sequence in [beg, end)
+    // or [end], like `utf8::find_invalid`, but skips ascii
+    // runs 16 bytes per step before decoding anything.
+    const char* find_invalid_utf8(const char* beg, const char* end);
+
+    // Appends [value] like a stream with `std::fixed` and [precision]
+    // does, minus any trailing zeros and decimal point. Independent of
+    // the locale. Rounds exactly (half to even) without a stream for up
+    // to 15 decimals and integer parts below 1e18.
+    void append_fixed(sass::string& out, double value, int precision);
+
+    // Appends [size] bytes of [data] base64 encoded (with padding).
+    // Encodes three bytes at a time via a table of char pairs.
+    void append_base64(sass::string& out, const char* data, size_t size);
+
   }  // namespace Sass
 }  // namespace Util
 #endif  // SASS_UTIL_STRING_H
@@ -0,0 +1,275 @@
+#include "sass/context.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// Compile `source` once via the data context C-API
+// optionally with a source map that includes the sources
+bool compile(const std::string& source, bool srcmap = false, bool embed = false) {
+  char* input = static_cast<char*>(malloc(source.size() + 1));
+  std::memcpy(input, source.c_str(), source.size() + 1);
+  struct Sass_Data_Context* data_ctx = sass_make_data_context(input);
+  struct Sass_Context* ctx = sass_data_context_get_context(data_ctx);
+  if (srcmap) {
+    struct Sass_Options* options = sass_context_get_options(ctx);
+    sass_option_set_output_path(options, "out.css");
+    sass_option_set_source_map_file(options, "out.css.map");
+    sass_option_set_source_map_contents(options, true);
+    sass_option_set_source_map_embed(options, embed);
+  }
+  bool ok = sass_compile_data_context(data_ctx) == 0;
+  if (!ok) std::cerr << sass_context_get_error_message(ctx);
+  sass_delete_data_context(data_ctx);
+  return ok;
+}
+
+// Measures the fixed cost every compilation has to pay before
+// it sees any real input (mostly setting up the environment).
+bool BenchSetupCost(size_t& iterations) {
+  iterations = 2000;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!compile("a { b: c; }")) return false;
+  }
+  return true;
+}
+
+// Utility class generator calling the same functions and
+// mixins from tight loops (call sites are hit repeatedly).
+bool BenchUtilityClasses(size_t& iterations) {
+  const std::string source =
+    "@function space($i) { @return $i * 4px; }\n"
+    "@mixin pad($i) { padding: space($i); margin: -space($i); }\n"
+    "@for $i from 1 through 200 {\n"
+    "  .p-#{$i} { @include pad($i); color: rgba(0, 0, 0, $i / 200); }\n"
+    "}\n";
+  iterations = 50;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!compile(source)) return false;
+  }
+  return true;
+}
+
+// Design token maps built up one entry at a time, which
+// copied the whole map on every `map-merge` call before.
+bool BenchMapMerge(size_t& iterations) {
+  const std::string source =
+    "$tokens: ();\n"
+    "@for $i from 1 through 2000 {\n"
+    "  $tokens: map-merge($tokens, (token-#{$i}: $i * 1px));\n"
+    "}\n"
+    "@for $i from 1 through 300 {\n"
+    "  $tokens: map-remove($tokens, token-#{$i * 4});\n"
+    "}\n"
+    "a { b: length($tokens); c: map-get($tokens, token-999); }\n";
+  iterations = 5;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!compile(source)) return false;
+  }
+  return true;
+}
+
+// Lists built up one item at a time, which copied the
+// whole list on every `append` call before.
+bool BenchListAppend(size_t& iterations) {
+  const std::string source =
+    "$list: ();\n"
+    "@for $i from 1 through 10000 {\n"
+    "  $list: append($list, item-#{$i}, comma);\n"
+    "}\n"
+    "a { b: length($list); c: nth($list, -1); }\n";
+  iterations = 5;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!compile(source)) return false;
+  }
+  return true;
+}
+
+bool BenchExtendTrim(size_t& iterations) {
+  const std::string source =
+    "%btn { a: b; }\n"
+    ".x %btn, %btn:hover { c: d; }\n"
+    "@for $i from 1 through 300 {\n"
+    "  .c#{$i} { @extend %btn; }\n"
+    "  .w .c#{$i} { @extend %btn; }\n"
+    "  .c#{$i}.m#{$i % 7} { @extend %btn; }\n"
+    "}\n";
+  iterations = 3;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!compile(source)) return false;
+  }
+  return true;
+}
+
+// Expression evaluation that mostly checks and casts node
+// types (operands, arguments, interpolations, conditions).
+bool BenchEvalDispatch(size_t& iterations) {
+  const std::string source =
+    "$map: (a: 1px, b: 2em, c: #abc, d: 'str', e: null, f: true);\n"
+    "@function kind($v) { @if type-of($v) == number { @return $v * 2 + 1; }\n"
+    "  @else if type-of($v) == color { @return lighten($v, 5%); }\n"
+    "  @else if $v == null { @return none; } @return '#{$v}-x'; }\n"
+    "@for $i from 1 through 150 {\n"
+    "  .e-#{$i} { @each $k, $v in $map { #{$k}: kind($v) ($i % 3 == 0) -$i; } }\n"
+    "}\n";
+  iterations = 20;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!compile(source)) return false;
+  }
+  return true;
+}
+
+// Extending compound selectors with many simple selectors,
+// which casts every component while weaving and unifying.
+bool BenchExtendDispatch(size_t& iterations) {
+  const std::string source =
+    "@for $i from 1 through 60 {\n"
+    "  .a#{$i}.b:hover > [data-x] ~ .c#{$i % 9}::before, #id#{$i} .d { e: f; }\n"
+    "  .x#{$i} { @extend .a#{$i}; @extend .c#{$i % 9}; }\n"
+    "  span.y#{$i}:not(.z) { @extend .d; }\n"
+    "}\n";
+  iterations = 10;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!compile(source)) return false;
+  }
+  return true;
+}
+
+// Vendored minified CSS with long license comments and many
+// quoted strings, which the parser mostly has to skip over.
+bool BenchMinifiedCss(size_t& iterations) {
+  std::string source;
+  for (size_t i = 0; i < 200; ++i) {
+    source += "/*! component " + std::to_string(i) + " | license: ";
+    for (size_t n = 0; n < 20; ++n) source += "permission is granted to use, copy and modify ";
+    source += "*/\n";
+    source += ".c" + std::to_string(i) + "{font-family:\"Helvetica Neue\",\"Segoe UI\",sans-serif;"
+      "content:\"a rather long generated content string #" + std::to_string(i) + " with some words\";"
+      "margin:0 auto;color:#333}.c" + std::to_string(i) + ":before{content:'\\201C';quotes:\"\\201C\" \"\\201D\"}";
+  }
+  iterations = 10;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!compile(source)) return false;
+  }
+  return true;
+}
+
+// Inlined images as long base64 data URIs, both as raw
+// `url()` bodies and inside quoted strings.
+bool BenchDataUris(size_t& iterations) {
+  const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string data;
+  for (size_t i = 0; i < 20000; ++i) data += alphabet[(i * 7 + i / 64) % 64];
+  std::string source;
+  for (size_t i = 0; i < 20; ++i) {
+    source += ".i" + std::to_string(i) + " { background: url(data:image/png;base64," + data + "); }\n";
+    source += ".q" + std::to_string(i) + " { background: url(\"data:image/png;base64," + data + "\"); }\n";
+  }
+  iterations = 10;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!compile(source)) return false;
+  }
+  return true;
+}
+
+// A bundle with megabytes of output, non-ascii content (so it
+// needs a charset) and hoisted imports that go on top of it.
+bool BenchLargeOutput(size_t& iterations) {
+  const std::string source =
+    "@for $i from 1 through 20000 {\n"
+    "  .icon-#{$i}::before { content: \"\\f#{$i % 1000} \u00e9\"; margin: 0 auto; }\n"
+    "}\n"
+    "@import url(\"fonts.css\");\n";
+  iterations = 3;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!compile(source)) return false;
+  }
+  return true;
+}
+
+// Numbers and colors are most of the output of a design
+// system, lots of them with decimals and transparency.
+bool BenchNumbers(size_t& iterations) {
+  const std::string source =
+    "$base: 1.6180339887px;\n"
+    "@for $i from 1 through 4000 {\n"
+    "  .n-#{$i} { width: $base * $i; margin: -$i / 7 * 1em 0.5rem;\n"
+    "    line-height: 1 + $i / 3000; opacity: $i / 4000;\n"
+    "    color: rgba(($i * 7) % 256, ($i * 13) % 256, 40, $i / 4001);\n"
+    "    background: mix(#1e90ff, #ff6347, percentage($i / 4000)); }\n"
+    "}\n";
+  iterations = 3;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!compile(source)) return false;
+  }
+  return true;
+}
+
+// Plain css with lots of short declarations (so lots of
+// mappings) whose source ends up in the source map.
+std::string source_map_source() {
+  std::string source;
+  for (size_t i = 0; i < 3000; ++i) {
+    source += "/* \"block\" " + std::to_string(i) + " */\n.m-" + std::to_string(i) + " {\n"
+      "\tmargin: 0 auto;\n\tpadding: 1px 2px;\n\tcolor: red;\n\tcontent: \"\\201C\";\n}\n";
+  }
+  return source;
+}
+
+bool BenchSourceMap(size_t& iterations) {
+  const std::string source = source_map_source();
+  iterations = 5;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!compile(source, true)) return false;
+  }
+  return true;
+}
+
+// Same with the source map embedded as a base64 data url.
+bool BenchEmbeddedSourceMap(size_t& iterations) {
+  const std::string source = source_map_source();
+  iterations = 5;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!compile(source, true, true)) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+#define BENCH(fn) \
+  { \
+    size_t iterations = 0; \
+    auto start = std::chrono::steady_clock::now(); \
+    if (!fn(iterations)) { \
+      std::cerr << "Failed: " #fn << std::endl; \
+      failed += 1; \
+    } else { \
+      auto stop = std::chrono::steady_clock::now(); \
+      double us = std::chrono::duration<double, std::micro>(stop - start).count(); \
+      std::cerr << #fn << ": " << iterations << " runs, " \
+                << (us / iterations) << " us/run" << std::endl; \
+    } \
+  } \
+
+int main(int argc, char **argv) {
+  size_t failed = 0;
+  BENCH(BenchSetupCost);
+  BENCH(BenchUtilityClasses);
+  BENCH(BenchMapMerge);
+  BENCH(BenchListAppend);
+  BENCH(BenchExtendTrim);
+  BENCH(BenchEvalDispatch);
+  BENCH(BenchExtendDispatch);
+  BENCH(BenchMinifiedCss);
+  BENCH(BenchDataUris);
+  BENCH(BenchLargeOutput);
+  BENCH(BenchNumbers);
+  BENCH(BenchSourceMap);
+  BENCH(BenchEmbeddedSourceMap);
+  return failed;
+}
@@ -0,0 +1,107 @@
+#ifndef SASS_TEST_COMPILE_FIXTURE_HPP
+#define SASS_TEST_COMPILE_FIXTURE_HPP
+
+// Helpers shared by the tests that link against the library
+
+#include "sass/context.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+typedef std::vector<std::pair<std::string, std::string>> Files;
+
+const size_t kThreads = 16;
+
+// Compiles `source` via the data context C-API and
+// returns the output or the formatted error message
+inline std::string compile(const std::string& source, Sass_Function_Entry fn = nullptr) {
+  struct Sass_Data_Context* data_ctx = sass_make_data_context(sass_copy_c_string(source.c_str()));
+  struct Sass_Context* ctx = sass_data_context_get_context(data_ctx);
+  if (fn) {
+    struct Sass_Options* options = sass_context_get_options(ctx);
+    Sass_Function_List fn_list = sass_make_function_list(1);
+    sass_function_set_list_entry(fn_list, 0, fn);
+    sass_option_set_c_functions(options, fn_list);
+  }
+  std::string result;
+  if (sass_compile_data_context(data_ctx) == 0) {
+    result = sass_context_get_output_string(ctx);
+  } else {
+    result = std::string("ERROR: ") + sass_context_get_error_message(ctx);
+  }
+  sass_delete_data_context(data_ctx);
+  return result;
+}
+
+// Writes `files` (name, contents) to a new temporary directory
+inline std::string write_files(const Files& files) {
+  char dir[] = "/tmp/libsass-test-XXXXXX";
+  if (!mkdtemp(dir)) return "";
+  for (const auto& file : files) {
+    std::ofstream(std::string(dir) + "/" + file.first) << file.second;
+  }
+  return dir;
+}
+
+// Removes `files` and the directory created by `write_files`
+inline void remove_files(const std::string& dir, const Files& files) {
+  for (const auto& file : files) {
+    unlink((dir + "/" + file.first).c_str());
+  }
+  rmdir(dir.c_str());
+}
+
+// Compiles `source` with imports from `dir` via `threads` import threads
+// and returns the output and source map or the formatted error message
+inline std::string compile_imports(const std::string& source, const std::string& dir, int threads,
+                                   struct Sass_Stylesheet_Cache* cache = nullptr,
+                                   struct Sass_Directory_Cache* listings = nullptr) {
+  struct Sass_Data_Context* data_ctx = sass_make_data_context(sass_copy_c_string(source.c_str()));
+  struct Sass_Context* ctx = sass_data_context_get_context(data_ctx);
+  struct Sass_Options* options = sass_context_get_options(ctx);
+  sass_option_set_include_path(options, dir.c_str());
+  sass_option_set_source_map_file(options, "out.css.map");
+  sass_option_set_import_threads(options, threads);
+  sass_option_set_stylesheet_cache(options, cache);
+  sass_option_set_directory_cache(options, listings);
+  std::string result;
+  if (sass_compile_data_context(data_ctx) == 0) {
+    result = sass_context_get_output_string(ctx);
+    result += sass_context_get_source_map_string(ctx);
+  } else {
+    result = std::string("ERROR: ") + sass_context_get_error_message(ctx);
+  }
+  sass_delete_data_context(data_ctx);
+  return result;
+}
+
+// Runs `fn(thread_index)` on `kThreads` threads at once
+template <typename Fn>
+void run_threads(Fn fn) {
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreads; ++i) {
+    threads.emplace_back(fn, i);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// Custom function returning the number its cookie points to
+inline union Sass_Value* cookie_number(const union Sass_Value* s_args,
+                                       Sass_Function_Entry cb, struct Sass_Compiler* comp) {
+  size_t id = *static_cast<size_t*>(sass_function_get_cookie(cb));
+  return sass_make_number(static_cast<double>(id), "");
+}
+
+}  // namespace
+
+#endif
@@ -0,0 +1,187 @@
+#include "../src/ast.hpp"
+
+#include <initializer_list>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace Sass;
+
+#define ASSERT(cond) \
+  if (!(cond)) { \
+    std::cerr << "Assertion failed: " #cond " at " __FILE__ << ":" << __LINE__ << std::endl; \
+    return false; \
+  } \
+
+template <class... Ts> struct Classes {};
+
+// Every class that has a tag (in the order of the tags)
+typedef Classes<AST_Node, Expression, PreValue, Value, List, Map, Function,
+  Number, Color, Color_RGBA, Color_HSLA, Custom_Error, Custom_Warning,
+  Boolean, String, String_Schema, String_Constant, String_Quoted, Null,
+  Parent_Reference, Binary_Expression, Function_Call, Variable,
+  Unary_Expression, Argument, Arguments, Media_Query, Media_Query_Expression,
+  At_Root_Query, SupportsCondition, SupportsOperation, SupportsNegation,
+  SupportsDeclaration, Supports_Interpolation, Selector, SimpleSelector,
+  PlaceholderSelector, TypeSelector, ClassSelector, IDSelector,
+  AttributeSelector, PseudoSelector, SelectorComponent, SelectorCombinator,
+  CompoundSelector, ComplexSelector, SelectorList, Statement, Block,
+  ParentStatement, StyleRule, Trace, AtRule, Keyframe_Rule, Declaration, If,
+  ForRule, EachRule, WhileRule, Definition, Mixin_Call, MediaRule,
+  CssMediaRule, AtRootRule, SupportsRule, Bubble, Assignment, Import,
+  Import_Stub, WarningRule, ErrorRule, DebugRule, Comment, Return, Content,
+  ExtendRule, CssMediaQuery, Parameter, Parameters, Selector_Schema> AllClasses;
+
+// Classes that are never instantiated, so their own tag is never set
+const std::set<int> kAbstractTags = {
+  AST_Node_Tag, Expression_Tag, PreValue_Tag, Value_Tag, Color_Tag,
+  String_Tag, Selector_Tag, SimpleSelector_Tag, SelectorComponent_Tag,
+  Statement_Tag, ParentStatement_Tag,
+};
+
+// Casts like before the tags were used
+template <class T>
+bool cast_matches(AST_Node* node) {
+  const AST_Node* constant = node;
+  if (Cast<T>(node) != dynamic_cast<T*>(node)) {
+    std::cerr << "Cast to " << typeid(T).name() << " differs for tag " << int(node->tag()) << std::endl;
+    return false;
+  }
+  return Cast<T>(constant) == dynamic_cast<const T*>(constant);
+}
+
+template <class... Ts>
+bool casts_match(AST_Node* node, Classes<Ts...>) {
+  bool matches = true;
+  (void) std::initializer_list<int>{ (matches = cast_matches<Ts>(node) && matches, 0)... };
+  return matches;
+}
+
+// Returns a node of every class that can be instantiated
+std::vector<AST_Node_Obj> every_node() {
+  SourceSpan pstate("[test]");
+  String_Constant_Obj str = SASS_MEMORY_NEW(String_Constant, pstate, "a");
+  String_Schema_Obj schema = SASS_MEMORY_NEW(String_Schema, pstate);
+  schema->append(str);
+  Block_Obj block = SASS_MEMORY_NEW(Block, pstate);
+  Arguments_Obj args = SASS_MEMORY_NEW(Arguments, pstate);
+  Parameters_Obj params = SASS_MEMORY_NEW(Parameters, pstate);
+  SelectorListObj selector = SASS_MEMORY_NEW(SelectorList, pstate);
+  SupportsConditionObj condition = SASS_MEMORY_NEW(Supports_Interpolation, pstate, str);
+  return {
+    SASS_MEMORY_NEW(List, pstate),
+    SASS_MEMORY_NEW(Map, pstate),
+    SASS_MEMORY_NEW(Function, pstate, {}, true),
+    SASS_MEMORY_NEW(Number, pstate, 1),
+    SASS_MEMORY_NEW(Color_RGBA, pstate, 1, 2, 3),
+    SASS_MEMORY_NEW(Color_HSLA, pstate, 1, 2, 3),
+    SASS_MEMORY_NEW(Custom_Error, pstate, "error"),
+    SASS_MEMORY_NEW(Custom_Warning, pstate, "warning"),
+    SASS_MEMORY_NEW(Boolean, pstate, true),
+    SASS_MEMORY_NEW(String_Schema, pstate),
+    str,
+    SASS_MEMORY_NEW(String_Quoted, pstate, "\"a\""),
+    SASS_MEMORY_NEW(Null, pstate),
+    SASS_MEMORY_NEW(Parent_Reference, pstate),
+    SASS_MEMORY_NEW(Binary_Expression, pstate, Operand(Sass_OP::ADD), str, str),
+    SASS_MEMORY_NEW(Function_Call, pstate, sass::string("f"), args),
+    SASS_MEMORY_NEW(Variable, pstate, "$a"),
+    SASS_MEMORY_NEW(Unary_Expression, pstate, Unary_Expression::MINUS, str),
+    SASS_MEMORY_NEW(Argument, pstate, str),
+    args,
+    SASS_MEMORY_NEW(Media_Query, pstate),
+    SASS_MEMORY_NEW(Media_Query_Expression, pstate, str, str),
+    SASS_MEMORY_NEW(At_Root_Query, pstate),
+    SASS_MEMORY_NEW(SupportsCondition, pstate),
+    SASS_MEMORY_NEW(SupportsOperation, pstate, condition, condition, SupportsOperation::AND),
+    SASS_MEMORY_NEW(SupportsNegation, pstate, condition),
+    SASS_MEMORY_NEW(SupportsDeclaration, pstate, str, str),
+    condition,
+    SASS_MEMORY_NEW(PlaceholderSelector, pstate, "%a"),
+    SASS_MEMORY_NEW(TypeSelector, pstate, "a"),
+    SASS_MEMORY_NEW(ClassSelector, pstate, ".a"),
+    SASS_MEMORY_NEW(IDSelector, pstate, "#a"),
+    SASS_MEMORY_NEW(AttributeSelector, pstate, "a", "=", str),
+    SASS_MEMORY_NEW(PseudoSelector, pstate, "a"),
+    SASS_MEMORY_NEW(SelectorCombinator, pstate, SelectorCombinator::CHILD),
+    SASS_MEMORY_NEW(CompoundSelector, pstate),
+    SASS_MEMORY_NEW(ComplexSelector, pstate),
+    selector,
+    block,
+    SASS_MEMORY_NEW(StyleRule, pstate, selector, block),
+    SASS_MEMORY_NEW(Trace, pstate, "a", block),
+    SASS_MEMORY_NEW(AtRule, pstate, "@a"),
+    SASS_MEMORY_NEW(Keyframe_Rule, pstate, block),
+    SASS_MEMORY_NEW(Declaration, pstate, str, str),
+    SASS_MEMORY_NEW(If, pstate, str, block),
+    SASS_MEMORY_NEW(ForRule, pstate, "$i", str, str, block, true),
+    SASS_MEMORY_NEW(EachRule, pstate, sass::vector<sass::string>{ "$i" }, str, block),
+    SASS_MEMORY_NEW(WhileRule, pstate, str, block),
+    SASS_MEMORY_NEW(Definition, pstate, "f", params, block, Definition::FUNCTION),
+    SASS_MEMORY_NEW(Mixin_Call, pstate, "m", args),
+    SASS_MEMORY_NEW(MediaRule, pstate, block),
+    SASS_MEMORY_NEW(CssMediaRule, pstate, block),
+    SASS_MEMORY_NEW(AtRootRule, pstate, block),
+    SASS_MEMORY_NEW(SupportsRule, pstate, condition, block),
+    SASS_MEMORY_NEW(Bubble, pstate, block),
+    SASS_MEMORY_NEW(Assignment, pstate, "$a", str),
+    SASS_MEMORY_NEW(Import, pstate),
+    SASS_MEMORY_NEW(Import_Stub, pstate, Include({ "a", "." }, "a")),
+    SASS_MEMORY_NEW(WarningRule, pstate, str),
+    SASS_MEMORY_NEW(ErrorRule, pstate, str),
+    SASS_MEMORY_NEW(DebugRule, pstate, str),
+    SASS_MEMORY_NEW(Comment, pstate, str, false),
+    SASS_MEMORY_NEW(Return, pstate, str),
+    SASS_MEMORY_NEW(Content, pstate, args),
+    SASS_MEMORY_NEW(ExtendRule, pstate, selector),
+    SASS_MEMORY_NEW(CssMediaQuery, pstate),
+    SASS_MEMORY_NEW(Parameter, pstate, "$a"),
+    params,
+    SASS_MEMORY_NEW(Selector_Schema, pstate, schema),
+  };
+}
+
+bool TestEveryTagIsCovered() {
+  std::set<int> tags;
+  for (const AST_Node_Obj& node : every_node()) {
+    // one node of every class
+    ASSERT(tags.insert(node->tag()).second);
+    ASSERT(kAbstractTags.count(node->tag()) == 0);
+  }
+  // so both ends of every range and the tags next to them are
+  ASSERT(tags.size() + kAbstractTags.size() == size_t(AST_Node_Last) + 1);
+  return true;
+}
+
+bool TestCastsMatchDynamicCasts() {
+  for (const AST_Node_Obj& node : every_node()) {
+    ASSERT(casts_match(node.ptr(), AllClasses()));
+  }
+  // null stays null
+  ASSERT(Cast<Value>(static_cast<AST_Node*>(nullptr)) == nullptr);
+  return true;
+}
+
+}  // namespace
+
+#define TEST(fn) \
+  if (fn()) { \
+    passed.push_back(#fn); \
+  } else { \
+    failed.push_back(#fn); \
+    std::cerr << "Failed: " #fn << std::endl; \
+  } \
+
+int main(int argc, char **argv) {
+  std::vector<std::string> passed;
+  std::vector<std::string> failed;
+  TEST(TestEveryTagIsCovered);
+  TEST(TestCastsMatchDynamicCasts);
+  std::cerr << argv[0] << ": Passed: " << passed.size()
+            << ", failed: " << failed.size()
+            << "." << std::endl;
+  return failed.size();
+}
@@ -0,0 +1,629 @@
+#include "compile_fixture.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define ASSERT(cond) \
+  if (!(cond)) { \
+    std::cerr << "Assertion failed: " #cond " at " __FILE__ << ":" << __LINE__ << std::endl; \
+    return false; \
+  } \
+
+// Collects the chunks handed to the sink
+struct Streamed {
+  std::string output;
+  size_t chunks = 0;
+};
+
+// Appends every chunk to the `Streamed` in `cookie`
+void append_output(const char* data, size_t length, void* cookie) {
+  Streamed* streamed = static_cast<Streamed*>(cookie);
+  streamed->output.append(data, length);
+  streamed->chunks += 1;
+}
+
+// Compiles `source` with an embedded source map, either to the
+// output string or to a sink, and returns the output and map
+std::string compile_to_sink(const std::string& source, bool stream, size_t* chunks = nullptr) {
+  struct Sass_Data_Context* data_ctx = sass_make_data_context(sass_copy_c_string(source.c_str()));
+  struct Sass_Context* ctx = sass_data_context_get_context(data_ctx);
+  struct Sass_Options* options = sass_context_get_options(ctx);
+  sass_option_set_source_map_embed(options, true);
+  sass_option_set_source_map_file(options, "out.css.map");
+  Streamed streamed;
+  if (stream) {
+    sass_option_set_output_sink(options, append_output);
+    sass_option_set_output_sink_cookie(options, &streamed);
+  }
+  std::string result;
+  if (sass_compile_data_context(data_ctx) == 0) {
+    result = sass_context_get_output_string(ctx);
+    if (stream && !result.empty()) result = "ERROR: output string is not empty";
+    else result += streamed.output;
+    result += sass_context_get_source_map_string(ctx);
+  } else {
+    result = std::string("ERROR: ") + sass_context_get_error_message(ctx);
+  }
+  sass_delete_data_context(data_ctx);
+  if (chunks) *chunks = streamed.chunks;
+  return result;
+}
+
+// Returns rules that render to a few sink chunks
+std::string many_rules(const std::string& value) {
+  std::string source;
+  for (size_t i = 0; i < 8000; ++i) {
+    source += ".r-" + std::to_string(i) + " { a: " + value + "; b: " + std::to_string(i) + "px; }\n";
+  }
+  return source;
+}
+
+bool TestOutputSinkMatchesOutputString() {
+  // hoisted nodes and the charset go before everything else
+  const std::vector<std::string> sources = {
+    // known to be ascii from the sources
+    "/* first */\n@import url(first.css);\n" + many_rules("b"),
+    // the charset is known at the first char above 127
+    "/* first */\n" + many_rules("\"\xC3\xA9\""),
+    // an escape turns into a char above 127 at the end
+    many_rules("\"e\"") + ".last { a: \"\\e9\"; }\n",
+    // an import after the first output is still hoisted
+    "/* first */\n" + many_rules("b") + "@import url(last.css);\n",
+  };
+  std::vector<size_t> chunks;
+  for (const std::string& source : sources) {
+    const std::string expected = compile_to_sink(source, false);
+    ASSERT(expected.compare(0, 6, "ERROR:") != 0);
+    size_t count = 0;
+    ASSERT(compile_to_sink(source, true, &count) == expected);
+    chunks.push_back(count);
+  }
+  // handed off while rendering once the header is known
+  ASSERT(chunks[0] > 3);
+  ASSERT(chunks[1] > 3);
+  // otherwise the header and the rest at the end
+  ASSERT(chunks[2] <= 3);
+  ASSERT(chunks[3] <= 3);
+  return true;
+}
+
+// Compiles `source` in `style` with `linefeed` and returns
+// the output and the mappings of its source map
+std::string compile_styled(const std::string& source, enum Sass_Output_Style style, const char* linefeed) {
+  struct Sass_Data_Context* data_ctx = sass_make_data_context(sass_copy_c_string(source.c_str()));
+  struct Sass_Context* ctx = sass_data_context_get_context(data_ctx);
+  struct Sass_Options* options = sass_context_get_options(ctx);
+  sass_option_set_output_style(options, style);
+  sass_option_set_linefeed(options, linefeed);
+  sass_option_set_source_map_file(options, "out.css.map");
+  std::string result;
+  if (sass_compile_data_context(data_ctx) == 0) {
+    std::string srcmap = sass_context_get_source_map_string(ctx);
+    size_t start = srcmap.find("\"mappings\": \"");
+    size_t end = srcmap.find('"', start + 13);
+    result = sass_context_get_output_string(ctx);
+    if (start != std::string::npos) result += "|" + srcmap.substr(start + 13, end - start - 13);
+  } else {
+    result = std::string("ERROR: ") + sass_context_get_error_message(ctx);
+  }
+  sass_delete_data_context(data_ctx);
+  return result;
+}
+
+bool TestOutputHeaderIsJoinedAtTheEdges() {
+  // rendered by the releases that prepended the header to the output
+  const std::string url = "/*# sourceMappingURL=out.css.map */|";
+  const std::string late = "@import url(x.css);\na{b:\xC3\xA9}\n@import url(y.css);";
+  // nothing at all
+  ASSERT(compile_styled(" ", SASS_STYLE_NESTED, "\n") == "\n" + url);
+  ASSERT(compile_styled(" ", SASS_STYLE_COMPRESSED, "") == url);
+  // only hoisted output, with a body shorter than the linefeed
+  ASSERT(compile_styled("/* c */", SASS_STYLE_NESTED, "\r\n") == "/* c */\r\n\r\n" + url + "AAAA,OAAO");
+  ASSERT(compile_styled("/* c */", SASS_STYLE_NESTED, "") == "/* c */" + url + "AAAA,OAAO");
+  ASSERT(compile_styled("@import url(x.css);", SASS_STYLE_COMPRESSED, "\n")
+    == "@import url(x.css)\n\n" + url + "AAAA,OAAO,CAAC,UAAI");
+  // the charset for a char above 127 in the hoisted output only
+  ASSERT(compile_styled("/* \xC3\xBC */", SASS_STYLE_EXPANDED, "\n")
+    == "@charset \"UTF-8\";\n/* \xC3\xBC */\n\n" + url + ";AAAA,OAAO");
+  ASSERT(compile_styled("/* \xC3\xBC */", SASS_STYLE_EXPANDED, "")
+    == "@charset \"UTF-8\";/* \xC3\xBC */" + url + "iBAAA,OAAO");
+  ASSERT(compile_styled("/* \xC3\xBC */", SASS_STYLE_COMPRESSED, "\n") == "\n" + url);
+  // a late import goes before the body, the mappings follow it
+  ASSERT(compile_styled(late, SASS_STYLE_NESTED, "\r\n")
+    == "@charset \"UTF-8\";\r\n@import url(x.css);\r\n@import url(y.css);\r\na {\r\n  b: \xC3\xA9; }\r\n\r\n"
+       + url + ";AAAA,OAAO,CAAC,UAAI;AAEZ,OAAO,CAAC,UAAI;AADZ,AAAA,CAAC,CAAA;EAAC,CAAC,EAAC,CAAC,GAAC");
+  ASSERT(compile_styled(late, SASS_STYLE_EXPANDED, "")
+    == "@charset \"UTF-8\";@import url(x.css);@import url(y.css);a {  b: \xC3\xA9;}"
+       + url + "iBAAA,OAAO,CAAC,UAAI,CAEZ,OAAO,CAAC,UAAI,CADZ,AAAA,CAAC,CAAA,GAAC,CAAC,EAAC,CAAC,EAAC");
+  // the byte order mark is not mapped
+  ASSERT(compile_styled(late, SASS_STYLE_COMPRESSED, "\n")
+    == "\xEF\xBB\xBF@import url(x.css);@import url(y.css);a{b:\xC3\xA9}\n\n"
+       + url + "AAAA,OAAO,CAAC,UAAI,CAEZ,OAAO,CAAC,UAAI,CADZ,AAAA,CAAC,AAAA,CAAC,CAAC,CAAC,CAAC,CAAC");
+  return true;
+}
+
+// Returns a generated stylesheet together with its source map
+Sass_Import_List import_generated(const char* url, Sass_Importer_Entry cb, struct Sass_Compiler* comp) {
+  if (std::strcmp(url, "gen") != 0) return nullptr;
+  const char* source = ".gen {\n  color: red;\n  width: 1px; }\n";
+  // lines 1 and 2 map to lines 11 and 12 of the original, line 3 is unmapped
+  const char* srcmap = "{\"version\":3,\"sourceRoot\":\"webpack:///src\","
+    "\"sources\":[\"gen.ts\"],\"sourcesContent\":[\"original\"],"
+    "\"names\":[],\"mappings\":\"AAUI;EACE\"}";
+  Sass_Import_List list = sass_make_import_list(1);
+  list[0] = sass_make_import("gen", "/virtual/gen.scss",
+    sass_copy_c_string(source), sass_copy_c_string(srcmap));
+  return list;
+}
+
+bool TestInputSourceMapsAreComposed() {
+  const char* source = "@import \"gen\";\n.own { a: b; }\n";
+  struct Sass_Data_Context* data_ctx = sass_make_data_context(sass_copy_c_string(source));
+  struct Sass_Context* ctx = sass_data_context_get_context(data_ctx);
+  struct Sass_Options* options = sass_context_get_options(ctx);
+  Sass_Importer_List importers = sass_make_importer_list(1);
+  sass_importer_set_list_entry(importers, 0, sass_make_importer(import_generated, 0, nullptr));
+  sass_option_set_c_importers(options, importers);
+  sass_option_set_source_map_file(options, "out.css.map");
+  sass_option_set_source_map_contents(options, true);
+  ASSERT(sass_compile_data_context(data_ctx) == 0);
+  std::string srcmap = sass_context_get_source_map_string(ctx);
+  sass_delete_data_context(data_ctx);
+  // the original source is listed after ours
+  ASSERT(srcmap.find("\t\t\"webpack:///src/gen.ts\"\n\t]") != std::string::npos);
+  ASSERT(srcmap.find("\t\t\"original\"\n\t]") != std::string::npos);
+  // the unmapped line still points to the generated one
+  ASSERT(srcmap.find("\"mappings\": \"AEUI,AAAA,IAAA,CAAA;EACE,KAAA,EAAA,GAAA;EDTJ,") != std::string::npos);
+  return true;
+}
+
+// Names that need escaping, around the eight bytes skipped at once
+const std::vector<std::string> kOddNames = {
+  "q\"uote.scss", "back\\slash.scss", "tab\tnl\ncr\rbs\bff\f.scss",
+  "ctl\x01\x1E\x1F\x7F.scss", "sp ace \xC3\xA9\xE2\x82\xAC.scss",
+  "1234567\".scss", "12345678\\.scss", "123456789\n.scss", "\"\"\"\"\"\"\"\"\"",
+};
+
+// Imports `odd-<index>` from a file named like the odd name at index
+Sass_Import_List import_odd_name(const char* url, Sass_Importer_Entry cb, struct Sass_Compiler* comp) {
+  if (std::strncmp(url, "odd-", 4) != 0) return nullptr;
+  const std::string& cwd = *static_cast<std::string*>(sass_importer_get_cookie(cb));
+  size_t index = std::stoul(url + 4);
+  std::string source = ".odd-" + std::to_string(index) + " { a: b; }\n";
+  std::string path = cwd + "/" + (index < kOddNames.size() ? kOddNames[index] : "bad\xC3(utf8.scss");
+  Sass_Import_List list = sass_make_import_list(1);
+  list[0] = sass_make_import(url, path.c_str(), sass_copy_c_string(source.c_str()), nullptr);
+  return list;
+}
+
+// Compiles `source` with odd file names and returns the source map
+std::string compile_odd_names(const std::string& source, const std::string& root) {
+  char buffer[4096];
+  std::string cwd = getcwd(buffer, sizeof(buffer)) ? buffer : "";
+  struct Sass_Data_Context* data_ctx = sass_make_data_context(sass_copy_c_string(source.c_str()));
+  struct Sass_Context* ctx = sass_data_context_get_context(data_ctx);
+  struct Sass_Options* options = sass_context_get_options(ctx);
+  Sass_Importer_List importers = sass_make_importer_list(1);
+  sass_importer_set_list_entry(importers, 0, sass_make_importer(import_odd_name, 0, &cwd));
+  sass_option_set_c_importers(options, importers);
+  sass_option_set_source_map_file(options, "out.css.map");
+  sass_option_set_source_map_root(options, root.c_str());
+  std::string result;
+  if (sass_compile_data_context(data_ctx) == 0) {
+    result = sass_context_get_source_map_string(ctx);
+  } else {
+    result = std::string("ERROR: ") + sass_context_get_error_message(ctx);
+  }
+  sass_delete_data_context(data_ctx);
+  return result;
+}
+
+bool TestSourceMapEscapesSourceNames() {
+  std::string source;
+  for (size_t i = 0; i < kOddNames.size(); ++i) {
+    source += "@import 'odd-" + std::to_string(i) + "';\n";
+  }
+  std::string srcmap = compile_odd_names(source, kOddNames[2]);
+  // escaped like the json tree did, 0x1F and above as they are
+  ASSERT(srcmap.find("\t\"sourceRoot\": \"tab\\tnl\\ncr\\rbs\\bff\\f.scss\",\n") != std::string::npos);
+  ASSERT(srcmap.find("\t\"sources\": [\n"
+    "\t\t\"stdin\",\n"
+    "\t\t\"q\\\"uote.scss\",\n"
+    "\t\t\"back\\\\slash.scss\",\n"
+    "\t\t\"tab\\tnl\\ncr\\rbs\\bff\\f.scss\",\n"
+    "\t\t\"ctl\\u0001\\u001E\x1F\x7F.scss\",\n"
+    "\t\t\"sp ace \xC3\xA9\xE2\x82\xAC.scss\",\n"
+    "\t\t\"1234567\\\".scss\",\n"
+    "\t\t\"12345678\\\\.scss\",\n"
+    "\t\t\"123456789\\n.scss\",\n"
+    "\t\t\"\\\"\\\"\\\"\\\"\\\"\\\"\\\"\\\"\\\"\"\n"
+    "\t],\n") != std::string::npos);
+  // invalid utf8 is still reported
+  ASSERT(compile_odd_names("@import 'odd-99';\n", "") == "ERROR: Internal Error: Invalid UTF-8\n");
+  return true;
+}
+
+// Compiles the file at `path` in `session` and returns
+// the output or the formatted error message
+std::string compile_session(struct Sass_Session* session, const std::string& path) {
+  struct Sass_File_Context* file_ctx = sass_make_file_context(path.c_str());
+  struct Sass_Context* ctx = sass_file_context_get_context(file_ctx);
+  std::string result;
+  if (sass_session_compile_file_context(session, file_ctx) == 0) {
+    result = sass_context_get_output_string(ctx);
+  } else {
+    result = std::string("ERROR: ") + sass_context_get_error_message(ctx);
+  }
+  sass_delete_file_context(file_ctx);
+  return result;
+}
+
+bool TestSessionRecompilesChangedFiles() {
+  Files files = {
+    { "_vars.scss", "$c: red;\n" },
+    { "_other.scss", "$d: blue;\n" },
+    { "one.scss", "@import 'vars';\n.one { color: $c; }\n" },
+    { "two.scss", "@import 'other';\n.two { color: $d; }\n" },
+  };
+  std::string dir = write_files(files);
+  ASSERT(!dir.empty());
+  const std::vector<std::string> entries = { dir + "/one.scss", dir + "/two.scss" };
+  struct Sass_Session* session = sass_make_session(100);
+  std::atomic<size_t> mismatches(0);
+  // compiles every entry point on every thread
+  auto compile_all = [&](const std::string& one, const std::string& two) {
+    run_threads([&](size_t index) {
+      for (size_t i = 0; i < entries.size(); ++i) {
+        std::string output = compile_session(session, entries[(i + index) % 2]);
+        if (output.find((i + index) % 2 ? two : one) == std::string::npos) ++mismatches;
+      }
+    });
+  };
+
+  ASSERT(compile_session(session, entries[0]).find("color: red") != std::string::npos);
+  ASSERT(compile_session(session, entries[1]).find("color: blue") != std::string::npos);
+  compile_all("color: red", "color: blue");
+  ASSERT(sass_session_get_compiled(session) == 2);
+  ASSERT(sass_session_get_reused(session) == 2 * kThreads);
+
+  // only the entry point importing it compiles again
+  std::ofstream(dir + "/_vars.scss") << "$c: green;\n";
+  sass_session_file_changed(session, (dir + "/_vars.scss").c_str());
+  ASSERT(compile_session(session, entries[0]).find("color: green") != std::string::npos);
+  ASSERT(compile_session(session, entries[1]).find("color: blue") != std::string::npos);
+  ASSERT(sass_session_get_compiled(session) == 3);
+
+  // a new file makes the import ambiguous
+  std::ofstream(dir + "/other.scss") << "$d: black;\n";
+  sass_session_file_changed(session, (dir + "/other.scss").c_str());
+  ASSERT(compile_session(session, entries[1]).compare(0, 6, "ERROR:") == 0);
+  unlink((dir + "/other.scss").c_str());
+  sass_session_file_changed(session, (dir + "/other.scss").c_str());
+  ASSERT(compile_session(session, entries[0]).find("color: green") != std::string::npos);
+  ASSERT(compile_session(session, entries[1]).find("color: blue") != std::string::npos);
+  compile_all("color: green", "color: blue");
+  ASSERT(sass_session_get_compiled(session) == 6);
+
+  sass_delete_session(session);
+  remove_files(dir, files);
+  ASSERT(mismatches == 0);
+  return true;
+}
+
+bool TestBatchCompilerCompilesAllEntries() {
+  Files files = {
+    { "_vars.scss", "$c: red;\n@function twice($x) { @return $x * 2; }\n" },
+    { "broken.scss", "@import 'vars';\na { b: $missing; }\n" },
+  };
+  for (size_t i = 0; i < 40; ++i) {
+    files.push_back({ "entry-" + std::to_string(i) + ".scss",
+      "@import 'vars';\n.e-" + std::to_string(i) + " { color: $c; width: twice(" +
+      std::to_string(i) + "px); id: answer(); }\n" });
+  }
+  std::string dir = write_files(files);
+  ASSERT(!dir.empty());
+  std::vector<std::string> paths;
+  std::vector<const char*> entries;
+  for (const auto& file : files) {
+    if (file.first[0] != '_') paths.push_back(dir + "/" + file.first);
+  }
+  for (const std::string& path : paths) {
+    entries.push_back(path.c_str());
+  }
+  struct Sass_Options* options = sass_make_options();
+  size_t answer = 42;
+  Sass_Function_List fn_list = sass_make_function_list(1);
+  sass_function_set_list_entry(fn_list, 0, sass_make_function("answer()", cookie_number, &answer));
+  sass_option_set_c_functions(options, fn_list);
+  sass_option_set_output_path(options, "out.css");
+  sass_option_set_source_map_file(options, "out.css.map");
+  struct Sass_Batch_Compiler* batch = sass_make_batch_compiler(entries.data(), entries.size(), options);
+  ASSERT(sass_batch_compiler_get_count(batch) == entries.size());
+  ASSERT(sass_batch_compiler_get_context(batch, entries.size()) == nullptr);
+  size_t failed = sass_batch_compiler_execute(batch, 4);
+  size_t mismatches = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    struct Sass_File_Context* file_ctx = sass_batch_compiler_get_context(batch, i);
+    struct Sass_Context* ctx = sass_file_context_get_context(file_ctx);
+    if (i == 0) {
+      if (sass_context_get_error_status(ctx) == 0) ++mismatches;
+      continue;
+    }
+    std::string suffix = std::to_string(i - 1);
+    std::string expected = ".e-" + suffix + " {\n  color: red;\n  width: " +
+      std::to_string(2 * (i - 1)) + "px;\n  id: 42; }\n";
+    std::string output = sass_context_get_output_string(ctx);
+    if (output.compare(0, expected.size(), expected) != 0) ++mismatches;
+    if (!sass_context_get_source_map_string(ctx)) ++mismatches;
+    if (sass_context_get_included_files_size(ctx) != 2) ++mismatches;
+  }
+  sass_delete_batch_compiler(batch);
+  remove_files(dir, files);
+  ASSERT(failed == 1);
+  ASSERT(mismatches == 0);
+  return true;
+}
+
+bool TestBatchCompilerSharesSheetsBetweenThreads() {
+  Files files = {
+    { "_a.scss", "$a: 1px;\n" },
+    { "_b.scss", "@mixin b($x) { b: $x; }\n" },
+  };
+  const size_t count = 200;
+  for (size_t i = 0; i < count; ++i) {
+    files.push_back({ "entry-" + std::to_string(i) + ".scss",
+      "@import 'a', 'b';\n.e { @include b($a * " + std::to_string(i) + "); }\n" });
+  }
+  std::string dir = write_files(files);
+  ASSERT(!dir.empty());
+  std::vector<std::string> paths;
+  std::vector<const char*> entries;
+  for (size_t i = 0; i < count; ++i) {
+    paths.push_back(dir + "/entry-" + std::to_string(i) + ".scss");
+  }
+  for (const std::string& path : paths) {
+    entries.push_back(path.c_str());
+  }
+  size_t mismatches = 0;
+  for (int threads : { 1, 4, 16 }) {
+    struct Sass_Stylesheet_Cache* cache = sass_make_stylesheet_cache(1000);
+    struct Sass_Options* options = sass_make_options();
+    sass_option_set_stylesheet_cache(options, cache);
+    struct Sass_Batch_Compiler* batch = sass_make_batch_compiler(entries.data(), entries.size(), options);
+    if (sass_batch_compiler_execute(batch, threads) != 0) ++mismatches;
+    for (size_t i = 0; i < count; ++i) {
+      struct Sass_Context* ctx = sass_file_context_get_context(sass_batch_compiler_get_context(batch, i));
+      std::string expected = ".e {\n  b: " + std::to_string(i) + "px; }\n";
+      if (expected != sass_context_get_output_string(ctx)) ++mismatches;
+    }
+    sass_delete_batch_compiler(batch);
+    // every entry point misses once, the partials at most once per thread
+    size_t hits = sass_stylesheet_cache_get_hits(cache);
+    size_t misses = sass_stylesheet_cache_get_misses(cache);
+    if (hits + misses != 3 * count) ++mismatches;
+    if (hits < 2 * count - 2 * threads) ++mismatches;
+    sass_delete_stylesheet_cache(cache);
+  }
+  remove_files(dir, files);
+  ASSERT(mismatches == 0);
+  return true;
+}
+
+bool TestMapMergeKeepsOriginalKeys() {
+  // equal keys keep the first spelling, but get the new value
+  ASSERT(compile("a { b: inspect(map-merge((a: 1), (\"a\": 2))); }") == "a {\n  b: (a: 2); }\n");
+  ASSERT(compile("a { b: inspect(map-keys(map-merge((a: 1), (\"a\": 2)))); }") == "a {\n  b: (a,); }\n");
+  ASSERT(compile("a { b: inspect(map-merge((#f00: 1), (red: 2))); }") == "a {\n  b: (#f00: 2); }\n");
+  ASSERT(compile("a { b: inspect(map-merge((\"a\": 1, b: 2), (a: 3, c: 4))); }") == "a {\n  b: (\"a\": 3, b: 2, c: 4); }\n");
+  return true;
+}
+
+bool TestSharedListsStayIndependent() {
+  // appending to the old and the new list after append
+  ASSERT(compile(
+    "$a: 1 2 3;\n"
+    "$b: append($a, 4);\n"
+    "$c: append($a, 5);\n"
+    "$d: append($b, 6);\n"
+    "$e: append($b, 7);\n"
+    "x { a: $a; b: $b; c: $c; d: $d; e: $e; }\n") ==
+    "x {\n  a: 1 2 3;\n  b: 1 2 3 4;\n  c: 1 2 3 5;\n  d: 1 2 3 4 6;\n  e: 1 2 3 4 7; }\n");
+  // and after join, also with the list itself
+  ASSERT(compile(
+    "$a: 1, 2;\n"
+    "$b: join($a, (3, 4));\n"
+    "$c: join($a, $a);\n"
+    "$d: append($b, 5);\n"
+    "$e: join($b, 6);\n"
+    "$a: append($a, 7);\n"
+    "x { a: $a; b: $b; c: $c; d: $d; e: $e; }\n") ==
+    "x {\n  a: 1, 2, 7;\n  b: 1, 2, 3, 4;\n  c: 1, 2, 1, 2;\n  d: 1, 2, 3, 4, 5;\n  e: 1, 2, 3, 4, 6; }\n");
+  // values kept from a loop that extends the same list
+  ASSERT(compile(
+    "$list: ();\n"
+    "$kept: ();\n"
+    "@for $i from 1 through 4 {\n"
+    "  $list: append($list, $i);\n"
+    "  @if $i == 2 { $kept: $list; }\n"
+    "}\n"
+    "$kept: append($kept, x);\n"
+    "$list: append($list, y);\n"
+    "x { list: $list; kept: $kept; n: length($kept) nth($list, 3); }\n") ==
+    "x {\n  list: 1 2 3 4 y;\n  kept: 1 2 x;\n  n: 3 3; }\n");
+  return true;
+}
+
+bool TestExtendTrimsLongSelectorLists() {
+  // every rule gets 121 selectors, which used to skip trimming
+  const std::string loop = "@for $i from 1 through 60 { ";
+  // indexed by a simple selector of the last compound
+  ASSERT(compile(
+    ".a .b { x: y; }\n" +
+    loop + ".c#{$i} .d { @extend .b; } }\n"
+    ".a .d { @extend .b; }\n") ==
+    ".a .b, .a .d {\n  x: y; }\n");
+  // a selector pseudo as superselector can't be indexed
+  ASSERT(compile(
+    ".p .q { x: y; }\n" +
+    loop + ".c#{$i} .e { @extend .q; } }\n"
+    ".p :matches(.d, .e) { @extend .q; }\n") ==
+    ".p .q, .p :matches(.d, .e) {\n  x: y; }\n");
+  // a selector pseudo as subselector, trailing combinators and :not()
+  ASSERT(compile(
+    ".r .s { x: y; }\n" +
+    loop + ".c#{$i} :matches(.t) { @extend .s; } }\n"
+    ".r .t { @extend .s; }\n"
+    ".r :not(.u) { @extend .s; }\n"
+    ".f > { @extend .s; }\n"
+    ".r .g ~ { @extend .s; }\n") ==
+    ".r .s, .r .g ~, .r .f >, .f .r >, .r :not(.u), .r .t {\n  x: y; }\n");
+  return true;
+}
+
+bool TestRedeclaredDefinitionsAreCalled() {
+  // the call sites in the loop are evaluated again after redeclarations
+  const std::string uses =
+    "@mixin use { @for $i from 1 through 2 { v#{$i}: f($i); @include m; } }\n";
+  ASSERT(compile(uses +
+    "@function f($i) { @return $i; }\n"
+    "@mixin m { m: 1; }\n"
+    "a { @include use; }\n"
+    "@function f($i) { @return -$i; }\n"
+    "b { @include use; }\n"
+    "@mixin m { m: 2; }\n"
+    "c { @include use; }\n") ==
+    "a {\n  v1: 1;\n  m: 1;\n  v2: 2;\n  m: 1; }\n\n"
+    "b {\n  v1: -1;\n  m: 1;\n  v2: -2;\n  m: 1; }\n\n"
+    "c {\n  v1: -1;\n  m: 2;\n  v2: -2;\n  m: 2; }\n");
+  // nested declarations shadow the global ones only in their scope
+  ASSERT(compile(uses +
+    "@function f($i) { @return global; }\n"
+    "@mixin m { m: global; }\n"
+    ".a { @include use; b: f(0);\n"
+    "  @function f($i) { @return nested; }\n"
+    "  @mixin m { m: nested; }\n"
+    "  @for $i from 1 through 2 { c#{$i}: f($i); @include m; }\n"
+    "  .d { e: f(0); @include m; @include use; }\n"
+    "}\n"
+    ".g { h: f(0); @include m; }\n") ==
+    ".a {\n  v1: global;\n  m: global;\n  v2: global;\n  m: global;\n  b: global;\n"
+    "  c1: nested;\n  m: nested;\n  c2: nested;\n  m: nested; }\n"
+    "  .a .d {\n    e: nested;\n    m: nested;\n"
+    "    v1: global;\n    m: global;\n    v2: global;\n    m: global; }\n\n"
+    ".g {\n  h: global;\n  m: global; }\n");
+  return true;
+}
+
+bool TestMappedSourceFilesMatchRead() {
+  // large enough to be mapped if asked to
+  std::string large;
+  for (size_t i = 0; i < 4000; ++i) {
+    large += ".l-" + std::to_string(i) + " { a: b; }\n";
+  }
+  Files files = { { "_large.scss", large } };
+  std::string dir = write_files(files);
+  ASSERT(!dir.empty());
+  std::string outputs[2];
+  for (int map = 0; map < 2; ++map) {
+    struct Sass_Data_Context* data_ctx = sass_make_data_context(sass_copy_c_string("@import 'large';\n"));
+    struct Sass_Context* ctx = sass_data_context_get_context(data_ctx);
+    struct Sass_Options* options = sass_context_get_options(ctx);
+    sass_option_set_include_path(options, dir.c_str());
+    sass_option_set_source_map_file(options, "out.css.map");
+    sass_option_set_source_map_contents(options, true);
+    sass_option_set_map_source_files(options, map == 1);
+    if (sass_compile_data_context(data_ctx) == 0) {
+      outputs[map] = sass_context_get_output_string(ctx);
+      outputs[map] += sass_context_get_source_map_string(ctx);
+    }
+    sass_delete_data_context(data_ctx);
+  }
+  remove_files(dir, files);
+  ASSERT(outputs[0].find(".l-3999") != std::string::npos);
+  ASSERT(outputs[0] == outputs[1]);
+  return true;
+}
+
+bool TestCompilerReportsArenaStatistics() {
+  struct Sass_Data_Context* data_ctx = sass_make_data_context(sass_copy_c_string("a { b: c; }\n"));
+  struct Sass_Compiler* compiler = sass_make_data_compiler(data_ctx);
+  ASSERT(sass_compiler_parse(compiler) == 0);
+  ASSERT(sass_compiler_execute(compiler) == 0);
+  size_t bytes = sass_compiler_get_alloc_bytes(compiler);
+  size_t peak = sass_compiler_get_alloc_peak(compiler);
+  size_t arenas = sass_compiler_get_alloc_arenas(compiler);
+  sass_delete_compiler(compiler);
+  sass_delete_data_context(data_ctx);
+#ifdef SASS_CUSTOM_ALLOCATOR
+  ASSERT(bytes > 0);
+  ASSERT(peak >= bytes);
+  ASSERT(arenas > 0);
+#else
+  ASSERT(bytes == 0 && peak == 0 && arenas == 0);
+#endif
+  return true;
+}
+
+bool TestCachedSheetsOutliveCompilers() {
+  // parsed maps and lists are read and extended by every compilation
+  Files files = {
+    { "_lib.scss",
+      "$map: (a: 1, b: 2);\n"
+      "$list: 1 2;\n"
+      "@mixin m { @each $k, $v in $map { #{$k}: $v; } }\n" },
+    { "_use.scss",
+      "@import 'lib';\n"
+      ".u { @include m; k: map-keys($map); l: append($list, 3); }\n" },
+    { "_bad.scss", "\n.b { c: $undefined; }\n" },
+  };
+  std::string dir = write_files(files);
+  ASSERT(!dir.empty());
+  struct Sass_Stylesheet_Cache* cache = sass_make_stylesheet_cache(8);
+  std::vector<std::string> outputs, errors;
+  for (int i = 0; i < 4; ++i) {
+    outputs.push_back(compile_imports("@import 'use';\n.x { y: length(append($list, 3)); }\n", dir, i % 2 * 2, cache));
+    errors.push_back(compile_imports("@import 'bad';\n", dir, 0, cache));
+  }
+  sass_delete_stylesheet_cache(cache);
+  remove_files(dir, files);
+  ASSERT(outputs[0].find(".u {\n  a: 1;\n  b: 2;\n  k: a, b;\n  l: 1 2 3; }\n\n.x {\n  y: 3; }\n") == 0);
+  ASSERT(errors[0].find("ERROR: Error: Undefined variable: \"$undefined\".\n        on line 2:9 of ") == 0);
+  for (int i = 1; i < 4; ++i) {
+    ASSERT(outputs[i] == outputs[0]);
+    ASSERT(errors[i] == errors[0]);
+  }
+  return true;
+}
+
+#define TEST(fn) \
+  if (fn()) { \
+    passed.push_back(#fn); \
+  } else { \
+    failed.push_back(#fn); \
+    std::cerr << "Failed: " #fn << std::endl; \
+  } \
+
+int main(int argc, char **argv) {
+  std::vector<std::string> passed;
+  std::vector<std::string> failed;
+  TEST(TestOutputSinkMatchesOutputString);
+  TEST(TestOutputHeaderIsJoinedAtTheEdges);
+  TEST(TestInputSourceMapsAreComposed);
+  TEST(TestSourceMapEscapesSourceNames);
+  TEST(TestSessionRecompilesChangedFiles);
+  TEST(TestBatchCompilerCompilesAllEntries);
+  TEST(TestBatchCompilerSharesSheetsBetweenThreads);
+  TEST(TestMapMergeKeepsOriginalKeys);
+  TEST(TestMappedSourceFilesMatchRead);
+  TEST(TestRedeclaredDefinitionsAreCalled);
+  TEST(TestSharedListsStayIndependent);
+  TEST(TestExtendTrimsLongSelectorLists);
+  TEST(TestCompilerReportsArenaStatistics);
+  TEST(TestCachedSheetsOutliveCompilers);
+  std::cerr << argv[0] << ": Passed: " << passed.size()
+            << ", failed: " << failed.size()
+            << "." << std::endl;
+  return failed.size();
+}
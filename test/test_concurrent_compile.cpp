@@ -0,0 +1,242 @@
+#include "compile_fixture.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define ASSERT(cond) \
+  if (!(cond)) { \
+    std::cerr << "Assertion failed: " #cond " at " __FILE__ << ":" << __LINE__ << std::endl; \
+    return false; \
+  } \
+
+namespace {
+
+const size_t kRounds = 8;
+
+// Exercises most evaluation paths that touch shared state
+const std::vector<std::string> corpus = {
+  "$c: #336699;\n"
+  "@function shade($i) { @return mix(black, $c, $i * 5%); }\n"
+  "@for $i from 1 through 20 { .s-#{$i} { color: shade($i); bg: rgba($c, $i / 20); } }\n",
+
+  "@mixin box($w, $rest...) { width: $w; margin: $rest; @content; }\n"
+  "$sizes: (sm: 10px, md: 20px, lg: 40px);\n"
+  "@each $name, $size in $sizes { .b-#{$name} { @include box($size, 1px, 2px) { x: y; } } }\n"
+  "a { b: map-get(map-merge($sizes, (xl: 80px)), xl); c: length(1 2 3); }\n",
+
+  ".a { color: red; } .b { @extend .a; } %p { d: e; } .c .d { @extend %p; }\n"
+  ".e:not(.a) { f: g; } .h { @extend .e; }\n",
+
+  "a { b: str-slice(\"hello world\", 1, 5); c: to-upper-case(abc); d: str-index(abc, c);\n"
+  "    e: quote(x); f: percentage(.25); g: round(2.5); h: nth(1 2 3, -1); i: join(1 2, 3 4); }\n",
+
+  "@function fib($n) { @if $n < 2 { @return $n; } @return fib($n - 1) + fib($n - 2); }\n"
+  "a { b: fib(12); c: if(true, 1, 2); d: call(get-function(fib), 8); e: function-exists(fib); }\n",
+
+  "@media screen { .a { b: c; @media (min-width: 10px) { d: e; } } }\n"
+  "@supports (display: grid) { .f { g: h; } }\n"
+  "/* comment */ .i { j: k !important; }\n",
+};
+
+}  // namespace
+
+bool TestConcurrentOutputIsDeterministic() {
+  std::vector<std::string> expected;
+  for (const std::string& source : corpus) {
+    expected.push_back(compile(source));
+    ASSERT(expected.back().compare(0, 6, "ERROR:") != 0);
+  }
+  std::atomic<size_t> mismatches(0);
+  run_threads([&](size_t index) {
+    for (size_t round = 0; round < kRounds; ++round) {
+      for (size_t i = 0; i < corpus.size(); ++i) {
+        // start each thread on a different source
+        size_t n = (i + index) % corpus.size();
+        if (compile(corpus[n]) != expected[n]) ++mismatches;
+      }
+    }
+  });
+  ASSERT(mismatches == 0);
+  return true;
+}
+
+bool TestConcurrentRandomFunctions() {
+  std::atomic<size_t> failures(0);
+  run_threads([&](size_t index) {
+    for (size_t round = 0; round < kRounds; ++round) {
+      std::string css = compile("a { b: random(); c: random(100); d: unique-id(); }");
+      if (css.find("d: u") == std::string::npos) ++failures;
+    }
+  });
+  ASSERT(failures == 0);
+  return true;
+}
+
+bool TestConcurrentCustomFunctions() {
+  std::atomic<size_t> failures(0);
+  run_threads([&](size_t index) {
+    std::string expected = "a {\n  b: " + std::to_string(index) + "; }\n";
+    for (size_t round = 0; round < kRounds; ++round) {
+      // the entry is owned and deleted by the context
+      Sass_Function_Entry fn = sass_make_function("thread-id()", cookie_number, &index);
+      if (compile("a { b: thread-id(); }", fn) != expected) ++failures;
+    }
+  });
+  ASSERT(failures == 0);
+  return true;
+}
+
+bool TestImportThreadsMatchSequential() {
+  Files files = {
+    { "_vars.scss", "$c: red;\n@function double($n) { @return $n * 2; }\n" },
+    { "_base.scss", "@import 'vars';\nbody { color: $c; }\n" },
+    { "_grid.scss", "@import 'vars', 'base';\n@for $i from 1 through 3 { .col-#{$i} { width: double($i) * 10%; } }\n" },
+    { "_nested.scss", ".n { @import 'vars'; a: $c; }\n" },
+    { "_mixed.scss", "@import 'a.css', 'grid', url(x.css);\n.m { b: c; }\n" },
+    { "_broken.scss", ".b { color: ; }\n" },
+    { "_missing.scss", "@import 'does-not-exist';\n" },
+    { "_cycle.scss", "@import 'cycle';\n" },
+  };
+  std::string dir = write_files(files);
+  ASSERT(!dir.empty());
+  const std::vector<std::string> sources = {
+    "@import 'grid';\n@import 'nested', 'mixed';\n.x { y: $c; }\n",
+    "@import 'vars';\n.a { @import 'grid'; }\n@import 'base';\n",
+    "@import 'vars';\n@import 'broken';\n",
+    "@import 'base';\n@import 'missing';\n",
+    "@import 'cycle';\n",
+  };
+  std::vector<std::string> expected;
+  for (const std::string& source : sources) {
+    expected.push_back(compile_imports(source, dir, 0));
+  }
+  ASSERT(expected[0].find(".col-3") != std::string::npos);
+  ASSERT(expected[2].compare(0, 6, "ERROR:") == 0);
+  ASSERT(expected[3].compare(0, 6, "ERROR:") == 0);
+  ASSERT(expected[4].compare(0, 6, "ERROR:") == 0);
+  std::atomic<size_t> mismatches(0);
+  run_threads([&](size_t index) {
+    for (size_t round = 0; round < kRounds; ++round) {
+      for (size_t i = 0; i < sources.size(); ++i) {
+        size_t n = (i + index) % sources.size();
+        if (compile_imports(sources[n], dir, 4) != expected[n]) ++mismatches;
+      }
+    }
+  });
+  remove_files(dir, files);
+  ASSERT(mismatches == 0);
+  return true;
+}
+
+bool TestStylesheetCacheSharedBetweenThreads() {
+  Files files = {
+    { "_vars.scss", "$c: red;\n@function double($n) { @return $n * 2; }\n" },
+    { "_base.scss", "@import 'vars';\nbody { color: $c; }\n" },
+    { "_grid.scss", "@import 'vars', 'base';\n@for $i from 1 through 3 { .col-#{$i} { width: double($i) * 10%; } }\n" },
+    { "_ext.scss", "%p { d: e; }\n.a { @extend %p; }\n#{'.s'} { @extend .a; }\n" },
+    { "_map.scss", "$m: (a: 1, b: 2);\n.m { b: map-get(map-merge($m, (c: 3)), c); }\n" },
+    { "_broken.scss", ".b { color: ; }\n" },
+  };
+  std::string dir = write_files(files);
+  ASSERT(!dir.empty());
+  const std::vector<std::string> sources = {
+    "@import 'grid';\n.x { y: $c; }\n",
+    "@import 'vars';\n.a { @import 'grid'; }\n@import 'ext';\n",
+    "@import 'map', 'ext';\n@import 'base';\n",
+    "@import 'vars';\n@import 'broken';\n",
+  };
+  std::vector<std::string> expected;
+  for (const std::string& source : sources) {
+    expected.push_back(compile_imports(source, dir, 0));
+  }
+  ASSERT(expected[3].compare(0, 6, "ERROR:") == 0);
+  // small enough to evict sheets now and then
+  struct Sass_Stylesheet_Cache* cache = sass_make_stylesheet_cache(6);
+  std::atomic<size_t> mismatches(0);
+  run_threads([&](size_t index) {
+    for (size_t round = 0; round < kRounds; ++round) {
+      for (size_t i = 0; i < sources.size(); ++i) {
+        size_t n = (i + index) % sources.size();
+        if (compile_imports(sources[n], dir, index % 2 ? 2 : 0, cache) != expected[n]) ++mismatches;
+      }
+    }
+  });
+  size_t hits = sass_stylesheet_cache_get_hits(cache);
+  size_t size = sass_stylesheet_cache_get_size(cache);
+  sass_delete_stylesheet_cache(cache);
+  remove_files(dir, files);
+  ASSERT(mismatches == 0);
+  ASSERT(hits > 0);
+  ASSERT(size <= 6);
+  return true;
+}
+
+bool TestDirectoryCacheSharedBetweenThreads() {
+  Files files = {
+    { "_vars.scss", "$c: red;\n" },
+    { "base.scss", "@import 'vars';\nbody { color: $c; }\n" },
+    { "_both.scss", "a { b: c; }\n" },
+    { "both.scss", "a { b: d; }\n" },
+    { "plain.css", ".p { q: r; }\n" },
+  };
+  std::string dir = write_files(files);
+  ASSERT(!dir.empty());
+  const std::vector<std::string> sources = {
+    "@import 'base';\n.x { y: $c; }\n",
+    "@import 'plain', 'vars';\n.a { b: $c; }\n",
+    "@import 'both';\n",
+    "@import 'missing';\n",
+  };
+  std::vector<std::string> expected;
+  for (const std::string& source : sources) {
+    expected.push_back(compile_imports(source, dir, 0));
+  }
+  ASSERT(expected[0].find("color: red") != std::string::npos);
+  ASSERT(expected[1].find(".p") != std::string::npos);
+  ASSERT(expected[2].compare(0, 6, "ERROR:") == 0);
+  ASSERT(expected[3].compare(0, 6, "ERROR:") == 0);
+  struct Sass_Directory_Cache* listings = sass_make_directory_cache();
+  std::atomic<size_t> mismatches(0);
+  run_threads([&](size_t index) {
+    for (size_t round = 0; round < kRounds; ++round) {
+      for (size_t i = 0; i < sources.size(); ++i) {
+        size_t n = (i + index) % sources.size();
+        if (compile_imports(sources[n], dir, index % 2 ? 2 : 0, nullptr, listings) != expected[n]) ++mismatches;
+      }
+    }
+  });
+  size_t lookups = sass_directory_cache_get_lookups(listings);
+  size_t fs_calls = sass_directory_cache_get_fs_calls(listings);
+  sass_delete_directory_cache(listings);
+  remove_files(dir, files);
+  ASSERT(mismatches == 0);
+  // every directory is read once (unless threads race for it)
+  ASSERT(lookups > 0);
+  ASSERT(fs_calls < lookups / 10);
+  return true;
+}
+
+#define TEST(fn) \
+  if (fn()) { \
+    passed.push_back(#fn); \
+  } else { \
+    failed.push_back(#fn); \
+    std::cerr << "Failed: " #fn << std::endl; \
+  } \
+
+int main(int argc, char **argv) {
+  std::vector<std::string> passed;
+  std::vector<std::string> failed;
+  TEST(TestConcurrentOutputIsDeterministic);
+  TEST(TestConcurrentRandomFunctions);
+  TEST(TestConcurrentCustomFunctions);
+  TEST(TestImportThreadsMatchSequential);
+  TEST(TestStylesheetCacheSharedBetweenThreads);
+  TEST(TestDirectoryCacheSharedBetweenThreads);
+  std::cerr << argv[0] << ": Passed: " << passed.size()
+            << ", failed: " << failed.size()
+            << "." << std::endl;
+  return failed.size();
+}
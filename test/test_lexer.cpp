@@ -0,0 +1,153 @@
+#include "../src/lexer.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace Sass::Prelexer;
+
+#define ASSERT_EQ(a, b) \
+  if ((a) != (b)) { \
+    std::cerr << \
+      "Expected LHS == RHS at " << __FILE__ << ":" << __LINE__ << \
+      "\n  start: " << start << ", match: " << match << \
+      std::endl; \
+    return false; \
+  } \
+
+// Scans like the lexer did before it used SSE2
+const char* slow_first_of(const char* src, char a, char b, char c, char d) {
+  while (*src && *src != a && *src != b && *src != c && *src != d) ++src;
+  return src;
+}
+
+const char* slow_first_not_in(const char* src, char lo, char hi) {
+  while (*src >= lo && *src <= hi) ++src;
+  return src;
+}
+
+// Chunks are aligned to 16 bytes, so every start in the first
+// one and every match up to the third one covers all the edges
+const size_t kStarts = 16;
+const size_t kMatches = 40;
+
+// Returns [size] bytes with a zero tail aligned to 16 bytes
+char* aligned(std::vector<char>& storage, size_t size) {
+  storage.assign(size + 64, '\0');
+  char* base = storage.data();
+  return base + (16 - reinterpret_cast<uintptr_t>(base) % 16) % 16;
+}
+
+bool TestFindFirstOfMatches() {
+  std::vector<char> storage;
+  char* buf = aligned(storage, kStarts + kMatches);
+  for (size_t start = 0; start < kStarts; ++start) {
+    for (size_t match = 0; match < kMatches; ++match) {
+      std::memset(buf, 'x', kStarts + kMatches);
+      buf[kStarts + kMatches] = '\0';
+      // every one of the chars is found
+      for (char c : std::string("{};#")) {
+        buf[start + match] = c;
+        const char* src = buf + start;
+        ASSERT_EQ(find_first_of(src, '{', '}', ';', '#'), slow_first_of(src, '{', '}', ';', '#'));
+        ASSERT_EQ(find_first_of(src, '{', '}', ';', '#'), buf + start + match);
+      }
+      // chars above 127 are no match for plain ones
+      buf[start + match] = '\xC3';
+      const char* src = buf + start;
+      ASSERT_EQ(find_first_of(src, '{', '}', ';', '#'), buf + kStarts + kMatches);
+      // but they can be searched for
+      ASSERT_EQ(find_first_of(src, '\xC3', '\xC3', '\xC3', '\xC3'), buf + start + match);
+    }
+  }
+  return true;
+}
+
+bool TestFindFirstOfStopsAtNull() {
+  std::vector<char> storage;
+  char* buf = aligned(storage, kStarts + kMatches);
+  for (size_t start = 0; start < kStarts; ++start) {
+    for (size_t match = 0; match < kMatches; ++match) {
+      std::memset(buf, 'x', kStarts + kMatches);
+      // the terminating null is the match
+      buf[start + match] = '\0';
+      const char* src = buf + start;
+      ASSERT_EQ(find_first_of(src, '{', '}', ';', '#'), slow_first_of(src, '{', '}', ';', '#'));
+      ASSERT_EQ(find_first_of(src, '{', '}', ';', '#'), buf + start + match);
+      // chars after it are not looked at
+      buf[start + match + 1] = '{';
+      ASSERT_EQ(find_first_of(src, '{', '}', ';', '#'), buf + start + match);
+    }
+  }
+  return true;
+}
+
+bool TestFindFirstNotInMatches() {
+  std::vector<char> storage;
+  char* buf = aligned(storage, kStarts + kMatches);
+  for (size_t start = 0; start < kStarts; ++start) {
+    for (size_t match = 0; match < kMatches; ++match) {
+      // the chars right outside of the range, above 127 and null
+      for (char c : std::string("/:\xC3\x7F", 4) + '\0') {
+        std::memset(buf, '0', kStarts + kMatches);
+        buf[kStarts + kMatches] = '\0';
+        // the ends of the range are inside
+        buf[start] = '9';
+        if (match > 0) buf[start + match - 1] = '0';
+        buf[start + match] = c;
+        const char* src = buf + start;
+        if (match == 0) {
+          ASSERT_EQ(find_first_not_in(src, '0', '9'), slow_first_not_in(src, '0', '9'));
+          ASSERT_EQ(find_first_not_in(src, '0', '9'), src);
+          continue;
+        }
+        ASSERT_EQ(find_first_not_in(src, '0', '9'), slow_first_not_in(src, '0', '9'));
+        ASSERT_EQ(find_first_not_in(src, '0', '9'), buf + start + match);
+      }
+    }
+  }
+  return true;
+}
+
+bool TestFindFirstNotInStopsAtNull() {
+  std::vector<char> storage;
+  char* buf = aligned(storage, kStarts + kMatches);
+  for (size_t start = 0; start < kStarts; ++start) {
+    for (size_t match = 0; match < kMatches; ++match) {
+      // everything but null is inside of the range
+      for (size_t i = 0; i < kStarts + kMatches; ++i) buf[i] = char(1 + i % 126);
+      buf[start + match] = '\0';
+      const char* src = buf + start;
+      ASSERT_EQ(find_first_not_in(src, 1, 126), slow_first_not_in(src, 1, 126));
+      ASSERT_EQ(find_first_not_in(src, 1, 126), buf + start + match);
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+#define TEST(fn) \
+  if (fn()) { \
+    passed.push_back(#fn); \
+  } else { \
+    failed.push_back(#fn); \
+    std::cerr << "Failed: " #fn << std::endl; \
+  } \
+
+int main(int argc, char **argv) {
+  std::vector<std::string> passed;
+  std::vector<std::string> failed;
+  TEST(TestFindFirstOfMatches);
+  TEST(TestFindFirstOfStopsAtNull);
+  TEST(TestFindFirstNotInMatches);
+  TEST(TestFindFirstNotInStopsAtNull);
+  std::cerr << argv[0] << ": Passed: " << passed.size()
+            << ", failed: " << failed.size()
+            << "." << std::endl;
+  return failed.size();
+}
@@ -1,4 +1,5 @@
 #include "../src/util_string.hpp"
+#include "../src/utf8/checked.h"
 
 #include <iostream>
 #include <sstream>
@@ -181,6 +182,84 @@ bool Test_ascii_isspace() {
   return true;
 }
 
+bool Test_ascii_only() {
+  Sass::sass::string str = "0123456789abcdefghij";
+  ASSERT_TRUE(Sass::Util::ascii_only(str.data(), str.data() + str.size()));
+  ASSERT_TRUE(Sass::Util::ascii_only(str.data(), str.data()));
+  str[5] = '\xC3';
+  ASSERT_FALSE(Sass::Util::ascii_only(str.data(), str.data() + str.size()));
+  ASSERT_TRUE(Sass::Util::ascii_only(str.data(), str.data() + 5));
+  str[5] = 'a'; str[18] = '\x80';
+  ASSERT_FALSE(Sass::Util::ascii_only(str.data(), str.data() + str.size()));
+  return true;
+}
+
+bool Test_count_code_points() {
+  // two, three and four byte sequences in and after the first word
+  Sass::sass::string str = "a\xC3\xA4" "b\xE2\x82\xAC" "c\xF0\x9F\x98\x80" "de\xC3\xA4";
+  ASSERT_TRUE((Sass::Util::count_code_points(str.data(), str.data() + str.size()) == 9));
+  ASSERT_TRUE((Sass::Util::count_code_points(str.data(), str.data() + 4) == 3));
+  ASSERT_TRUE((Sass::Util::count_code_points(str.data(), str.data()) == 0));
+  return true;
+}
+
+bool Test_find_invalid_utf8() {
+  const std::vector<Sass::sass::string> inputs = {
+    "", "plain ascii that is longer than sixteen bytes",
+    "0123456789abcdef\xC3\xA4" "0123456789abcdef\xE2\x82\xAC",
+    "0123456789abcde\xC3", "0123456789abcdef\xFF" "0123456789abcdef",
+    "\xF0\x9F\x98\x80" "0123456789abcdef\xED\xA0\x80",
+    "0123456789abcdef0123456789\xC0\xAF" "abcdef"
+  };
+  for (const Sass::sass::string& str : inputs) {
+    const char* beg = str.data();
+    const char* end = beg + str.size();
+    ASSERT_TRUE((Sass::Util::find_invalid_utf8(beg, end) == utf8::find_invalid(beg, end)));
+  }
+  return true;
+}
+
+// Formats like a fixed stream before its zeros are trimmed
+Sass::sass::string stream_fixed(double value, int precision) {
+  std::ostringstream ss;
+  ss.precision(precision);
+  ss << std::fixed << value;
+  Sass::sass::string res = ss.str().c_str();
+  while (res.size() > 1 && res.back() == '0') res.pop_back();
+  if (res.back() == '.') res.pop_back();
+  return res;
+}
+
+bool Test_append_fixed() {
+  const std::vector<double> values = {
+    0, -0.0, 1, -1, 0.5, 1.5, 2.5, -2.5, 0.125, 0.375, 1.005, 0.1, 0.7,
+    3.14159265358979, 1.0 / 3, 2.0 / 3, 99.99999999995, 0.00000000005,
+    1e-20, 12345.678901234, 123456789012345678.0, 1e18, 1e300, -1e-300
+  };
+  for (double value : values) {
+    for (int precision = 0; precision <= 17; ++precision) {
+      Sass::sass::string out("x");
+      Sass::Util::append_fixed(out, value, precision);
+      ASSERT_STR_EQ("x" + stream_fixed(value, precision), out);
+    }
+  }
+  return true;
+}
+
+bool Test_append_base64() {
+  const std::vector<std::pair<std::string, std::string>> cases = {
+    { "", "" }, { "f", "Zg==" }, { "fo", "Zm8=" }, { "foo", "Zm9v" },
+    { "foob", "Zm9vYg==" }, { "fooba", "Zm9vYmE=" }, { "foobar", "Zm9vYmFy" },
+    { std::string("\0\xFF\xFE\x80", 4), "AP/+gA==" }
+  };
+  for (const auto& c : cases) {
+    Sass::sass::string out("x");
+    Sass::Util::append_base64(out, c.first.data(), c.first.size());
+    ASSERT_STR_EQ("x" + c.second, out);
+  }
+  return true;
+}
+
 }  // namespace
 
 #define TEST(fn) \
@@ -210,6 +289,11 @@ int main(int argc, char **argv) {
   TEST(Test_ascii_isalpha);
   TEST(Test_ascii_isxdigit);
   TEST(Test_ascii_isspace);
+  TEST(Test_ascii_only);
+  TEST(Test_count_code_points);
+  TEST(Test_find_invalid_utf8);
+  TEST(Test_append_fixed);
+  TEST(Test_append_base64);
   std::cerr << argv[0] << ": Passed: " << passed.size()
             << ", failed: " << failed.size()
             << "." << std::endl;